@@ -3,9 +3,15 @@ SOURCES += \
     $$PWD/src/cpprofiler/command_line_parser.cpp \
     $$PWD/src/cpprofiler/name_map.cpp \
     $$PWD/src/cpprofiler/tcp_server.cpp \
+    $$PWD/src/cpprofiler/local_server.cpp \
+    $$PWD/src/cpprofiler/solver_listener.cpp \
     $$PWD/src/cpprofiler/receiver_thread.cpp \
     $$PWD/src/cpprofiler/receiver_worker.cpp \
+    $$PWD/src/cpprofiler/frame_buffer.cpp \
+    $$PWD/src/cpprofiler/stream_capture.cpp \
+    $$PWD/src/cpprofiler/replay.cpp \
     $$PWD/src/cpprofiler/conductor.cpp \
+    $$PWD/src/cpprofiler/headless_runner.cpp \
     $$PWD/src/cpprofiler/execution.cpp \
     $$PWD/src/cpprofiler/user_data.cpp \
     $$PWD/src/cpprofiler/tree_builder.cpp \
@@ -15,15 +21,26 @@ SOURCES += \
     $$PWD/src/cpprofiler/utils/string_utils.cpp \
     $$PWD/src/cpprofiler/utils/path_utils.cpp \
     $$PWD/src/cpprofiler/utils/tree_utils.cpp \
+    $$PWD/src/cpprofiler/utils/search_log.cpp \
     $$PWD/src/cpprofiler/utils/perf_helper.cpp \
     $$PWD/src/cpprofiler/utils/array.cpp \
+    $$PWD/src/cpprofiler/utils/pod_vector.cpp \
+    $$PWD/src/cpprofiler/utils/work_stealing_pool.cpp \
+    $$PWD/src/cpprofiler/utils/tiled_image_writer.cpp \
     $$PWD/src/cpprofiler/utils/std_ext.cpp \
     $$PWD/src/cpprofiler/utils/maybe_caller.cpp \
     $$PWD/src/cpprofiler/tree/node.cpp \
+    $$PWD/src/cpprofiler/tree/frozen_structure.cpp \
+    $$PWD/src/cpprofiler/tree/label_pool.cpp \
     $$PWD/src/cpprofiler/tree/structure.cpp \
     $$PWD/src/cpprofiler/tree/layout.cpp \
     $$PWD/src/cpprofiler/tree/layout_computer.cpp \
+    $$PWD/src/cpprofiler/tree/layout_worker.cpp \
     $$PWD/src/cpprofiler/tree/shape.cpp \
+    $$PWD/src/cpprofiler/tree/shape_cache.cpp \
+    $$PWD/src/cpprofiler/tree/spatial_index.cpp \
+    $$PWD/src/cpprofiler/tree/tile_cache.cpp \
+    $$PWD/src/cpprofiler/tree/tree_image.cpp \
     $$PWD/src/cpprofiler/tree/node_tree.cpp \
     $$PWD/src/cpprofiler/tree/node_id.cpp \
     $$PWD/src/cpprofiler/tree/node_info.cpp \
@@ -60,9 +77,15 @@ HEADERS += \
     $$PWD/src/cpprofiler/name_map.hh \
     $$PWD/src/cpprofiler/settings.hh \
     $$PWD/src/cpprofiler/conductor.hh \
+    $$PWD/src/cpprofiler/headless_runner.hh \
     $$PWD/src/cpprofiler/tcp_server.hh \
+    $$PWD/src/cpprofiler/local_server.hh \
+    $$PWD/src/cpprofiler/solver_listener.hh \
     $$PWD/src/cpprofiler/receiver_thread.hh \
     $$PWD/src/cpprofiler/receiver_worker.hh \
+    $$PWD/src/cpprofiler/frame_buffer.hh \
+    $$PWD/src/cpprofiler/stream_capture.hh \
+    $$PWD/src/cpprofiler/replay.hh \
     $$PWD/src/cpprofiler/execution.hh \
     $$PWD/src/cpprofiler/user_data.hh \
     $$PWD/src/cpprofiler/tree_builder.hh \
@@ -72,16 +95,28 @@ HEADERS += \
     $$PWD/src/cpprofiler/utils/string_utils.hh \
     $$PWD/src/cpprofiler/utils/path_utils.hh \
     $$PWD/src/cpprofiler/utils/tree_utils.hh \
+    $$PWD/src/cpprofiler/utils/search_log.hh \
     $$PWD/src/cpprofiler/utils/perf_helper.hh \
     $$PWD/src/cpprofiler/utils/array.hh \
+    $$PWD/src/cpprofiler/utils/pod_vector.hh \
+    $$PWD/src/cpprofiler/utils/work_stealing_pool.hh \
+    $$PWD/src/cpprofiler/utils/tiled_image_writer.hh \
+    $$PWD/src/cpprofiler/utils/stable_vector.hh \
     $$PWD/src/cpprofiler/utils/debug.hh \
     $$PWD/src/cpprofiler/utils/std_ext.hh \
     $$PWD/src/cpprofiler/utils/maybe_caller.hh \
     $$PWD/src/cpprofiler/tree/node.hh \
+    $$PWD/src/cpprofiler/tree/frozen_structure.hh \
+    $$PWD/src/cpprofiler/tree/label_pool.hh \
     $$PWD/src/cpprofiler/tree/structure.hh \
     $$PWD/src/cpprofiler/tree/layout.hh \
     $$PWD/src/cpprofiler/tree/layout_computer.hh \
+    $$PWD/src/cpprofiler/tree/layout_worker.hh \
     $$PWD/src/cpprofiler/tree/shape.hh \
+    $$PWD/src/cpprofiler/tree/shape_cache.hh \
+    $$PWD/src/cpprofiler/tree/spatial_index.hh \
+    $$PWD/src/cpprofiler/tree/tile_cache.hh \
+    $$PWD/src/cpprofiler/tree/tree_image.hh \
     $$PWD/src/cpprofiler/tree/node_tree.hh \
     $$PWD/src/cpprofiler/tree/node_id.hh \
     $$PWD/src/cpprofiler/tree/node_info.hh \
@@ -119,6 +154,7 @@ HEADERS += \
     $$PWD/src/cpprofiler/tree/node_drawing.hh \
     $$PWD/src/cpprofiler/db_handler.hh \
     $$PWD/src/cpprofiler/solver_data.hh \
+    $$PWD/src/cpprofiler/sparse_column.hh \
     $$PWD/src/cpprofiler/nogood_dialog.hh \
     $$PWD/src/cpprofiler/analysis/nogood_analysis_dialog.hh \
     $$PWD/src/cpprofiler/message_wrapper.hh \
@@ -126,7 +162,14 @@ HEADERS += \
 SOURCES += \
     $$PWD/src/cpprofiler/tests/tree_test.cpp \
     $$PWD/src/cpprofiler/tests/execution_test.cpp \
+    $$PWD/src/cpprofiler/tests/benchmarks.cpp \
 
 HEADERS += \
     $$PWD/src/cpprofiler/tests/tree_test.hh \
     $$PWD/src/cpprofiler/tests/execution_test.hh \
+    $$PWD/src/cpprofiler/tests/benchmarks.hh \
+
+# shm_open (shared memory transport) lives in librt on older glibc
+unix:!macx {
+    LIBS += -lrt
+}
@@ -2,11 +2,15 @@
 #define CONNECTOR
 
 #include "message.hpp"
+#include "shm_ring.hpp"
 
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
 
 #ifdef WIN32
 
@@ -23,6 +27,8 @@ typedef SSIZE_T ssize_t;
 
 #include <netdb.h>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #endif
 
@@ -41,6 +47,14 @@ public:
   T& value() { assert(present); return value_; }
 };
 
+/// How nodes get to the profiler
+enum class Transport {
+  DEFAULT,  ///< from CPPROFILER_TRANSPORT ("tcp", "uds" or "shm"), TCP if unset
+  TCP,      ///< loopback TCP on the profiler's port
+  UDS,      ///< Unix domain socket (profiler on the same machine)
+  SHM       ///< shared memory ring, Unix domain socket only as a doorbell
+};
+
 class Connector;
 class Node;
 static void sendNode(Connector& c, Node& node);
@@ -138,33 +152,178 @@ private:
   int sockfd;
   bool _connected;
 
+  Transport _transport{Transport::TCP};
+
+#ifndef WIN32
+  ShmRing _ring;
+#endif
+
+  /// Messages (each preceded by its size) waiting to be sent
+  std::vector<char> _out;
+  /// Number of messages in `_out`
+  int _batched{0};
+
+  /// Send after this many nodes...
+  int _batch_size{256};
+  /// ...or once the oldest buffered node is this old...
+  std::chrono::milliseconds _flush_interval{50};
+  /// ...or once this many bytes are buffered
+  static const size_t MAX_BATCH_BYTES = 1 << 20;
+
+  std::chrono::steady_clock::time_point _batch_start;
+
+  /// Append the current message of `marshalling` to the output buffer
+  void addToBatch() {
+    if (_out.empty()) _batch_start = std::chrono::steady_clock::now();
+
+    const size_t offset = _out.size();
+    _out.resize(offset + sizeof(uint32_t));
+    marshalling.serialize(_out);
+
+    const auto msgSize = static_cast<uint32_t>(_out.size() - offset - sizeof(uint32_t));
+    memcpy(_out.data() + offset, &msgSize, sizeof(uint32_t));
+    ++_batched;
+  }
+
   void sendOverSocket() {
     if (!_connected) return;
 
-    std::vector<char> buf = marshalling.serialize();
+    addToBatch();
+    flush();
+  }
+
+public:
+#ifndef WIN32
+  /// Wake the profiler up after writing to the ring; false if it is gone
+  bool ringDoorbell() {
+    const char bell = 0;
+#ifdef MSG_NOSIGNAL
+    return send(sockfd, &bell, 1, MSG_NOSIGNAL) == 1;
+#else
+    return send(sockfd, &bell, 1, 0) == 1;
+#endif
+  }
+
+  /// Connect to the profiler's local socket; for SHM also create the ring
+  /// and tell the profiler its name
+  bool connectLocal(Transport t) {
+    const std::string path = localSocketPath(port) + (t == Transport::SHM ? ".shm" : "");
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+
+    if ((sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) return false;
+
+    if (::connect(sockfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) == -1) {
+      close(sockfd);
+      return false;
+    }
+
+    if (t == Transport::SHM) {
+      static int ring_count = 0;
+      const std::string name = "/cpprofiler-" + std::to_string(getpid()) +
+                               "-" + std::to_string(ring_count++);
+      if (!_ring.create(name)) {
+        close(sockfd);
+        return false;
+      }
+      std::vector<char> handshake(name.begin(), name.end());
+      sendRawMsg(handshake);
+    }
+
+    return true;
+  }
+#endif
 
-    sendRawMsg(buf);
+  static Transport transportFromEnv() {
+    const char* env = getenv("CPPROFILER_TRANSPORT");
+    if (!env) return Transport::TCP;
+    const std::string value(env);
+    if (value == "uds") return Transport::UDS;
+    if (value == "shm") return Transport::SHM;
+    return Transport::TCP;
   }
 
 public:
-  void sendRawMsg(const std::vector<char>& buf) {
+  /// Path of the Unix domain socket the profiler listening on `port` also
+  /// accepts connections on (overridden by CPPROFILER_SOCKET)
+  static std::string localSocketPath(unsigned int port) {
+    if (const char* path = getenv("CPPROFILER_SOCKET")) return path;
+    const char* tmp = getenv("TMPDIR");
+    std::string dir = tmp && *tmp ? tmp : "/tmp";
+    if (dir.back() == '/') dir.pop_back();
+    return dir + "/cpprofiler-" + std::to_string(port);
+  }
+
+  Transport transport() const { return _transport; }
+
+  /// Send all buffered messages with a single write
+  void flush() {
+    if (_out.empty()) return;
+
+#ifndef WIN32
+    if (_transport == Transport::SHM && _ring.valid()) {
+      _ring.write(_out.data(), _out.size(), [this]() { return ringDoorbell(); });
+    } else
+#endif
+    {
+      int len = static_cast<int>(_out.size());
+      sendall(sockfd, _out.data(), &len);
+    }
+    _out.clear();
+    _batched = 0;
+  }
+
+  /// Send an already serialized message; with `flush_now` unset it is only
+  /// buffered until the next flush
+  void sendRawMsg(const std::vector<char>& buf, bool flush_now = true) {
     uint32_t bufSize = static_cast<uint32_t>(buf.size());
-    int bufSizeLen = sizeof(uint32_t);
-    sendall(sockfd, reinterpret_cast<char*>(&bufSize), &bufSizeLen);
-    int bufSizeInt = static_cast<int>(bufSize);
-    sendall(sockfd, reinterpret_cast<const char*>(buf.data()), &bufSizeInt);
+    const char* sizeBytes = reinterpret_cast<const char*>(&bufSize);
+    _out.insert(_out.end(), sizeBytes, sizeBytes + sizeof(uint32_t));
+    _out.insert(_out.end(), buf.begin(), buf.end());
+    if (flush_now || _out.size() >= MAX_BATCH_BYTES) flush();
   }
 
-  Connector(unsigned int port) : port(port), _connected(false) {}
+  /// Number of nodes sent together (1 sends every node immediately)
+  void set_batch_size(int nodes) { _batch_size = nodes < 1 ? 1 : nodes; }
+  int batch_size() const { return _batch_size; }
+
+  /// Longest time (in ms) a node may wait in the buffer, checked whenever
+  /// another node is sent
+  void set_flush_interval(int ms) { _flush_interval = std::chrono::milliseconds(ms); }
+
+  /// `protocol_version` can be set to 3 for profilers that don't
+  /// understand compact (version 4) node messages
+  Connector(unsigned int port, int protocol_version = PROFILER_PROTOCOL_VERSION)
+    : port(port), _connected(false) {
+    marshalling.set_protocol_version(protocol_version);
+  }
 
   bool connected() { return _connected; }
 
   /// connect to a socket via port specified in the construction (6565 by
-  /// default)
-  void connect() {
+  /// default); local transports fall back to TCP if they can't be used
+  void connect(Transport t = Transport::DEFAULT) {
     struct addrinfo hints, *servinfo, *p;
     int rv;
 
+    if (t == Transport::DEFAULT) t = transportFromEnv();
+
+#ifndef WIN32
+    if (t == Transport::UDS || t == Transport::SHM) {
+      if (connectLocal(t)) {
+        _transport = t;
+        _connected = true;
+        return;
+      }
+      std::cerr << "cpprofiler: local transport unavailable, using TCP\n";
+    }
+#endif
+    _transport = Transport::TCP;
+
 #ifdef WIN32
     // Initialise Winsock.
     WSADATA wsaData;
@@ -271,10 +430,19 @@ giveup:
 
   /// disconnect from a socket
   void disconnect() {
+    if (_connected) flush();
 #ifdef WIN32
     closesocket(sockfd);
 #else
+    if (_ring.valid()) {
+      // give the profiler a chance to take everything out of the ring
+      // before its name goes away
+      for (int i = 0; i < 2000 && !_ring.drained(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
     close(sockfd);
+    _ring.close();
 #endif
   }
 
@@ -288,7 +456,12 @@ giveup:
     if (node.nogood().valid()) msg.set_nogood(node.nogood().value());
     if (node.info().valid()) msg.set_info(node.info().value());
 
-    sendOverSocket();
+    addToBatch();
+
+    if (_batched >= _batch_size || _out.size() >= MAX_BATCH_BYTES ||
+        std::chrono::steady_clock::now() - _batch_start >= _flush_interval) {
+      flush();
+    }
   }
 
   Node createNode(NodeUID node, NodeUID parent,
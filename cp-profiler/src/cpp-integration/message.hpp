@@ -5,10 +5,15 @@
 #include <string>
 #include <cassert>
 #include <cstdint>
+#include <unordered_map>
 
 namespace cpprofiler {
 
-static const int32_t PROFILER_PROTOCOL_VERSION = 3;
+static const int32_t PROFILER_PROTOCOL_VERSION = 4;
+
+// Version assumed when the start message doesn't specify one; version 3
+// node messages use fixed size big-endian integers and plain labels
+static const int32_t PROFILER_PROTOCOL_VERSION_V3 = 3;
 
 enum NodeStatus {
   SOLVED = 0,        ///< Node representing a solution
@@ -92,6 +97,22 @@ public:
     _nogood = nogood;
   }
 
+  // in-place access used when deserializing, reuses the string's storage
+  std::string& mutable_label() {
+    _have_label = true;
+    return _label;
+  }
+
+  std::string& mutable_info() {
+    _have_info = true;
+    return _info;
+  }
+
+  std::string& mutable_nogood() {
+    _have_nogood = true;
+    return _nogood;
+  }
+
   void set_version(int32_t v) {
     _have_version = true;
     _version = v;
@@ -133,9 +154,59 @@ private:
     VERSION = 3
   };
 
+  /// Flags preceding the body of a version 4 node message
+  enum NodeFlags {
+    LABEL_REF = 1,     // label sent before, followed by its dictionary id
+    LABEL_DEF = 2,     // new label, followed by the string (gets the next id)
+    LABEL_LIT = 4,     // label not added to the dictionary (dictionary full)
+    HAS_NOGOOD = 8,
+    HAS_INFO = 16,
+    NODE_IDS = 32,     // node's rid/tid differ from the previous node's
+    PARENT_IDS = 64    // parent's rid/tid differ from the node's
+  };
+
+  /// Limits how much memory the label dictionary takes on either side
+  static const size_t MAX_LABEL_DICT = 1 << 16;
+
   Message msg;
 
-  typedef char* iter;
+  /// Protocol version used for node messages; set by the start message
+  int32_t _version{PROFILER_PROTOCOL_VERSION};
+
+  /// Version 4 state, reset by every start message:
+  /// the last node sent/received (integers are delta-encoded against it)
+  NodeUID _prev{0, 0, 0};
+  /// label -> id (sending side)
+  std::unordered_map<std::string, int32_t> _label_ids;
+  /// id -> label (receiving side)
+  std::vector<std::string> _labels;
+
+  typedef const char* iter;
+
+  static uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+  }
+
+  static int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+  }
+
+  static void serializeVarint(std::vector<char>& data, uint64_t v) {
+    while (v >= 0x80) {
+      data.push_back(static_cast<char>((v & 0x7F) | 0x80));
+      v >>= 7;
+    }
+    data.push_back(static_cast<char>(v));
+  }
+
+  static void serializeVarint(std::vector<char>& data, int64_t v) {
+    serializeVarint(data, zigzag(v));
+  }
+
+  static void serializeVarString(std::vector<char>& data, const std::string& s) {
+    serializeVarint(data, static_cast<uint64_t>(s.size()));
+    data.insert(data.end(), s.begin(), s.end());
+  }
 
   static void serializeType(std::vector<char>& data, MsgType f) {
     data.push_back(static_cast<char>(f));
@@ -176,10 +247,10 @@ private:
   }
 
   static int32_t deserializeInt(iter& it) {
-    auto b1 = static_cast<uint32_t>(reinterpret_cast<uint8_t&>(*it++));
-    auto b2 = static_cast<uint32_t>(reinterpret_cast<uint8_t&>(*it++));
-    auto b3 = static_cast<uint32_t>(reinterpret_cast<uint8_t&>(*it++));
-    auto b4 = static_cast<uint32_t>(reinterpret_cast<uint8_t&>(*it++));
+    auto b1 = static_cast<uint32_t>(static_cast<uint8_t>(*it++));
+    auto b2 = static_cast<uint32_t>(static_cast<uint8_t>(*it++));
+    auto b3 = static_cast<uint32_t>(static_cast<uint8_t>(*it++));
+    auto b4 = static_cast<uint32_t>(static_cast<uint8_t>(*it++));
 
     return static_cast<int32_t>(b1 << 24 | b2 << 16 | b3 << 8 | b4);
   }
@@ -190,15 +261,129 @@ private:
     return f;
   }
 
-  static std::string deserializeString(iter& it) {
-    std::string result;
+  static void deserializeString(iter& it, std::string& result) {
     int32_t size = deserializeInt(it);
-    result.reserve(static_cast<size_t>(size));
-    for (int32_t i = 0; i < size; i++) {
-      result += *it;
-      ++it;
+    result.assign(it, static_cast<size_t>(size));
+    it += size;
+  }
+
+  static uint64_t deserializeVarint(iter& it, iter end) {
+    uint64_t v = 0;
+    for (int shift = 0; it != end && shift < 64; shift += 7) {
+      auto b = static_cast<uint8_t>(*it++);
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+    }
+    return v;
+  }
+
+  static int32_t deserializeSigned(iter& it, iter end) {
+    return static_cast<int32_t>(unzigzag(deserializeVarint(it, end)));
+  }
+
+  static void deserializeVarString(iter& it, iter end, std::string& result) {
+    auto size = static_cast<size_t>(deserializeVarint(it, end));
+    if (size > static_cast<size_t>(end - it)) size = static_cast<size_t>(end - it);
+    result.assign(it, size);
+    it += size;
+  }
+
+  void resetState(int32_t version) {
+    _version = version;
+    _prev = {0, 0, 0};
+    _label_ids.clear();
+    _labels.clear();
+  }
+
+  void serializeNodeV4(std::vector<char>& data) {
+    const NodeUID n = msg.nodeUID();
+    const NodeUID p = msg.parentUID();
+
+    int flags = 0;
+    int32_t label_id = -1;
+
+    if (msg.has_label()) {
+      auto it = _label_ids.find(msg.label());
+      if (it != _label_ids.end()) {
+        flags |= LABEL_REF;
+        label_id = it->second;
+      } else if (_label_ids.size() < MAX_LABEL_DICT) {
+        flags |= LABEL_DEF;
+        _label_ids.emplace(msg.label(), static_cast<int32_t>(_label_ids.size()));
+      } else {
+        flags |= LABEL_LIT;
+      }
+    }
+    if (msg.has_nogood()) flags |= HAS_NOGOOD;
+    if (msg.has_info()) flags |= HAS_INFO;
+    if (n.rid != _prev.rid || n.tid != _prev.tid) flags |= NODE_IDS;
+    if (p.rid != n.rid || p.tid != n.tid) flags |= PARENT_IDS;
+
+    data.push_back(static_cast<char>(flags));
+
+    serializeVarint(data, static_cast<int64_t>(n.nid) - _prev.nid);
+    serializeVarint(data, static_cast<int64_t>(n.nid) - p.nid);
+    if (flags & NODE_IDS) {
+      serializeVarint(data, static_cast<int64_t>(n.rid));
+      serializeVarint(data, static_cast<int64_t>(n.tid));
     }
-    return result;
+    if (flags & PARENT_IDS) {
+      serializeVarint(data, static_cast<int64_t>(p.rid));
+      serializeVarint(data, static_cast<int64_t>(p.tid));
+    }
+    serializeVarint(data, static_cast<int64_t>(msg.alt()));
+    serializeVarint(data, static_cast<int64_t>(msg.kids()));
+    serialize(data, msg.status());
+
+    if (flags & LABEL_REF) serializeVarint(data, static_cast<uint64_t>(label_id));
+    if (flags & (LABEL_DEF | LABEL_LIT)) serializeVarString(data, msg.label());
+    if (flags & HAS_NOGOOD) serializeVarString(data, msg.nogood());
+    if (flags & HAS_INFO) serializeVarString(data, msg.info());
+
+    _prev = n;
+  }
+
+  void deserializeNodeV4(iter data, iter end) {
+    msg.reset();
+    if (data == end) return;
+
+    const int flags = static_cast<uint8_t>(*data++);
+
+    NodeUID n;
+    n.nid = static_cast<int32_t>(_prev.nid + unzigzag(deserializeVarint(data, end)));
+    const int32_t pid = static_cast<int32_t>(n.nid - unzigzag(deserializeVarint(data, end)));
+    if (flags & NODE_IDS) {
+      n.rid = deserializeSigned(data, end);
+      n.tid = deserializeSigned(data, end);
+    } else {
+      n.rid = _prev.rid;
+      n.tid = _prev.tid;
+    }
+    NodeUID p{pid, n.rid, n.tid};
+    if (flags & PARENT_IDS) {
+      p.rid = deserializeSigned(data, end);
+      p.tid = deserializeSigned(data, end);
+    }
+
+    msg.set_nodeUID(n);
+    msg.set_parentUID(p);
+    msg.set_alt(deserializeSigned(data, end));
+    msg.set_kids(deserializeSigned(data, end));
+    msg.set_status(data != end ? deserializeStatus(data) : BRANCH);
+
+    if (flags & LABEL_REF) {
+      auto id = deserializeVarint(data, end);
+      if (id < _labels.size()) msg.mutable_label() = _labels[id];
+    } else if (flags & (LABEL_DEF | LABEL_LIT)) {
+      deserializeVarString(data, end, msg.mutable_label());
+      if ((flags & LABEL_DEF) && _labels.size() < MAX_LABEL_DICT) {
+        _labels.push_back(msg.label());
+      }
+    }
+    if (flags & HAS_NOGOOD) deserializeVarString(data, end, msg.mutable_nogood());
+    if (flags & HAS_INFO) deserializeVarString(data, end, msg.mutable_info());
+
+    _prev = n;
   }
 
 public:
@@ -217,10 +402,14 @@ public:
     return msg;
   }
 
+  /// Version to announce in the next start message (sending side)
+  void set_protocol_version(int32_t version) { _version = version; }
+  int32_t protocol_version(void) const { return _version; }
+
   void makeStart(const std::string& info) {
     msg.reset();
     msg.set_type(MsgType::START);
-    msg.set_version(PROFILER_PROTOCOL_VERSION);
+    msg.set_version(_version);
     msg.set_info(info); /// info containts name, has_restarts, execution id
   }
 
@@ -237,13 +426,31 @@ public:
 
   const Message& get_msg(void) { return msg; }
 
-  std::vector<char> serialize(void) const {
+  // Not const: version 4 node messages depend on (and update) the
+  // delta/dictionary state
+  std::vector<char> serialize(void) {
     std::vector<char> data;
+    serialize(data);
+    return data;
+  }
+
+  // Append the current message to `data` (lets the caller reuse a buffer)
+  void serialize(std::vector<char>& data) {
+    if (msg.isStart()) {
+      resetState(msg.has_version() ? msg.version() : PROFILER_PROTOCOL_VERSION_V3);
+    }
+
+    if (msg.isNode() && _version >= 4) {
+      serializeType(data, msg.type());
+      serializeNodeV4(data);
+      return;
+    }
+
     size_t dataSize = 1 + (msg.isNode() ? 4 * 8 + 1 : 0) +
         (msg.has_label() ? 1 + 4 + msg.label().size() : 0) +
         (msg.has_nogood() ? 1 + 4 + msg.nogood().size() : 0) +
         (msg.has_info() ? 1 + 4 + msg.info().size() : 0);
-    data.reserve(dataSize);
+    data.reserve(data.size() + dataSize);
 
     serializeType(data, msg.type());
     if (msg.isNode()) {
@@ -279,12 +486,16 @@ public:
       serializeField(data, INFO);
       serialize(data, msg.info());
     }
-    return data;
   }
 
-  void deserialize(char* data, size_t size) {
-    char *end = data + size;
+  // `data` is only read from, so it can point straight into a receive buffer
+  void deserialize(const char* data, size_t size) {
+    const char *end = data + size;
     msg.set_type(deserializeMsgType(data));
+    if (msg.isNode() && _version >= 4) {
+      deserializeNodeV4(data, end);
+      return;
+    }
     if (msg.isNode()) {
       int32_t nid = deserializeInt(data);
       int32_t rid = deserializeInt(data);
@@ -311,15 +522,20 @@ public:
       case VERSION:
         msg.set_version(deserializeInt(data)); break;
       case LABEL:
-        msg.set_label(deserializeString(data)); break;
+        deserializeString(data, msg.mutable_label()); break;
       case NOGOOD:
-        msg.set_nogood(deserializeString(data)); break;
+        deserializeString(data, msg.mutable_nogood()); break;
       case INFO:
-        msg.set_info(deserializeString(data)); break;
+        deserializeString(data, msg.mutable_info()); break;
       default:
         break;
       }
     }
+
+    // the start message decides how the following nodes are encoded
+    if (msg.isStart()) {
+      resetState(msg.has_version() ? msg.version() : PROFILER_PROTOCOL_VERSION_V3);
+    }
   }
 };
 
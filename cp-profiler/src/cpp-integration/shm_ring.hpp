@@ -0,0 +1,205 @@
+#ifndef SHM_RING_HH
+#define SHM_RING_HH
+
+#ifndef WIN32
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cpprofiler {
+
+// Control block at the start of the shared memory segment. Positions only
+// ever grow; the byte at position p is stored at data[p % capacity].
+struct ShmRingHeader {
+  uint32_t magic;
+  uint32_t capacity;
+  // bytes consumed so far (written by the profiler only)
+  alignas(64) std::atomic<uint64_t> head;
+  // bytes produced so far (written by the solver only)
+  alignas(64) std::atomic<uint64_t> tail;
+  // set by the profiler before it goes to sleep waiting for the doorbell
+  alignas(64) std::atomic<uint32_t> consumer_waiting;
+};
+
+static const uint32_t SHM_RING_MAGIC = 0x43505052;
+static const uint32_t SHM_RING_DEFAULT_CAPACITY = 1 << 22;
+
+// Single-producer/single-consumer byte ring in POSIX shared memory.
+//
+// The solver creates the ring and writes into it, the profiler opens it by
+// name and reads from it. The ring itself has no way to wake the reader up:
+// the writer is given a "doorbell" callback, which it only calls when the
+// reader announced (prepareWait) that it is about to sleep.
+class ShmRing {
+  ShmRingHeader* _header{nullptr};
+  char* _data{nullptr};
+  size_t _mapped{0};
+  std::string _name;
+  bool _created{false};
+
+  bool map(int fd, size_t size) {
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return false;
+    _mapped = size;
+    _header = static_cast<ShmRingHeader*>(mem);
+    _data = static_cast<char*>(mem) + sizeof(ShmRingHeader);
+    return true;
+  }
+
+public:
+  ShmRing() = default;
+  ShmRing(const ShmRing&) = delete;
+  ShmRing& operator=(const ShmRing&) = delete;
+  ~ShmRing() { close(); }
+
+  bool valid() const { return _header != nullptr; }
+  const std::string& name() const { return _name; }
+
+  // Producer: create a new segment (`name` must start with '/')
+  bool create(const std::string& name,
+              uint32_t capacity = SHM_RING_DEFAULT_CAPACITY) {
+    close();
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) return false;
+    const size_t size = sizeof(ShmRingHeader) + capacity;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || !map(fd, size)) {
+      shm_unlink(name.c_str());
+      return false;
+    }
+    // the segment is zero-filled, which is a valid state for the atomics
+    _header->capacity = capacity;
+    _header->magic = SHM_RING_MAGIC;
+    _name = name;
+    _created = true;
+    return true;
+  }
+
+  // Consumer: attach to a segment created by the producer
+  bool open(const std::string& name) {
+    close();
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd == -1) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader) ||
+        !map(fd, static_cast<size_t>(st.st_size))) {
+      return false;
+    }
+    if (_header->magic != SHM_RING_MAGIC ||
+        sizeof(ShmRingHeader) + _header->capacity > _mapped) {
+      close();
+      return false;
+    }
+    _name = name;
+    return true;
+  }
+
+  // Remove the name (the memory stays mapped until both sides close it)
+  void unlink() {
+    if (!_name.empty()) shm_unlink(_name.c_str());
+  }
+
+  void close() {
+    if (_header) munmap(_header, _mapped);
+    if (_created) unlink();
+    _header = nullptr;
+    _data = nullptr;
+    _mapped = 0;
+    _created = false;
+    _name.clear();
+  }
+
+  // Producer: append `len` bytes, waiting for space if the ring is full.
+  // `doorbell` wakes the consumer up and returns false if it is gone,
+  // in which case the remaining bytes are dropped.
+  template <typename Doorbell>
+  bool write(const char* buf, size_t len, Doorbell doorbell) {
+    const uint64_t capacity = _header->capacity;
+    auto waiting_since = std::chrono::steady_clock::now();
+
+    while (len > 0) {
+      const uint64_t tail = _header->tail.load(std::memory_order_relaxed);
+      const uint64_t head = _header->head.load(std::memory_order_acquire);
+      const uint64_t space = capacity - (tail - head);
+
+      if (space == 0) {
+        // the consumer should be draining; nudge it now and then in case
+        // it isn't (this also notices a consumer that went away)
+        if (std::chrono::steady_clock::now() - waiting_since >
+            std::chrono::milliseconds(100)) {
+          if (!doorbell()) return false;
+          waiting_since = std::chrono::steady_clock::now();
+        }
+        std::this_thread::yield();
+        continue;
+      }
+
+      const size_t n = static_cast<size_t>(space < len ? space : len);
+      const size_t offset = static_cast<size_t>(tail % capacity);
+      const size_t first = n < capacity - offset ? n : capacity - offset;
+      memcpy(_data + offset, buf, first);
+      memcpy(_data, buf + first, n - first);
+
+      _header->tail.store(tail + n, std::memory_order_seq_cst);
+      buf += n;
+      len -= n;
+      waiting_since = std::chrono::steady_clock::now();
+
+      if (_header->consumer_waiting.exchange(0, std::memory_order_seq_cst)) {
+        if (!doorbell()) return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether the consumer has read everything written so far
+  bool drained() const {
+    return _header->head.load(std::memory_order_acquire) ==
+           _header->tail.load(std::memory_order_relaxed);
+  }
+
+  // Consumer: take up to `max` bytes; returns the number of bytes read
+  size_t read(char* dest, size_t max) {
+    const uint64_t capacity = _header->capacity;
+    const uint64_t head = _header->head.load(std::memory_order_relaxed);
+    const uint64_t tail = _header->tail.load(std::memory_order_seq_cst);
+
+    const uint64_t available = tail - head;
+    const size_t n = static_cast<size_t>(available < max ? available : max);
+    const size_t offset = static_cast<size_t>(head % capacity);
+    const size_t first = n < capacity - offset ? n : capacity - offset;
+    memcpy(dest, _data + offset, first);
+    memcpy(dest + first, _data, n - first);
+
+    _header->head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer: announce going to sleep until the doorbell rings. Returns
+  // false if more data arrived in the meantime (keep reading instead).
+  bool prepareWait() {
+    _header->consumer_waiting.store(1, std::memory_order_seq_cst);
+    if (_header->tail.load(std::memory_order_seq_cst) !=
+        _header->head.load(std::memory_order_relaxed)) {
+      _header->consumer_waiting.store(0, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+};
+
+}
+
+#endif // WIN32
+
+#endif  // SHM_RING_HH
@@ -306,8 +306,8 @@ class ResultBuilder
 
     /// Account for search reduction of one 1-n pentagon
     void addPentagonData(
-        const std::vector<NogoodID> &nogoods, // responsible nogoods
-        int red)                              // node reduction (n-1)
+        const SparseColumn<NogoodID>::View &nogoods, // responsible nogoods
+        int red)                                     // node reduction (n-1)
     {
         /// reduction attributed to each nogood
         const auto rel_red = std::ceil((float)red / nogoods.size());
@@ -376,11 +376,11 @@ void MergeWindow::runNogoodAnalysis() const
         const auto orig_id = orig_locations_[kid].nid;
 
         /// get contributing nogoods:
-        const auto *nogoods = ng_tree.solver_data().getContribNogoods(orig_id);
+        const auto nogoods = ng_tree.solver_data().getContribNogoods(orig_id);
 
-        if (nogoods)
+        if (!nogoods.empty())
         {
-            res_builder.addPentagonData(*nogoods, std::abs(item.size_r - item.size_l));
+            res_builder.addPentagonData(nogoods, std::abs(item.size_r - item.size_l));
         }
         else
         {
@@ -395,10 +395,8 @@ void MergeWindow::runNogoodAnalysis() const
     for (auto item : res_builder.result())
     {
         const NogoodID id = item.first;
-        const auto &ng_str = ng_tree.getNogood(id);
-        const auto *reasons_ptr = ng_tree.solver_data().getContribConstraints(id);
-
-        std::vector<int> reasons = reasons_ptr ? *reasons_ptr : std::vector<int>{};
+        const auto ng_str = ng_tree.getNogood(id);
+        auto reasons = ng_tree.solver_data().getContribConstraints(id).toVector();
 
         nga_data.push_back({id, ng_str, item.second.total_red, item.second.count, std::move(reasons)});
     }
@@ -24,7 +24,7 @@ namespace analysis
 struct NgAnalysisItem
 {
     NogoodID nid;                    /// node id of the nogood
-    const Nogood &ng;                /// textual representation of the nogood
+    Nogood ng;                       /// textual representation of the nogood
     int total_red;                   /// total reduction by this nogood
     int count;                       /// number of times the nogood found in a 1-n pentagon
     std::vector<int> constraint_ids; /// reasons for the nogood
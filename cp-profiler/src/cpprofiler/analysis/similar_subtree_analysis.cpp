@@ -41,15 +41,19 @@ struct CompareShapes
         if (s1.height() > s2.height())
             return false;
 
-        for (int i = 0; i < s1.height(); ++i)
+        Shape::Cursor c1(s1);
+        Shape::Cursor c2(s2);
+        for (int i = 0; i < s1.height(); ++i, ++c1, ++c2)
         {
-            if (s1[i].l < s2[i].l)
+            const auto e1 = *c1;
+            const auto e2 = *c2;
+            if (e1.l < e2.l)
                 return false;
-            if (s1[i].l > s2[i].l)
+            if (e1.l > e2.l)
                 return true;
-            if (s1[i].r < s2[i].r)
+            if (e1.r < e2.r)
                 return true;
-            if (s1[i].r > s2[i].r)
+            if (e1.r > e2.r)
                 return false;
         }
         return false;
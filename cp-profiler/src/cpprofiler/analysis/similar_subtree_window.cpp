@@ -453,10 +453,9 @@ static std::vector<Label> labelPath(NodeID nid, const tree::NodeTree &tree)
     std::vector<Label> label_path;
     while (nid != NodeID::NoNode)
     {
-        auto label = tree.getLabel(nid);
-        if (label != emptyLabel)
+        if (tree.getLabelID(nid) != tree::LabelPool::EMPTY)
         {
-            label_path.push_back(label);
+            label_path.push_back(tree.getLabel(nid));
         }
         nid = tree.getParent(nid);
     }
@@ -7,6 +7,7 @@
 #include "../utils/tree_utils.hh"
 
 #include <QStack>
+#include <limits>
 
 namespace cpprofiler
 {
@@ -45,7 +46,9 @@ static void find_and_replace_all(std::string &str, std::string substr_old, std::
     }
 }
 
-static bool labelsEqual(std::string lhs, std::string rhs)
+/// Bring a label to a form in which labels produced by different solvers
+/// for the same decision compare equal
+static std::string normalizeLabel(std::string label)
 {
     /// NOTE(maxim): removes whitespaces before comparing;
     /// this will be necessary as long as Chuffed and Gecode don't agree
@@ -53,35 +56,66 @@ static bool labelsEqual(std::string lhs, std::string rhs)
     /// for parsing logbrancher while Chuffed uses them as a delimiter
     /// between literals)
 
-    if (lhs.substr(0, 3) == "[i]" || lhs.substr(0, 3) == "[f]")
+    if (label.substr(0, 3) == "[i]" || label.substr(0, 3) == "[f]")
     {
-        lhs = lhs.substr(3);
+        label = label.substr(3);
     }
 
-    if (rhs.substr(0, 3) == "[i]" || rhs.substr(0, 3) == "[f]")
+    label.erase(remove_if(label.begin(), label.end(), isspace), label.end());
+
+    find_and_replace_all(label, "==", "=");
+
+    return label;
+}
+
+/// Compares labels of two trees by id: each distinct label of either tree
+/// is normalized only once and interned into a pool shared by both trees
+class LabelMatcher
+{
+    static constexpr LabelID UNKNOWN = std::numeric_limits<LabelID>::max();
+
+    const NodeTree &nt1_;
+    const NodeTree &nt2_;
+
+    /// Normalized labels of both trees
+    LabelPool normalized_;
+
+    /// Normalized label id for every label id of the corresponding tree
+    std::vector<LabelID> cache1_;
+    std::vector<LabelID> cache2_;
+
+    LabelID normalizedID(const NodeTree &nt, NodeID nid, std::vector<LabelID> &cache)
     {
-        rhs = rhs.substr(3);
-    }
+        const auto id = nt.getLabelID(nid);
+
+        if (id >= cache.size())
+        {
+            cache.resize(nt.labelPool().size(), UNKNOWN);
+        }
 
-    lhs.erase(remove_if(lhs.begin(), lhs.end(), isspace), lhs.end());
-    rhs.erase(remove_if(rhs.begin(), rhs.end(), isspace), rhs.end());
+        if (cache[id] == UNKNOWN)
+        {
+            cache[id] = normalized_.intern(normalizeLabel(nt.getLabel(nid)));
+        }
 
-    find_and_replace_all(lhs, "==", "=");
-    find_and_replace_all(rhs, "==", "=");
+        return cache[id];
+    }
 
-    // qDebug() << "comparing: " << lhs.c_str() << " " << rhs.c_str();
+  public:
+    LabelMatcher(const NodeTree &nt1, const NodeTree &nt2) : nt1_(nt1), nt2_(nt2) {}
 
-    if (lhs.compare(rhs) != 0)
+    bool equal(NodeID n1, NodeID n2)
     {
-        return false;
+        return normalizedID(nt1_, n1, cache1_) == normalizedID(nt2_, n2, cache2_);
     }
+};
 
-    return true;
-}
+constexpr LabelID LabelMatcher::UNKNOWN;
 
+/// Labels are only compared if `labels` is provided
 static bool compareNodes(NodeID n1, const NodeTree &nt1,
                          NodeID n2, const NodeTree &nt2,
-                         bool with_labels)
+                         LabelMatcher *labels)
 {
 
     if (n1 == NodeID::NoNode || n2 == NodeID::NoNode)
@@ -90,13 +124,8 @@ static bool compareNodes(NodeID n1, const NodeTree &nt1,
     if (nt1.getStatus(n1) != nt2.getStatus(n2))
         return false;
 
-    if (with_labels)
-    {
-        const auto &label1 = nt1.getLabel(n1);
-        const auto &label2 = nt2.getLabel(n2);
-        if (!labelsEqual(label1, label2))
-            return false;
-    }
+    if (labels && !labels->equal(n1, n2))
+        return false;
 
     return true;
 }
@@ -118,7 +147,6 @@ static void copy_tree_into(NodeTree &nt, NodeID nid, const NodeTree &nt_s, NodeI
         auto kids = nt_s.childrenCount(node_s);
         auto status = nt_s.getStatus(node_s);
 
-        /// TODO: make sure only the reference to a label is stored
         auto label = nt_s.getLabel(node_s);
 
         nt.promoteNode(node, kids, status, label);
@@ -182,7 +210,7 @@ void TreeMerger::run()
         auto node_r = stack_r.pop();
         auto target = stack.pop();
 
-        bool equal = compareNodes(node_l, tree_l, node_r, tree_r, false);
+        bool equal = compareNodes(node_l, tree_l, node_r, tree_r, nullptr);
 
         if (equal)
         {
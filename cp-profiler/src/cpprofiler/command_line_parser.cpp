@@ -10,8 +10,19 @@ QCommandLineOption paths{"paths", "Use symbol table from: <file_name>.", "file_n
 QCommandLineOption mzn{"mzn", "Use MiniZinc file for tying ids to expressions: <file_name>.", "file_name"};
 QCommandLineOption save_search{"save_search", "Process one execution and save its search to <file_name>; terminate afterwards.", "file_name"};
 QCommandLineOption save_execution{"save_execution", "Process one execution and save it a database named <file_name>; terminate afterwards.", "file_name"};
-QCommandLineOption save_pixel_tree{"save_pixel_tree", "Process one execution and save it a database named <file_name>; terminate afterwards.", "file_name"};
+QCommandLineOption save_pixel_tree{"save_pixel_tree", "Save the pixel tree of the execution as the image <file_name>; large trees are split into several images (<file_name> with -r<row>-c<column> added).", "file_name"};
 QCommandLineOption pixel_tree_compression{"pixel_tree_compression", "What compression factor to use for saved pixel tree. Default: 2", "2"};
+QCommandLineOption save_tree_image{"save_tree_image", "Headless: save the traditional view of the tree as the image <file_name>; large trees are split into several images (<file_name> with -r<row>-c<column> added).", "file_name"};
+QCommandLineOption tree_image_scale{"tree_image_scale", "Draw the image saved with --save_tree_image at <factor> times the default size. Default: 1", "factor"};
+QCommandLineOption record{"record", "Record everything received from solvers into the capture file <file_name> (e.g. trace.cpplog).", "file_name"};
+QCommandLineOption replay{"replay", "Build the tree from the capture file <file_name>, report ingest statistics and terminate.", "file_name"};
+QCommandLineOption replay_speed{"replay_speed", "Replay at <factor> times the recorded speed; 0 (default) replays as fast as possible.", "factor"};
+QCommandLineOption headless{"headless", "Run without a GUI: build every execution, save the requested artefacts (numbered if there are several) and terminate once idle."};
+QCommandLineOption max_executions{"max_executions", "Headless: terminate after <n> executions.", "n"};
+QCommandLineOption idle_timeout{"idle_timeout", "Headless: terminate after <seconds> without solvers connected; 0 waits forever. Default: 10", "seconds"};
+QCommandLineOption node_store{"node_store", "Keep tree structure, node statuses and labels in memory-mapped files in <dir>, so that trees larger than RAM can be built (the files are deleted on exit).", "dir"};
+QCommandLineOption layout_threads{"layout_threads", "Lay out large finished trees using <n> threads; 1 disables parallel layout. Default: one per core.", "n"};
+QCommandLineOption memory_budget{"memory_budget", "Limit each execution to about <MB> megabytes: node info and then labels are dropped as the limit approaches, and further nodes are ignored once it is reached.", "MB"};
 } // namespace cl_options
 
 CommandLineParser::CommandLineParser()
@@ -24,6 +35,17 @@ CommandLineParser::CommandLineParser()
     cl_parser.addOption(cl_options::save_execution);
     cl_parser.addOption(cl_options::save_pixel_tree);
     cl_parser.addOption(cl_options::pixel_tree_compression);
+    cl_parser.addOption(cl_options::save_tree_image);
+    cl_parser.addOption(cl_options::tree_image_scale);
+    cl_parser.addOption(cl_options::record);
+    cl_parser.addOption(cl_options::replay);
+    cl_parser.addOption(cl_options::replay_speed);
+    cl_parser.addOption(cl_options::headless);
+    cl_parser.addOption(cl_options::max_executions);
+    cl_parser.addOption(cl_options::idle_timeout);
+    cl_parser.addOption(cl_options::memory_budget);
+    cl_parser.addOption(cl_options::node_store);
+    cl_parser.addOption(cl_options::layout_threads);
 }
 
 void CommandLineParser::process(const QCoreApplication &app)
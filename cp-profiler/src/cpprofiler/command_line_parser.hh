@@ -14,6 +14,17 @@ extern QCommandLineOption save_search;
 extern QCommandLineOption save_execution;
 extern QCommandLineOption save_pixel_tree;
 extern QCommandLineOption pixel_tree_compression;
+extern QCommandLineOption save_tree_image;
+extern QCommandLineOption tree_image_scale;
+extern QCommandLineOption record;
+extern QCommandLineOption replay;
+extern QCommandLineOption replay_speed;
+extern QCommandLineOption headless;
+extern QCommandLineOption max_executions;
+extern QCommandLineOption idle_timeout;
+extern QCommandLineOption memory_budget;
+extern QCommandLineOption node_store;
+extern QCommandLineOption layout_threads;
 } // namespace cl_options
 
 class CommandLineParser
@@ -1,6 +1,5 @@
 #include "conductor.hh"
-#include "tcp_server.hh"
-#include "receiver_thread.hh"
+#include "solver_listener.hh"
 #include <iostream>
 #include <thread>
 #include <QTreeView>
@@ -12,6 +11,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QApplication>
+#include <QDir>
 #include "../cpp-integration/message.hpp"
 
 #include "execution.hh"
@@ -28,6 +28,7 @@
 #include "utils/string_utils.hh"
 #include "utils/tree_utils.hh"
 #include "utils/path_utils.hh"
+#include "utils/search_log.hh"
 
 #include "pixel_views/pt_canvas.hh"
 
@@ -37,6 +38,7 @@
 
 #include "name_map.hh"
 #include "db_handler.hh"
+#include "replay.hh"
 
 namespace cpprofiler
 {
@@ -120,41 +122,31 @@ Conductor::Conductor(Options opt, QWidget* parent) : QMainWindow(parent), option
         }
     });
 
-    server_.reset(new TcpServer([this](intptr_t socketDesc) {
-        {
-            /// Initiate a receiver thread
-            auto receiver = new ReceiverThread(socketDesc, settings_);
-            /// Delete the receiver one the thread is finished
-            connect(receiver, &QThread::finished, receiver, &QObject::deleteLater);
-            /// Handle the start message in this connector
-            connect(receiver, &ReceiverThread::notifyStart, [this, receiver](const std::string &ex_name, int ex_id, bool restarts) {
-                handleStart(receiver, ex_name, ex_id, restarts);
-            });
-
-            receiver->start();
-        }
-    }));
-
-    listen_port_ = DEFAULT_PORT;
+    listener_.reset(new SolverListener(
+        settings_,
+        [this](const std::string &ex_name, int ex_id, bool restarts) {
+            return createExecution(ex_name, ex_id, restarts);
+        },
+        options_.record_path));
 
-    // See if the default port is available
-    auto res = server_->listen(QHostAddress::Any, listen_port_);
-    if (!res)
-    {
-        // If not, try any port
-        server_->listen(QHostAddress::Any, 0);
-        listen_port_ = server_->serverPort();
-    }
+    // onExecutionDone must be called on the same thread as the conductor
+    connect(listener_.get(), &SolverListener::buildingDone, this, [this](int ex_id) {
+        onExecutionDone(getExecution(ex_id));
+    });
 
     QString listen_message;
     QTextStream ts(&listen_message);
     ts << "Listening on port "
-       << QString::number(listen_port_)
+       << QString::number(listener_->port())
        << ".";
     auto portLabel = new QLabel(listen_message);
     layout->addWidget(portLabel);
 
-    std::cerr << "Ready to listen on: " << listen_port_ << std::endl;
+    if (options_.replay_path != "")
+    {
+        replay_.reset(new Replay(options_.replay_path, listener_->port(), options_.replay_speed));
+        replay_->start();
+    }
 }
 
 static int getRandomExID()
@@ -171,6 +163,12 @@ void Conductor::onExecutionDone(Execution *e)
     e->tree().setDone();
     emit executionFinish(e);
 
+    if (replay_)
+    {
+        replay_->report(*e);
+        QApplication::quit();
+    }
+
     if (options_.save_search_path != "")
     {
         print("saving search to: {}", options_.save_search_path);
@@ -215,77 +213,44 @@ void Conductor::setMetaData(int exec_id, const std::string &group_name,
 
 int Conductor::getListenPort() const
 {
-    return static_cast<int>(listen_port_);
+    return static_cast<int>(listener_->port());
 }
 
 Conductor::~Conductor() = default;
 
-void Conductor::handleStart(ReceiverThread *receiver, const std::string &ex_name, int ex_id, bool restarts)
+Execution *Conductor::createExecution(const std::string &ex_name, int ex_id, bool restarts)
 {
+    /// Note: metadata from MiniZinc IDE overrides that provided by the solver
+    std::string ex_name_used = ex_name;
 
-    auto res = executions_.find(ex_id);
+    const bool ide_used = (exec_meta_.find(ex_id) != exec_meta_.end());
 
-    if (res == executions_.end() || ex_id == 0)
+    if (ide_used)
     {
+        print("already know metadata for this ex_id!");
+        ex_name_used = exec_meta_[ex_id].ex_name;
+    }
 
-        /// Note: metadata from MiniZinc IDE overrides that provided by the solver
-        std::string ex_name_used = ex_name;
-
-        const bool ide_used = (exec_meta_.find(ex_id) != exec_meta_.end());
-
-        if (ide_used)
-        {
-            print("already know metadata for this ex_id!");
-            ex_name_used = exec_meta_[ex_id].ex_name;
-        }
-
-        /// needs a new execution
-        auto ex = addNewExecution(ex_name_used, ex_id, restarts);
-        emit executionStart(ex);
+    auto ex = addNewExecution(ex_name_used, ex_id, restarts);
+    emit executionStart(ex);
 
-        /// construct a name map
-        if (ide_used)
-        {
-            ex->setNameMap(exec_meta_[ex_id].name_map);
-            print("using name map for {}", ex_id);
-        }
-        else if (options_.paths != "" && options_.mzn != "")
+    /// construct a name map
+    if (ide_used)
+    {
+        ex->setNameMap(exec_meta_[ex_id].name_map);
+        print("using name map for {}", ex_id);
+    }
+    else if (options_.paths != "" && options_.mzn != "")
+    {
+        auto nm = std::make_shared<NameMap>();
+        auto success = nm->initialize(options_.paths, options_.mzn);
+        if (success)
         {
-            auto nm = std::make_shared<NameMap>();
-            auto success = nm->initialize(options_.paths, options_.mzn);
-            if (success)
-            {
-                ex->setNameMap(nm);
-            }
+            ex->setNameMap(nm);
         }
-
-        /// The builder should only be created for a new execution
-        auto builderThread = new QThread();
-        auto builder = new TreeBuilder(*ex);
-
-        builders_[ex_id] = builder;
-        builder->moveToThread(builderThread);
-
-	// onExecutionDone must be called on the same thread as the conductor
-        connect(builder, &TreeBuilder::buildingDone, this, [this, ex]() {
-            onExecutionDone(ex);
-        });
-
-        /// is this the right time to delete the builder thread?
-        connect(builderThread, &QThread::finished, builderThread, &QObject::deleteLater);
-
-        builderThread->start();
     }
 
-    /// obtain the builder aready assigned to this execution
-    ///(either just now or by another connection)
-    auto builder = builders_[ex_id];
-
-    connect(receiver, &ReceiverThread::newNode,
-            builder, &TreeBuilder::handleNode);
-
-    connect(receiver, &ReceiverThread::doneReceiving,
-            builder, &TreeBuilder::finishBuilding);
+    return ex;
 }
 
 int Conductor::addNewExecution(std::shared_ptr<Execution> ex)
@@ -308,6 +273,7 @@ Execution *Conductor::addNewExecution(const std::string &ex_name, int ex_id, boo
     }
 
     auto ex = std::make_shared<Execution>(ex_name, ex_id, restarts);
+    ex->setMemoryBudget(static_cast<size_t>(options_.memory_budget) * 1024 * 1024);
 
     print("EXECUTION_ID: {}", ex_id);
 
@@ -405,80 +371,14 @@ void Conductor::runNogoodAnalysis(Execution *e1, Execution *e2)
     merger->start();
 }
 
-void Conductor::savePixelTree(Execution *e, const char* path, int compression_factor) const {
-  const auto &nt = e->tree();
-  pixel_view::PtCanvas pc(nt);
-  auto pi = pc.get_pimage();
-  pc.setCompression(compression_factor);
-  int width  = pi->pixel_size()*pc.totalSlices();
-  int height = pi->pixel_size()*nt.node_stats().maxDepth();
-  pi->resize({width,height});
-  pc.redrawAll(true);
-  pi->raw_image().save(path);
+void Conductor::savePixelTree(Execution *e, const char *path, int compression_factor) const
+{
+    pixel_view::save_pixel_tree(e->tree(), path, compression_factor);
 }
 
 void Conductor::saveSearch(Execution *e, const char *path) const
 {
-
-    const auto &nt = e->tree();
-
-    const auto order = utils::pre_order(nt);
-
-    QFile file(path);
-    if (!file.open(QFile::WriteOnly | QFile::Truncate))
-    {
-        print("Error: could not open \"{}\" to save search", path);
-        return;
-    }
-
-    QTextStream file_stream(&file);
-
-    for (auto nid : order)
-    {
-
-        /// Making sure undefined/skipped nodes are not logged
-        {
-            const auto status = nt.getStatus(nid);
-            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
-                continue;
-        }
-
-        // Note: not every child is logged (SKIPPED and UNDET are not)
-        int kids_logged = 0;
-
-        /// Note: this temporary stream is used so that children can be
-        /// traversed first, counted, but logged after their parent
-        std::stringstream children_stream;
-
-        const auto kids = nt.childrenCount(nid);
-
-        for (auto alt = 0; alt < kids; alt++)
-        {
-
-            const auto kid = nt.getChild(nid, alt);
-
-            /// Making sure undefined/skipped children are not logged
-            const auto status = nt.getStatus(kid);
-            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
-                continue;
-
-            ++kids_logged;
-            /// TODO: use original names in labels
-            const auto label = nt.getLabel(kid);
-
-            children_stream << " " << kid << " " << label;
-        }
-
-        file_stream << nid << " " << kids_logged;
-
-        /// Unexplored node on the left branch (search timed out)
-        if ((kids == 0) && (nt.getStatus(nid) == tree::NodeStatus::BRANCH))
-        {
-            file_stream << " stop";
-        }
-
-        file_stream << children_stream.str().c_str() << '\n';
-    }
+    utils::save_search(e->tree(), path);
 }
 
 void Conductor::saveSearch(Execution *e) const
@@ -528,6 +428,12 @@ void Conductor::readSettings()
         auto json_obj = json_doc.object();
 
         settings_.receiver_delay = json_obj["receiver_delay"].toInt();
+
+        if (json_obj.contains("receiver_batch_size"))
+            settings_.receiver_batch_size = json_obj["receiver_batch_size"].toInt();
+
+        if (json_obj.contains("receiver_batch_ms"))
+            settings_.receiver_batch_ms = json_obj["receiver_batch_ms"].toInt();
     }
 
     qDebug() << "settings read";
@@ -614,12 +520,7 @@ void Conductor::computeHeatMap(ExecID eid, std::vector<NodeID> ns)
 
     for (const auto& n : ns)
     {
-        const auto *cs = sd.getContribConstraints(n);
-
-        if (!cs)
-            continue;
-
-        for (int con_id : *cs)
+        for (int con_id : sd.getContribConstraints(n))
         {
             con_counts[con_id]++;
         }
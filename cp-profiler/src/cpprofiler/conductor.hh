@@ -19,13 +19,12 @@ namespace analysis
 class MergeWindow;
 }
 
-class TcpServer;
+class SolverListener;
 class Execution;
 class ExecutionList;
 class ExecutionWindow;
-class ReceiverThread;
-class TreeBuilder;
 class NameMap;
+class Replay;
 
 struct ExecMeta
 {
@@ -43,9 +42,6 @@ class Conductor : public QMainWindow
 
     ~Conductor();
 
-    void handleStart(ReceiverThread *receiver, const std::string &ex_name,
-                     int ex_id, bool restarts);
-
     Execution *addNewExecution(const std::string &ex_name, int ex_id = 0,
                                bool restarts = false);
 
@@ -93,25 +89,24 @@ class Conductor : public QMainWindow
 
     void onExecutionDone(Execution *e);
 
-    // void getSelectedExecutions
+    /// Create the execution for a solver that starts a new one
+    Execution *createExecution(const std::string &ex_name, int ex_id, bool restarts);
 
-    static constexpr quint16 DEFAULT_PORT = 6565;
+    // void getSelectedExecutions
 
     Settings settings_;
 
-    /// Port number opened for solvers to connect to
-    quint16 listen_port_;
-
-    std::unique_ptr<TcpServer> server_;
+    /// Accepts solvers and feeds them to the builders of their executions
+    std::unique_ptr<SolverListener> listener_;
 
     Options options_;
 
+    /// Plays back `options_.replay_path` (if set)
+    std::unique_ptr<Replay> replay_;
+
     /// a map from execution id to an execution
     std::unordered_map<int, std::shared_ptr<Execution>> executions_;
 
-    /// a map from exec_id to its builder
-    std::unordered_map<int, TreeBuilder *> builders_;
-
     std::unique_ptr<ExecutionList> execution_list_;
 
     std::unordered_map<ExecID, ExecMeta> exec_meta_;
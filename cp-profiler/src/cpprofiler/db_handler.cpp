@@ -260,7 +260,7 @@ static void save_nogoods(QSqlDatabase *db, const Execution *ex)
     for (const auto n : nodes)
     {
         /// TODO: should save renamed instead?
-        const auto &text = sd.getNogood(n).original();
+        const auto text = sd.getNogood(n).original();
         if (text != "")
         {
             insert_nogood(&insert_ng_stmt, {n, text});
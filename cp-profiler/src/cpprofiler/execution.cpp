@@ -6,6 +6,8 @@
 #include "utils/debug.hh"
 
 #include <iostream>
+#include <sstream>
+#include <iomanip>
 
 namespace cpprofiler
 {
@@ -35,4 +37,80 @@ void Execution::setNameMap(std::shared_ptr<const NameMap> nm)
 
 bool Execution::doesRestarts() const { return m_is_restarts; }
 
+std::string MemoryReport::toString() const
+{
+    const auto mb = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << mb(total()) << " MB (structure: " << mb(structure)
+       << ", info: " << mb(node_info)
+       << ", labels: " << mb(labels)
+       << ", solver data: " << mb(solver_data);
+
+    if (layout > 0 || visual_flags > 0)
+    {
+        ss << ", layout: " << mb(layout) << ", flags: " << mb(visual_flags);
+    }
+
+    ss << ")";
+    return ss.str();
+}
+
+MemoryReport Execution::memoryUsage() const
+{
+    MemoryReport report;
+    report.structure = tree_->structureMemoryUsage();
+    report.node_info = tree_->nodeInfoMemoryUsage();
+    report.labels = tree_->labelMemoryUsage();
+    report.solver_data = solver_data_->memoryUsage().total();
+    return report;
+}
+
+static const char *degradation_message(MemoryDegradation level)
+{
+    switch (level)
+    {
+    case MemoryDegradation::NO_INFO:
+        return "dropping node info";
+    case MemoryDegradation::NO_LABELS:
+        return "dropping labels";
+    case MemoryDegradation::STOPPED:
+        return "ignoring further nodes";
+    default:
+        return "";
+    }
+}
+
+void Execution::checkMemoryBudget()
+{
+    const auto level = degradation_.load();
+
+    if (memory_budget_ == 0 || level == MemoryDegradation::STOPPED)
+        return;
+
+    const auto usage = memoryUsage();
+    const auto used = usage.total();
+
+    /// Dropping data only slows down further growth (nothing is freed),
+    /// so cheaper data is given up well before the budget is reached
+    auto next = MemoryDegradation::NONE;
+
+    if (used > memory_budget_)
+        next = MemoryDegradation::STOPPED;
+    else if (used > memory_budget_ / 100 * 85)
+        next = MemoryDegradation::NO_LABELS;
+    else if (used > memory_budget_ / 100 * 70)
+        next = MemoryDegradation::NO_INFO;
+
+    if (next <= level)
+        return;
+
+    degradation_ = next;
+
+    print("execution {} is at {}% of its memory budget ({} MB): {}; {}", id_,
+          used * 100 / memory_budget_, memory_budget_ / (1024 * 1024),
+          usage.toString(), degradation_message(next));
+}
+
 } // namespace cpprofiler
\ No newline at end of file
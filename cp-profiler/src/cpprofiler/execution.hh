@@ -5,6 +5,7 @@
 #include "tree/node.hh"
 #include "tree/node_tree.hh"
 #include "user_data.hh"
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -13,6 +14,39 @@
 namespace cpprofiler
 {
 
+/// Memory (in bytes) used by an execution, by kind of data; `layout` and
+/// `visual_flags` belong to a view and are only filled in by the window showing it
+struct MemoryReport
+{
+    size_t structure = 0;
+    size_t node_info = 0;
+    size_t labels = 0;
+    size_t solver_data = 0;
+    size_t layout = 0;
+    size_t visual_flags = 0;
+
+    size_t total() const
+    {
+        return structure + node_info + labels + solver_data + layout + visual_flags;
+    }
+
+    /// Total and per-kind usage in MB, e.g. for a status bar or a log
+    std::string toString() const;
+};
+
+/// What is no longer stored for an execution that went over its memory budget;
+/// each level includes the previous ones
+enum class MemoryDegradation
+{
+    NONE,
+    /// Info strings (and reasons/contributing nogoods) are dropped
+    NO_INFO,
+    /// New nodes get no labels
+    NO_LABELS,
+    /// New nodes are ignored (the tree is left incomplete)
+    STOPPED
+};
+
 class Execution
 {
 
@@ -31,6 +65,11 @@ class Execution
     /// Whether the execution contains restarts
     bool m_is_restarts;
 
+    /// Memory budget in bytes (0: unlimited)
+    size_t memory_budget_ = 0;
+
+    std::atomic<MemoryDegradation> degradation_{MemoryDegradation::NONE};
+
   public:
     std::string name();
 
@@ -54,6 +93,20 @@ class Execution
     const NameMap *nameMap() const { return name_map_.get(); }
 
     bool doesRestarts() const;
+
+    /// Memory used by the tree and solver data; the caller must hold the tree mutex
+    MemoryReport memoryUsage() const;
+
+    void setMemoryBudget(size_t bytes) { memory_budget_ = bytes; }
+
+    size_t memoryBudget() const { return memory_budget_; }
+
+    MemoryDegradation degradation() const { return degradation_; }
+
+    /// Degrade as the execution approaches its budget: info is dropped past 70%,
+    /// labels past 85% and nodes past 100%; called by the builder (holding the
+    /// tree mutex) after adding nodes
+    void checkMemoryBudget();
 };
 
 } // namespace cpprofiler
@@ -25,6 +25,8 @@
 #include <QToolBar>
 
 #include "tree/node_tree.hh"
+#include "tree/layout.hh"
+#include "tree/layout_worker.hh"
 
 #include "utils/maybe_caller.hh"
 
@@ -79,6 +81,9 @@ ExecutionWindow::ExecutionWindow(Execution &ex, QWidget* parent)
     auto stats_bar = new NodeStatsBar(this, tree.node_stats());
     statusBar()->addPermanentWidget(stats_bar);
 
+    auto memory_label = new QLabel();
+    statusBar()->addPermanentWidget(memory_label);
+
     resize(500, 700);
 
     {
@@ -108,7 +113,8 @@ ExecutionWindow::ExecutionWindow(Execution &ex, QWidget* parent)
         connect(&execution_.tree(), &tree::NodeTree::structureUpdated,
                 traditional_view_.get(), &tree::TraditionalView::setLayoutOutdated);
 
-        connect(&execution_.tree(), &tree::NodeTree::failedSubtreeClosed, [this](NodeID n) {
+        /// (queued: the tree is built on another thread)
+        connect(&execution_.tree(), &tree::NodeTree::failedSubtreeClosed, traditional_view_.get(), [this](NodeID n) {
             traditional_view_->hideNode(n);
         });
 
@@ -117,6 +123,15 @@ ExecutionWindow::ExecutionWindow(Execution &ex, QWidget* parent)
             connect(statsUpdateTimer, &QTimer::timeout, stats_bar, &NodeStatsBar::update);
             statsUpdateTimer->start(16);
         }
+
+        {
+            /// computing memory usage walks all shapes, so it is updated less often
+            auto memoryUpdateTimer = new QTimer(this);
+            connect(memoryUpdateTimer, &QTimer::timeout, [this, memory_label]() {
+                updateMemoryLabel(memory_label);
+            });
+            memoryUpdateTimer->start(1000);
+        }
     }
 
     {
@@ -370,6 +385,42 @@ ExecutionWindow::ExecutionWindow(Execution &ex, QWidget* parent)
     }
 }
 
+void ExecutionWindow::updateMemoryLabel(QLabel *label)
+{
+    MemoryReport report;
+
+    {
+        utils::MutexLocker tree_lock(&execution_.tree().treeMutex());
+        report = execution_.memoryUsage();
+        traditional_view_->addMemoryUsage(report);
+    }
+
+    const auto mb = report.total() / (1024 * 1024);
+
+    if (execution_.memoryBudget() > 0)
+    {
+        label->setText(QString("Memory: %1/%2 MB").arg(mb).arg(execution_.memoryBudget() / (1024 * 1024)));
+    }
+    else
+    {
+        label->setText(QString("Memory: %1 MB").arg(mb));
+    }
+
+    auto tooltip = QString::fromStdString(report.toString());
+
+    const auto &shape_cache = traditional_view_->layout().shapeCache();
+    if (shape_cache.lookups() > 0)
+    {
+        tooltip += QString("\nShape cache hit rate: %1%").arg(shape_cache.hitRate() * 100, 0, 'f', 1);
+    }
+
+    label->setToolTip(tooltip);
+
+    /// make it obvious that the tree is no longer complete
+    const bool degraded = execution_.degradation() != MemoryDegradation::NONE;
+    label->setStyleSheet(degraded ? "color: red" : "");
+}
+
 ExecutionWindow::~ExecutionWindow() = default;
 
 tree::TraditionalView &ExecutionWindow::traditional_view()
@@ -426,7 +477,11 @@ void ExecutionWindow::removeSelectedNode()
     const auto pid = execution_.tree().getParent(nid);
     execution_.userData().setSelectedNode(pid);
 
-    execution_.tree().removeNode(nid);
+    {
+        /// the layout is being computed without the tree mutex
+        tree::LayoutWorker::Pause pause(traditional_view_->layoutWorker());
+        execution_.tree().removeNode(nid);
+    }
 
     if (pid != NodeID::NoNode)
     {
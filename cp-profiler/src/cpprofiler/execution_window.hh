@@ -4,6 +4,7 @@
 #include <memory>
 #include <QMainWindow>
 #include <QSlider>
+#include <QLabel>
 
 #include "tree/node_id.hh"
 #include "core.hh"
@@ -74,6 +75,9 @@ class ExecutionWindow : public QMainWindow
 
   bool dark_mode_ = false;
 
+  /// Show the execution's current memory usage in `label`
+  void updateMemoryLabel(QLabel *label);
+
 public:
   tree::TraditionalView &traditional_view();
 
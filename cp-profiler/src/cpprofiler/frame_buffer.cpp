@@ -0,0 +1,83 @@
+#include "frame_buffer.hh"
+
+#include <cstring>
+
+namespace cpprofiler
+{
+
+/// Don't bother reading from the socket into less space than this
+static constexpr size_t MIN_WRITABLE = 4096;
+
+FrameBuffer::FrameBuffer(size_t capacity) : m_data(capacity < MIN_WRITABLE ? MIN_WRITABLE : capacity)
+{
+}
+
+char *FrameBuffer::writePtr()
+{
+    if (m_begin == m_end)
+    {
+        /// everything consumed: start from the front (nothing to move)
+        m_begin = m_end = 0;
+    }
+    else if (writable() < MIN_WRITABLE)
+    {
+        compact();
+    }
+
+    return m_data.data() + m_end;
+}
+
+bool FrameBuffer::nextFrame(FrameView &frame)
+{
+    if (pending() < FIELD_SIZE_NBYTES)
+    {
+        ensureFits(FIELD_SIZE_NBYTES);
+        return false;
+    }
+
+    /// the size is sent in the sender's byte order
+    int32_t size;
+    std::memcpy(&size, m_data.data() + m_begin, FIELD_SIZE_NBYTES);
+
+    const size_t total = FIELD_SIZE_NBYTES + static_cast<size_t>(size);
+
+    if (pending() < total)
+    {
+        ensureFits(total);
+        return false;
+    }
+
+    frame.data = m_data.data() + m_begin + FIELD_SIZE_NBYTES;
+    frame.size = size;
+
+    m_begin += total;
+
+    return true;
+}
+
+void FrameBuffer::ensureFits(size_t n)
+{
+    if (m_data.size() - m_begin >= n)
+        return;
+
+    compact();
+
+    /// a single frame larger than the whole buffer
+    if (m_data.size() < n)
+    {
+        m_data.resize(n);
+    }
+}
+
+void FrameBuffer::compact()
+{
+    if (m_begin == 0)
+        return;
+
+    const size_t n = pending();
+    std::memmove(m_data.data(), m_data.data() + m_begin, n);
+    m_begin = 0;
+    m_end = n;
+}
+
+} // namespace cpprofiler
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpprofiler
+{
+
+/// A view into a frame still owned by FrameBuffer
+struct FrameView
+{
+    const char *data = nullptr;
+    int size = 0;
+};
+
+/// Fixed-capacity receive buffer splitting a byte stream into
+/// length-prefixed frames without copying them out of the buffer.
+///
+/// Bytes are written directly into the free tail of the buffer
+/// (see `writePtr`/`commit`); only the incomplete frame at the end
+/// is ever moved back to the front. Views returned by `nextFrame`
+/// stay valid until the next call to `writePtr`.
+class FrameBuffer
+{
+  public:
+    /// the number of bytes per frame size
+    static constexpr int FIELD_SIZE_NBYTES = 4;
+
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+    explicit FrameBuffer(size_t capacity = DEFAULT_CAPACITY);
+
+    /// Where to write incoming bytes; may move unread bytes to the front
+    char *writePtr();
+
+    /// Number of bytes that can be written at `writePtr()`
+    size_t writable() const { return m_data.size() - m_end; }
+
+    /// Mark `n` bytes written at `writePtr()` as received
+    void commit(size_t n) { m_end += n; }
+
+    /// Extract the next complete frame, if any
+    bool nextFrame(FrameView &frame);
+
+    /// Drop all received bytes
+    void clear() { m_begin = m_end = 0; }
+
+    /// Number of received bytes not yet returned as frames
+    size_t pending() const { return m_end - m_begin; }
+
+    size_t capacity() const { return m_data.size(); }
+
+  private:
+    std::vector<char> m_data;
+
+    /// first byte not yet consumed
+    size_t m_begin = 0;
+    /// one past the last byte received
+    size_t m_end = 0;
+
+    /// Make sure a frame of `n` bytes (including its size) fits into the buffer
+    void ensureFits(size_t n);
+
+    /// Move unconsumed bytes to the front of the buffer
+    void compact();
+};
+
+} // namespace cpprofiler
@@ -0,0 +1,182 @@
+#include "headless_runner.hh"
+#include "solver_listener.hh"
+
+#include <random>
+#include <QCoreApplication>
+
+#include "execution.hh"
+#include "message_wrapper.hh"
+#include "name_map.hh"
+#include "db_handler.hh"
+#include "replay.hh"
+
+#include "pixel_views/pt_canvas.hh"
+#include "tree/tree_image.hh"
+
+#include "utils/string_utils.hh"
+#include "utils/search_log.hh"
+
+namespace cpprofiler
+{
+
+HeadlessRunner::HeadlessRunner(Options opt) : options_(std::move(opt))
+{
+    qRegisterMetaType<MessageBatch>();
+
+    listener_.reset(new SolverListener(
+        settings_,
+        [this](const std::string &ex_name, int ex_id, bool restarts) {
+            return createExecution(ex_name, ex_id, restarts);
+        },
+        options_.record_path));
+
+    connect(listener_.get(), &SolverListener::connectionAccepted, this, [this]() {
+        idle_timer_.stop();
+        ++active_receivers_;
+    });
+
+    connect(listener_.get(), &SolverListener::connectionClosed, this, [this]() {
+        --active_receivers_;
+        checkDone();
+    });
+
+    connect(listener_.get(), &SolverListener::buildingDone, this, &HeadlessRunner::onExecutionDone);
+
+    idle_timer_.setSingleShot(true);
+    connect(&idle_timer_, &QTimer::timeout, this, []() {
+        print("headless: no activity for a while, quitting");
+        QCoreApplication::quit();
+    });
+
+    if (options_.replay_path != "")
+    {
+        replay_.reset(new Replay(options_.replay_path, listener_->port(), options_.replay_speed));
+        replay_->start();
+    }
+    else if (options_.idle_timeout > 0)
+    {
+        /// don't wait forever for the first solver either
+        idle_timer_.start(options_.idle_timeout * 1000);
+    }
+}
+
+HeadlessRunner::~HeadlessRunner() = default;
+
+Execution *HeadlessRunner::createExecution(const std::string &ex_name, int ex_id, bool restarts)
+{
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_int_distribution<int> dist(100);
+
+    while (ex_id == 0 || executions_.find(ex_id) != executions_.end())
+    {
+        ex_id = dist(rng);
+    }
+
+    auto ex = std::make_shared<Execution>(ex_name, ex_id, restarts);
+    ex->setMemoryBudget(static_cast<size_t>(options_.memory_budget) * 1024 * 1024);
+    executions_[ex_id] = ex;
+    start_index_[ex_id] = started_count_++;
+
+    print("headless: EXECUTION_ID: {} ({})", ex_id, ex_name);
+
+    if (options_.paths != "" && options_.mzn != "")
+    {
+        auto nm = std::make_shared<NameMap>();
+        if (nm->initialize(options_.paths, options_.mzn))
+        {
+            ex->setNameMap(nm);
+        }
+    }
+
+    return ex.get();
+}
+
+void HeadlessRunner::onExecutionDone(int ex_id)
+{
+    const auto it = executions_.find(ex_id);
+    if (it == executions_.end())
+        return;
+
+    /// artefacts are numbered in the order the executions started
+    const auto index = start_index_[ex_id];
+
+    /// keep the execution alive until its artefacts are written
+    const auto ex = it->second;
+
+    ex->tree().setDone();
+
+    {
+        utils::MutexLocker lock(&ex->tree().treeMutex());
+        print("headless: execution {} memory: {}", ex_id, ex->memoryUsage().toString());
+    }
+
+    if (options_.save_search_path != "")
+    {
+        const auto path = utils::numbered_path(options_.save_search_path, index);
+        print("saving search to: {}", path);
+        utils::save_search(ex->tree(), path.c_str());
+    }
+
+    if (options_.save_execution_db != "")
+    {
+        const auto path = utils::numbered_path(options_.save_execution_db, index);
+        print("saving execution to db: {}", path);
+        db_handler::save_execution(ex.get(), path.c_str());
+    }
+
+    if (options_.save_pixel_tree_path != "")
+    {
+        const auto path = utils::numbered_path(options_.save_pixel_tree_path, index);
+        print("saving pixel tree to file: {}", path);
+        pixel_view::save_pixel_tree(ex->tree(), path.c_str(), options_.pixel_tree_compression);
+    }
+
+    if (options_.save_tree_image_path != "")
+    {
+        const auto path = utils::numbered_path(options_.save_tree_image_path, index);
+        print("saving tree image to file: {}", path);
+        tree::save_tree_image(ex->tree(), path.c_str(), options_.tree_image_scale);
+    }
+
+    if (replay_)
+    {
+        replay_->report(*ex);
+    }
+
+    /// the builder (and its thread) are no longer needed; the execution
+    /// goes away with the last reference
+    listener_->releaseBuilder(ex_id);
+
+    executions_.erase(it);
+    start_index_.erase(ex_id);
+
+    ++finished_count_;
+
+    checkDone();
+}
+
+void HeadlessRunner::checkDone()
+{
+    if (active_receivers_ > 0 || !executions_.empty())
+        return;
+
+    if (replay_ && finished_count_ > 0)
+    {
+        QCoreApplication::quit();
+        return;
+    }
+
+    if (options_.max_executions > 0 && finished_count_ >= options_.max_executions)
+    {
+        print("headless: {} executions done", finished_count_);
+        QCoreApplication::quit();
+        return;
+    }
+
+    if (options_.idle_timeout > 0)
+    {
+        idle_timer_.start(options_.idle_timeout * 1000);
+    }
+}
+
+} // namespace cpprofiler
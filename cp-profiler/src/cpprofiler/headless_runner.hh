@@ -0,0 +1,69 @@
+#ifndef CPPROFILER_HEADLESS_RUNNER_HH
+#define CPPROFILER_HEADLESS_RUNNER_HH
+
+#include <QObject>
+#include <QTimer>
+#include <memory>
+#include <unordered_map>
+
+#include "core.hh"
+#include "options.hh"
+#include "settings.hh"
+
+namespace cpprofiler
+{
+
+class SolverListener;
+class Execution;
+class Replay;
+
+/// Counterpart of Conductor for running without a GUI (on top of QCoreApplication):
+/// accepts any number of (concurrent) solver connections, builds their
+/// executions, writes the artefacts requested in `Options` for each of them
+/// and quits once there is nothing left to do
+class HeadlessRunner : public QObject
+{
+    Q_OBJECT
+
+    Options options_;
+
+    Settings settings_;
+
+    std::unique_ptr<SolverListener> listener_;
+
+    /// Executions still being built (by execution id)
+    std::unordered_map<int, std::shared_ptr<Execution>> executions_;
+
+    /// Position of each execution (by id) in the order they were started
+    std::unordered_map<int, int> start_index_;
+
+    std::unique_ptr<Replay> replay_;
+
+    /// Number of receivers that haven't finished yet
+    int active_receivers_ = 0;
+
+    /// Number of executions started/finished so far
+    int started_count_ = 0;
+    int finished_count_ = 0;
+
+    /// Quits the application when nothing happens for `Options::idle_timeout` seconds
+    QTimer idle_timer_;
+
+    /// Create the execution for a solver that starts a new one
+    Execution *createExecution(const std::string &ex_name, int ex_id, bool restarts);
+
+    /// Write the requested artefacts for execution `ex_id` and release it
+    void onExecutionDone(int ex_id);
+
+    /// Quit if all requested executions are done, otherwise (re)start the idle timer
+    void checkDone();
+
+  public:
+    explicit HeadlessRunner(Options opt);
+
+    ~HeadlessRunner();
+};
+
+} // namespace cpprofiler
+
+#endif
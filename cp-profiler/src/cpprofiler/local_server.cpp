@@ -0,0 +1,45 @@
+#include "local_server.hh"
+
+#include <QDir>
+#include <iostream>
+
+#include "utils/debug.hh"
+
+namespace cpprofiler
+{
+
+LocalServer::LocalServer(std::function<void(intptr_t)> callback)
+    : QLocalServer{}, m_callback(callback) {}
+
+QString LocalServer::socketPath(quint16 port)
+{
+    QString path = QString::fromLocal8Bit(qgetenv("CPPROFILER_SOCKET"));
+    if (path.isEmpty())
+    {
+        path = QDir::tempPath() + "/cpprofiler-" + QString::number(port);
+    }
+    return path;
+}
+
+bool LocalServer::listenAt(const QString &path)
+{
+    setSocketOptions(QLocalServer::UserAccessOption);
+    /// a profiler that crashed may have left the socket file behind
+    QLocalServer::removeServer(path);
+
+    if (listen(path))
+    {
+        std::cerr << "Ready to listen on: " << path.toStdString() << std::endl;
+        return true;
+    }
+
+    print("Warning: could not listen on {}", path.toStdString());
+    return false;
+}
+
+void LocalServer::incomingConnection(quintptr handle)
+{
+    m_callback(static_cast<intptr_t>(handle));
+}
+
+} // namespace cpprofiler
@@ -0,0 +1,33 @@
+#ifndef CPPROFILER_LOCAL_SERVER_HH
+#define CPPROFILER_LOCAL_SERVER_HH
+
+#include <QLocalServer>
+#include <functional>
+#include <cstdint>
+
+namespace cpprofiler
+{
+
+/// Accepts solver connections on a Unix domain socket (a named pipe on Windows)
+class LocalServer : public QLocalServer
+{
+    Q_OBJECT
+  public:
+    LocalServer(std::function<void(intptr_t)> callback);
+
+    /// Path of the socket for a profiler listening on TCP `port`;
+    /// must match Connector::localSocketPath in cpp-integration/connector.hpp
+    static QString socketPath(quint16 port);
+
+    /// Listen on `path` (accessible to the current user only), replacing a stale socket
+    bool listenAt(const QString &path);
+
+  private:
+    void incomingConnection(quintptr socketDesc) override;
+
+    std::function<void(intptr_t)> m_callback;
+};
+
+} // namespace cpprofiler
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <QMetaType>
 #include <memory>
+#include <vector>
 
 #include "../cpp-integration/message.hpp"
 
@@ -28,8 +29,33 @@ private:
     Message _msg;
 };
 
+/// A contiguous batch of node messages handed over to the builder at once
+///
+/// Copying a batch (as Qt does for queued connections) only copies the
+/// shared pointer, not the messages themselves
+class MessageBatch
+{
+public:
+    MessageBatch() : _msgs(std::make_shared<std::vector<Message>>()) {}
+    MessageBatch(const MessageBatch &other) = default;
+    ~MessageBatch() = default;
+
+    void reserve(size_t n) { _msgs->reserve(n); }
+
+    void push_back(const Message &msg) { _msgs->push_back(msg); }
+
+    size_t size() const { return _msgs->size(); }
+    bool empty() const { return _msgs->empty(); }
+
+    const std::vector<Message>& msgs() const { return *_msgs; }
+
+private:
+    std::shared_ptr<std::vector<Message>> _msgs;
+};
+
 } // namespace cpprofiler
 
 Q_DECLARE_METATYPE(cpprofiler::MessageWrapper);
+Q_DECLARE_METATYPE(cpprofiler::MessageBatch);
 
 #endif
@@ -10,7 +10,30 @@ struct Options
     std::string save_search_path;
     std::string save_execution_db;
     std::string save_pixel_tree_path;
-    int pixel_tree_compression;
+    int pixel_tree_compression = 2;
+    /// Save the traditional view of the tree as an image (see `tree::save_tree_image`)
+    std::string save_tree_image_path;
+    /// Scale of the saved traditional view (1: as drawn at 100% zoom)
+    float tree_image_scale = 1.0f;
+    /// Record frames received from solvers into this capture file
+    std::string record_path;
+    /// Replay this capture file (instead of waiting for a solver)
+    std::string replay_path;
+    /// Replay speed relative to the recorded timing (0: as fast as possible)
+    double replay_speed = 0;
+    /// Run without a GUI (see HeadlessRunner)
+    bool headless = false;
+    /// Headless: quit after this many executions (0: no limit)
+    int max_executions = 0;
+    /// Headless: quit after this many seconds without a solver connected (0: never)
+    int idle_timeout = 10;
+    /// Memory budget per execution in MB (0: unlimited); see `MemoryDegradation`
+    int memory_budget = 0;
+    /// Keep tree structure, node flags and labels in memory-mapped files
+    /// in this directory (empty: on the heap)
+    std::string node_store_dir;
+    /// Threads for laying out large trees (0: one per core, 1: no parallel layout)
+    int layout_threads = 0;
 };
 
 } // namespace cpprofiler
@@ -5,9 +5,9 @@
 
 #include "../utils/perf_helper.hh"
 #include "../utils/debug.hh"
+#include "../utils/tiled_image_writer.hh"
 
-#include <cmath>     // std::ceil
-#include <algorithm> // std::min
+#include <algorithm> // std::min, std::fill
 
 #include <QPainter>
 #include <QPushButton>
@@ -112,100 +112,78 @@ PtCanvas::PtCanvas(const tree::NodeTree &tree) : QWidget(), tree_(tree)
 
 PtCanvas::~PtCanvas() = default;
 
-int PtCanvas::totalSlices() const
-{
-    return std::ceil((float)pi_seq_.size() / compression_);
-}
-
-std::vector<PixelItem> PtCanvas::constructPixelTree() const
+/// Produces the nodes of `nt` in the order they appear in the pixel tree
+/// one at a time, so that only the nodes still to be visited next to the
+/// current path are kept in memory
+class PixelSequenceStream
 {
+    const tree::NodeTree &nt_;
 
-    print("pt: construct tree");
-    /// TODO: tree mutex
-    auto root = tree_.getRoot();
-
-    std::stack<NodeID> stack;
-    std::stack<int> depth_stack;
-
-    std::vector<PixelItem> pixel_seq;
-    pixel_seq.reserve(tree_.nodeCount());
+    std::vector<PixelItem> stack_;
 
-    stack.push(root);
-    depth_stack.push(1);
-
-    while (!stack.empty())
+  public:
+    explicit PixelSequenceStream(const tree::NodeTree &nt) : nt_(nt)
     {
+        stack_.push_back({nt.getRoot(), 1});
+    }
 
-        auto n = stack.top();
-        stack.pop();
-
-        auto depth = depth_stack.top();
-        depth_stack.pop();
+    /// Write the next node into `item`; false if there are none left
+    bool next(PixelItem &item)
+    {
+        if (stack_.empty())
+            return false;
 
-        /// add pixel data
-        pixel_seq.push_back({n, depth});
+        item = stack_.back();
+        stack_.pop_back();
 
-        int kids = tree_.childrenCount(n);
+        const int kids = nt_.childrenCount(item.nid);
 
         for (auto i = kids - 1; i >= 0; --i)
         {
-            stack.push(tree_.getChild(n, i));
-            depth_stack.push(depth + 1);
+            stack_.push_back({nt_.getChild(item.nid, i), item.depth + 1});
         }
+
+        return true;
     }
+};
 
-    stack.push(root);
+/// Nodes of `nt` in the order they appear in the pixel tree
+static std::vector<PixelItem> pixel_sequence(const tree::NodeTree &nt)
+{
 
-    return pixel_seq;
-}
+    print("pt: construct tree");
+    /// TODO: tree mutex
 
-void PtCanvas::redrawAll(bool all)
-{
-    pimage_->clear();
+    std::vector<PixelItem> pixel_seq;
+    pixel_seq.reserve(nt.nodeCount());
 
-    drawPixelTree(all);
+    PixelSequenceStream stream(nt);
 
+    PixelItem item;
+    while (stream.next(item))
     {
-        const auto total_width = totalSlices();
-        /// how many "pixels" fit in one page
-        const auto page_width = pwidget_->width();
-
-        /// Note: page width is 1 smaller for the purpose of calculating the srollbar range,
-        /// than it is for drawing (this way some "pixels" can be drawn partially at the edge)
-        pwidget_->horizontalScrollBar()->setRange(0, total_width - (page_width - 1));
-        pwidget_->horizontalScrollBar()->setPageStep(page_width);
+        pixel_seq.push_back(item);
     }
 
-    pimage_->update();
-    pwidget_->viewport()->update();
+    return pixel_seq;
 }
 
-void PtCanvas::drawPixelTree(bool all)
+/// Draw vertical slices [v_begin, v_end) of the pixel tree into `image`
+static void draw_slices(const tree::NodeTree &nt, const std::vector<PixelItem> &pi_seq,
+                        PixelImage &image, int compression, int v_begin, int v_end,
+                        const std::set<int> &selected_slices, bool dark_mode)
 {
-
-    static int times_called = 0;
-
-    times_called++;
-
-    // print("draw pixel tree: {}", times_called);
-
-    /// which vertical slice to draw at x = 0
-    const auto v_begin = all ? 0 : pwidget_->horizontalScrollBar()->value();
-    /// how many slices are visible
-    const auto visible_slices = pwidget_->width();
-    const auto v_end = all ? totalSlices() : v_begin + visible_slices;
-
     bool end_reached = false;
 
     for (auto slice = v_begin; slice < v_end && !end_reached; ++slice)
     {
         int x = slice - v_begin;
-        int first_idx = slice * compression_;
+        int first_idx = slice * compression;
 
         /// is silce selected?
-        bool selected = selected_slices_.find(slice) != selected_slices_.end();
+        bool selected = selected_slices.find(slice) != selected_slices.end();
 
-        QRgb color = dark_mode_ ? qRgb(215, 225, 215) : qRgb(30, 40, 30);
+        QRgb color = dark_mode ? qRgb(215, 225, 215) : qRgb(30, 40, 30);
 
         if (selected)
         {
@@ -216,16 +194,16 @@ void PtCanvas::drawPixelTree(bool all)
         /// (Note that this has to be separate from drawing, as the solution line
         /// should go behind the actual nodes)
         bool has_solutions = false;
-        for (auto idx = first_idx; idx < first_idx + compression_; ++idx)
+        for (auto idx = first_idx; idx < first_idx + compression; ++idx)
         {
-            if (idx == pi_seq_.size())
+            if (idx == pi_seq.size())
             {
                 end_reached = true;
                 break;
             }
-            const auto node = pi_seq_[idx].nid;
+            const auto node = pi_seq[idx].nid;
 
-            if (tree_.getStatus(node) == tree::NodeStatus::SOLVED)
+            if (nt.getStatus(node) == tree::NodeStatus::SOLVED)
             {
                 has_solutions = true;
                 break;
@@ -234,27 +212,183 @@ void PtCanvas::drawPixelTree(bool all)
 
         if (has_solutions)
         {
-            for (auto y = 0; y < tree_.depth(); ++y)
+            for (auto y = 0; y < nt.depth(); ++y)
             {
-                pimage_->drawPixel(x, y, colors::solution);
+                image.drawPixel(x, y, colors::solution);
             }
         }
 
         /// Draw a "slice"
-        for (auto idx = first_idx; idx < first_idx + compression_; ++idx)
+        for (auto idx = first_idx; idx < first_idx + compression; ++idx)
         {
-            if (idx == pi_seq_.size())
+            if (idx == pi_seq.size())
             {
                 end_reached = true;
                 break;
             }
-            const auto &pi = pi_seq_[idx];
+            const auto &pi = pi_seq[idx];
             const int y = pi.depth;
-            pimage_->drawPixel(x, y, color);
+            image.drawPixel(x, y, color);
         }
     }
 }
 
+static int total_slices(const std::vector<PixelItem> &pi_seq, int compression)
+{
+    return (static_cast<int>(pi_seq.size()) + compression - 1) / compression;
+}
+
+/// Fill the part of `rect` (in image coordinates) that falls into `tile`,
+/// which covers `tile_rect` of the image
+static void fill_tile_rect(QImage &tile, const QRect &tile_rect, const QRect &rect, QRgb color)
+{
+    const auto area = rect.intersected(tile_rect).translated(-tile_rect.topLeft());
+
+    for (auto y = area.top(); y <= area.bottom(); ++y)
+    {
+        auto line = reinterpret_cast<QRgb *>(tile.scanLine(y));
+        std::fill(line + area.left(), line + area.right() + 1, color);
+    }
+}
+
+void save_pixel_tree(const tree::NodeTree &nt, const char *path, int compression)
+{
+    if (nt.nodeCount() == 0)
+    {
+        print("Error: nothing to draw into \"{}\"", path);
+        return;
+    }
+
+    /// same as in PtCanvas
+    constexpr int pixel_size = 4;
+
+    const int slices = (nt.nodeCount() + compression - 1) / compression;
+
+    /// the root is at depth 1 (row 0 is only taken by solution lines)
+    const QSize size{pixel_size * slices, pixel_size * (nt.depth() + 1)};
+
+    /// pixels are not to be split between tiles
+    const int tile_size = utils::TiledImageWriter::DEFAULT_TILE_SIZE / pixel_size * pixel_size;
+    const int slices_per_tile = tile_size / pixel_size;
+
+    utils::TiledImageWriter writer(path, size, tile_size);
+
+    if (writer.rows() > 1 || writer.columns() > 1)
+    {
+        print("saving pixel tree as {}x{} tiles", writer.rows(), writer.columns());
+    }
+
+    const auto node_color = qRgb(30, 40, 30);
+
+    /// The image is produced one column of tiles at a time, from the
+    /// nodes of the slices it spans; these are taken from the pixel tree
+    /// sequence as it is traversed, so that it never exists as a whole
+    PixelSequenceStream stream(nt);
+    std::vector<PixelItem> items;
+    items.reserve(slices_per_tile * compression);
+
+    for (auto col = 0; col < writer.columns(); ++col)
+    {
+        const int first_slice = col * slices_per_tile;
+        const int end_slice = std::min(slices, first_slice + slices_per_tile);
+
+        items.clear();
+
+        PixelItem item;
+        while (items.size() < static_cast<size_t>((end_slice - first_slice) * compression) && stream.next(item))
+        {
+            items.push_back(item);
+        }
+
+        /// whether each slice has a solution (drawn behind the nodes)
+        std::vector<bool> has_solutions(end_slice - first_slice, false);
+
+        for (auto idx = 0u; idx < items.size(); ++idx)
+        {
+            if (nt.getStatus(items[idx].nid) == tree::NodeStatus::SOLVED)
+            {
+                has_solutions[idx / compression] = true;
+            }
+        }
+
+        for (auto row = 0; row < writer.rows(); ++row)
+        {
+            const auto tile_rect = writer.tileRect(row, col);
+
+            QImage tile(tile_rect.size(), QImage::Format_RGB32);
+            tile.fill(qRgb(255, 255, 255));
+
+            for (auto slice = 0u; slice < has_solutions.size(); ++slice)
+            {
+                if (!has_solutions[slice])
+                    continue;
+
+                const int x = (first_slice + slice) * pixel_size;
+                fill_tile_rect(tile, tile_rect, QRect(x, 0, pixel_size, nt.depth() * pixel_size), colors::solution);
+            }
+
+            for (auto idx = 0u; idx < items.size(); ++idx)
+            {
+                const int x = (first_slice + idx / compression) * pixel_size;
+                const int y = items[idx].depth * pixel_size;
+                fill_tile_rect(tile, tile_rect, QRect(x, y, pixel_size, pixel_size), node_color);
+            }
+
+            if (!writer.write(row, col, tile))
+                return;
+        }
+    }
+}
+
+std::vector<PixelItem> PtCanvas::constructPixelTree() const
+{
+    return pixel_sequence(tree_);
+}
+
+int PtCanvas::totalSlices() const
+{
+    return total_slices(pi_seq_, compression_);
+}
+
+void PtCanvas::redrawAll(bool all)
+{
+    pimage_->clear();
+
+    drawPixelTree(all);
+
+    {
+        const auto total_width = totalSlices();
+        /// how many "pixels" fit in one page
+        const auto page_width = pwidget_->width();
+
+        /// Note: page width is 1 smaller for the purpose of calculating the srollbar range,
+        /// than it is for drawing (this way some "pixels" can be drawn partially at the edge)
+        pwidget_->horizontalScrollBar()->setRange(0, total_width - (page_width - 1));
+        pwidget_->horizontalScrollBar()->setPageStep(page_width);
+    }
+
+    pimage_->update();
+    pwidget_->viewport()->update();
+}
+
+void PtCanvas::drawPixelTree(bool all)
+{
+
+    static int times_called = 0;
+
+    times_called++;
+
+    // print("draw pixel tree: {}", times_called);
+
+    /// which vertical slice to draw at x = 0
+    const auto v_begin = all ? 0 : pwidget_->horizontalScrollBar()->value();
+    /// how many slices are visible
+    const auto visible_slices = pwidget_->width();
+    const auto v_end = all ? totalSlices() : v_begin + visible_slices;
+
+    draw_slices(tree_, pi_seq_, *pimage_, compression_, v_begin, v_end, selected_slices_, dark_mode_);
+}
+
 void PtCanvas::selectNodes(int vbegin, int vend)
 {
 
@@ -31,6 +31,11 @@ struct PixelItem
 
 class PixelImage;
 
+/// Draw the whole pixel tree of `nt` into an image file at `path`
+/// without creating any widgets; large trees are saved as several tiles
+/// (see `utils::TiledImageWriter`), drawn one at a time
+void save_pixel_tree(const tree::NodeTree &nt, const char *path, int compression);
+
 class PtCanvas : public QWidget
 {
     Q_OBJECT
@@ -8,25 +8,48 @@
 #include <thread>
 #include <chrono>
 #include <QTcpSocket>
+#include <QLocalSocket>
 #include "utils/debug.hh"
 
 namespace cpprofiler
 {
 
-ReceiverThread::ReceiverThread(intptr_t socket_desc, const Settings &s)
-    : m_socket_desc(socket_desc), m_settings(s)
+ReceiverThread::ReceiverThread(intptr_t socket_desc, const Settings &s, ReceiverSource source,
+                               const std::string &capture_path)
+    : m_socket_desc(socket_desc), m_source(source), m_settings(s), m_capture_path(capture_path)
 {
     std::cerr << "socket descriptor: " << socket_desc << std::endl;
 
     qRegisterMetaType<MessageWrapper>();
+    qRegisterMetaType<MessageBatch>();
 }
 
 void ReceiverThread::run()
 {
 
-    QTcpSocket socket;
+    std::unique_ptr<QIODevice> socket;
+    bool res = false;
 
-    m_worker.reset(new ReceiverWorker{socket, m_settings});
+    if (m_source == ReceiverSource::Tcp)
+    {
+        auto tcp_socket = new QTcpSocket;
+        socket.reset(tcp_socket);
+        res = tcp_socket->setSocketDescriptor(m_socket_desc);
+    }
+    else
+    {
+        auto local_socket = new QLocalSocket;
+        socket.reset(local_socket);
+        res = local_socket->setSocketDescriptor(m_socket_desc);
+    }
+
+    const bool shared_memory = m_source == ReceiverSource::SharedMemory;
+    m_worker.reset(new ReceiverWorker{*socket, m_settings, shared_memory});
+
+    if (!m_capture_path.empty())
+    {
+        m_worker->recordTo(m_capture_path);
+    }
 
     /// propagate the signal further upwards;
     /// blocking connection is used to ensure that the execution is created
@@ -34,14 +57,12 @@ void ReceiverThread::run()
     connect(m_worker.get(), &ReceiverWorker::notifyStart,
             this, &ReceiverThread::notifyStart, Qt::BlockingQueuedConnection);
 
-    connect(m_worker.get(), &ReceiverWorker::newNode,
-            this, &ReceiverThread::newNode);
+    connect(m_worker.get(), &ReceiverWorker::newNodes,
+            this, &ReceiverThread::newNodes);
 
     connect(m_worker.get(), &ReceiverWorker::doneReceiving,
             this, &ReceiverThread::doneReceiving);
 
-    auto res = socket.setSocketDescriptor(m_socket_desc);
-
     if (!res)
     {
         std::cerr << "invalid socket descriptor\n";
@@ -49,11 +70,22 @@ void ReceiverThread::run()
         return;
     }
 
-    connect(&socket, &QTcpSocket::readyRead, m_worker.get(), &ReceiverWorker::doRead);
+    connect(socket.get(), &QIODevice::readyRead, m_worker.get(), &ReceiverWorker::doRead);
 
-    connect(&socket, &QTcpSocket::disconnected, [this]() {
+    /// whatever is still buffered (or in the ring) was sent before disconnecting
+    const auto on_disconnected = [this]() {
+        m_worker->doRead();
         this->quit();
-    });
+    };
+
+    if (m_source == ReceiverSource::Tcp)
+    {
+        connect(static_cast<QTcpSocket *>(socket.get()), &QTcpSocket::disconnected, on_disconnected);
+    }
+    else
+    {
+        connect(static_cast<QLocalSocket *>(socket.get()), &QLocalSocket::disconnected, on_disconnected);
+    }
 
     exec();
 }
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <QThread>
 
 #include "message_wrapper.hh"
@@ -15,24 +16,39 @@ class Execution;
 class ReceiverWorker;
 class Settings;
 
+/// How a solver is connected to the profiler
+enum class ReceiverSource
+{
+    Tcp,
+    /// Unix domain socket
+    Local,
+    /// Shared memory ring announced (and rung) over a Unix domain socket
+    SharedMemory
+};
+
 class ReceiverThread : public QThread
 {
     Q_OBJECT
     const intptr_t m_socket_desc;
+    const ReceiverSource m_source;
     std::unique_ptr<ReceiverWorker> m_worker;
 
     const Settings &m_settings;
 
+    /// Where to record the received frames (nothing is recorded if empty)
+    const std::string m_capture_path;
+
     void run() override;
 
   signals:
 
     void notifyStart(const std::string &ex_name, int ex_id, bool restarts);
-    void newNode(const cpprofiler::MessageWrapper& node);
+    void newNodes(const cpprofiler::MessageBatch& nodes);
     void doneReceiving();
 
   public:
-    ReceiverThread(intptr_t socket_desc, const Settings &s);
+    ReceiverThread(intptr_t socket_desc, const Settings &s, ReceiverSource source = ReceiverSource::Tcp,
+                   const std::string &capture_path = "");
     ~ReceiverThread();
 };
 
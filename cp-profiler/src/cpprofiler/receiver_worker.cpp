@@ -3,7 +3,7 @@
 #include <iostream>
 #include <string>
 #include <thread>
-#include <QTcpSocket>
+#include <QIODevice>
 #include <QJsonObject>
 #include <QJsonDocument>
 
@@ -12,79 +12,157 @@
 
 #include "tree/node.hh"
 #include "settings.hh"
+#include "stream_capture.hh"
+
+#include "../cpp-integration/shm_ring.hpp"
 
 namespace cpprofiler
 {
 
-ReceiverWorker::ReceiverWorker(QTcpSocket &socket, const Settings &s)
-    : m_socket(socket), m_settings(s)
+ReceiverWorker::ReceiverWorker(QIODevice &socket, const Settings &s, bool shared_memory)
+    : m_socket(socket), m_shared_memory(shared_memory), m_settings(s)
 {
 }
 
-static int32_t ArrayToInt(const QByteArray &ba)
+ReceiverWorker::~ReceiverWorker() = default;
+
+void ReceiverWorker::recordTo(const std::string &path)
 {
-    const char *p = ba.data();
-    return *(reinterpret_cast<const quint32 *>(p));
+    m_capture.reset(new CaptureWriter(path));
+
+    if (!m_capture->isOpen())
+    {
+        print("Warning: could not open capture file {}", path);
+        m_capture.reset();
+    }
 }
 
-void ReceiverWorker::doRead()
+void ReceiverWorker::openRing(const std::string &name)
 {
-    // are there enough bytes to read something
-    bool can_read_more = true;
+#ifndef WIN32
+    m_ring.reset(new ShmRing);
 
-    while (m_socket.bytesAvailable() > 0 || can_read_more)
+    if (!m_ring->open(name))
     {
+        print("Error: could not open shared memory ring {}", name);
+        m_ring.reset();
+        m_socket.close();
+        return;
+    }
 
-        if (m_socket.bytesAvailable() > 0)
-            can_read_more = true;
+    /// the solver only needs the name until the ring is opened
+    m_ring->unlink();
+#endif
 
-        m_buffer.append(m_socket.readAll());
+    /// anything after the name on the socket is a doorbell
+    m_frames.clear();
+}
 
-        // read the size of the next field if haven't already
-        if (!m_state.size_read)
-        {
+bool ReceiverWorker::ringOpen() const
+{
+#ifndef WIN32
+    return m_ring != nullptr;
+#else
+    return false;
+#endif
+}
 
-            if (m_buffer.size() < m_state.bytes_read + FIELD_SIZE_NBYTES)
-            {
-                /// can't read, need to wait for more bytes
-                can_read_more = false;
-                continue;
-            }
+qint64 ReceiverWorker::readBytes(char *dest, qint64 max)
+{
+#ifndef WIN32
+    if (m_ring)
+    {
+        while (true)
+        {
+            const auto n = m_ring->read(dest, static_cast<size_t>(max));
+            if (n > 0)
+                return static_cast<qint64>(n);
 
-            /// enough bytes to read size
-            m_state.msg_size = ArrayToInt(m_buffer.mid(m_state.bytes_read, 4));
-            m_state.bytes_read += 4;
-            m_state.size_read = true;
+            /// ring is empty: ask for the doorbell unless something just arrived
+            if (m_ring->prepareWait())
+                return 0;
         }
-        else
+    }
+#endif
+
+    if (m_socket.bytesAvailable() <= 0)
+        return 0;
+
+    return m_socket.read(dest, max);
+}
+
+void ReceiverWorker::doRead()
+{
+    if (ringOpen())
+    {
+        /// only doorbells arrive over the socket once the ring is open
+        m_socket.readAll();
+    }
+
+    while (true)
+    {
+        FrameView frame;
+
+        /// handle all complete messages before reading more bytes,
+        /// as reading may move the unread tail of the buffer
+        while (m_frames.nextFrame(frame))
         {
+            if (m_shared_memory && !ringOpen())
+            {
+                openRing(std::string(frame.data, static_cast<size_t>(frame.size)));
+                break;
+            }
 
-            if (m_buffer.size() < m_state.bytes_read + m_state.msg_size)
+            if (m_capture)
             {
-                /// can't read, need to wait for more bytes
-                can_read_more = false;
-                continue;
+                m_capture->write(frame.data, frame.size);
             }
 
-            marshalling.deserialize(m_buffer.data() + m_state.bytes_read, m_state.msg_size);
+            marshalling.deserialize(frame.data, frame.size);
 
-            auto msg = marshalling.get_msg();
+            const auto &msg = marshalling.get_msg();
             handleMessage(msg);
+        }
 
-            m_state.bytes_read += m_state.msg_size;
-            m_state.size_read = false;
+        char *dest = m_frames.writePtr();
+        const auto n = readBytes(dest, static_cast<qint64>(m_frames.writable()));
 
-            m_state.msg_processed++;
+        if (n <= 0)
+            break;
 
-            /// reset the buffer every MSG_PER_BUFFER messages
-            if (m_state.msg_processed == MSG_PER_BUFFER)
-            {
-                m_state.msg_processed = 0;
-                m_buffer.remove(0, m_state.bytes_read);
-                m_state.bytes_read = 0;
-            }
-        }
+        m_frames.commit(n);
     }
+
+    /// No more bytes for now: there is no point holding on to the nodes
+    flushBatch();
+}
+
+void ReceiverWorker::addToBatch(const Message &msg)
+{
+    if (m_batch.empty())
+    {
+        m_batch.reserve(m_settings.receiver_batch_size);
+        m_batch_timer.start();
+    }
+
+    m_batch.push_back(msg);
+
+    if (m_batch.size() >= static_cast<size_t>(m_settings.receiver_batch_size) ||
+        m_batch_timer.elapsed() >= m_settings.receiver_batch_ms)
+    {
+        flushBatch();
+    }
+}
+
+void ReceiverWorker::flushBatch()
+{
+    if (m_batch.empty())
+        return;
+
+    emit newNodes(m_batch);
+
+    /// the builder now shares the old batch, start a fresh one
+    m_batch = MessageBatch{};
 }
 
 void ReceiverWorker::handleStart(const Message &msg)
@@ -132,7 +210,15 @@ void ReceiverWorker::handleStart(const Message &msg)
         }
     }
 
-    print("New execution: (name: {}, exec_id: {}, has restarts: {}", execution_name, exec_id, has_restarts);
+    /// the marshalling has already switched to the announced protocol version
+    const int version = msg.has_version() ? msg.version() : PROFILER_PROTOCOL_VERSION_V3;
+
+    if (version > PROFILER_PROTOCOL_VERSION)
+    {
+        print("Warning: solver uses protocol version {}, newer than {}", version, PROFILER_PROTOCOL_VERSION);
+    }
+
+    print("New execution: (name: {}, exec_id: {}, has restarts: {}, protocol: {}", execution_name, exec_id, has_restarts, version);
 
     emit notifyStart(execution_name, exec_id, has_restarts); // blocking connection
 }
@@ -156,8 +242,7 @@ void ReceiverWorker::handleMessage(const Message &msg)
 
         try
         {
-            MessageWrapper m(msg);
-            emit newNode(m);
+            addToBatch(msg);
         }
         catch (std::exception &e)
         {
@@ -166,14 +251,18 @@ void ReceiverWorker::handleMessage(const Message &msg)
         break;
     case cpprofiler::MsgType::START:
         print("message: start");
+        flushBatch();
         handleStart(msg);
         break;
     case cpprofiler::MsgType::DONE:
+        /// make sure the builder gets all nodes before the done signal
+        flushBatch();
         emit doneReceiving();
         print("message: done");
         break;
     case cpprofiler::MsgType::RESTART:
         print("message: restart");
+        flushBatch();
         break;
     default:
         print("ERROR: unknown solver message");
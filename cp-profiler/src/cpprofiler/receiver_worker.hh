@@ -2,11 +2,13 @@
 #define CPPROFILER_RECEIVER_WORKER_HH
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <memory>
 
 #include "message_wrapper.hh"
+#include "frame_buffer.hh"
 
-class QTcpSocket;
+class QIODevice;
 
 namespace cpprofiler
 {
@@ -14,51 +16,75 @@ namespace cpprofiler
 class Conductor;
 class Execution;
 class Settings;
+#ifndef WIN32
+class ShmRing;
+#endif
+class CaptureWriter;
 
 class ReceiverWorker : public QObject
 {
     Q_OBJECT
 
-    /// number of messages to read before resetting the buffer
-    static constexpr int MSG_PER_BUFFER = 10000;
-    /// the number of bytes per field size
-    static constexpr int FIELD_SIZE_NBYTES = 4;
+    /// read buffer split into length-prefixed messages
+    FrameBuffer m_frames;
+
+    QIODevice &m_socket;
+
+    /// Whether messages arrive through a shared memory ring (whose name is
+    /// the first message on the socket) rather than the socket itself
+    const bool m_shared_memory;
+
+#ifndef WIN32
+    /// (shared memory rings are not available on Windows)
+    std::unique_ptr<ShmRing> m_ring;
+#endif
+
+    /// Whether the shared memory ring has been opened
+    bool ringOpen() const;
 
-    /// read buffer
-    QByteArray m_buffer;
+    /// If set, every received frame is also written to a capture file
+    std::unique_ptr<CaptureWriter> m_capture;
 
-    QTcpSocket &m_socket;
+    /// Open the ring named in the first message of a shared memory connection
+    void openRing(const std::string &name);
 
-    struct ReadState
-    {
-        /// whether the size has been read
-        bool size_read = false;
-        // size of the current message in bytes
-        int msg_size = 0;
-        /// messages processed since last buffer reset
-        int msg_processed = 0;
-        /// where to read next from in the buffer
-        int bytes_read = 0;
-    } m_state;
+    /// Read up to `max` bytes from the socket or the ring
+    qint64 readBytes(char *dest, qint64 max);
 
     // Execution* execution;
 
     cpprofiler::MessageMarshalling marshalling;
 
+    /// Node messages not yet handed over to the builder
+    MessageBatch m_batch;
+
+    /// Started when the first node of the current batch is received
+    QElapsedTimer m_batch_timer;
+
     void handleStart(const cpprofiler::Message &msg);
 
     void handleMessage(const cpprofiler::Message &msg);
 
+    /// Add a node message to the current batch, flushing it if it is full/old enough
+    void addToBatch(const cpprofiler::Message &msg);
+
+    /// Hand all accumulated node messages over to the builder
+    void flushBatch();
+
     const Settings &m_settings;
 
   signals:
 
     void notifyStart(const std::string &ex_name, int ex_id, bool restarts);
-    void newNode(const cpprofiler::MessageWrapper& node);
+    void newNodes(const cpprofiler::MessageBatch& nodes);
     void doneReceiving();
 
   public:
-    ReceiverWorker(QTcpSocket &socket, const Settings &s);
+    ReceiverWorker(QIODevice &socket, const Settings &s, bool shared_memory = false);
+    ~ReceiverWorker();
+
+    /// Record all frames received from now on into the capture file at `path`
+    void recordTo(const std::string &path);
   public slots:
     void doRead();
 };
@@ -0,0 +1,132 @@
+#include "replay.hh"
+
+#include "stream_capture.hh"
+#include "execution.hh"
+
+#include "tree/node_tree.hh"
+#include "tree/layout.hh"
+#include "tree/layout_computer.hh"
+#include "tree/visual_flags.hh"
+
+#include "utils/debug.hh"
+
+#include "../cpp-integration/connector.hpp"
+
+#include <chrono>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+namespace cpprofiler
+{
+
+/// Number of frames sent with a single write when replaying as fast as possible
+static constexpr int REPLAY_BATCH = 256;
+
+/// Peak resident set size of this process in KB (0 if unknown)
+static long peak_rss_kb()
+{
+#ifndef WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+Replay::Replay(const std::string &path, unsigned int port, double speed)
+    : m_path(path), m_port(port), m_speed(speed)
+{
+}
+
+Replay::~Replay()
+{
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void Replay::start()
+{
+    m_timer.begin();
+    m_thread = std::thread(&Replay::run, this);
+}
+
+void Replay::run()
+{
+    CaptureReader reader(m_path);
+
+    if (!reader.isValid())
+    {
+        print("Error: {} is not a capture file", m_path);
+        return;
+    }
+
+    Connector connector(m_port);
+    connector.connect(Transport::TCP);
+
+    if (!connector.connected())
+    {
+        print("Error: replay could not connect to port {}", m_port);
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    CaptureRecord record;
+    int frames = 0;
+
+    while (reader.next(record))
+    {
+        if (m_speed > 0)
+        {
+            const auto due = start + std::chrono::microseconds(
+                                         static_cast<int64_t>(record.time_us / m_speed));
+            if (due > std::chrono::steady_clock::now())
+            {
+                connector.flush();
+                std::this_thread::sleep_until(due);
+            }
+        }
+
+        ++frames;
+        connector.sendRawMsg(record.data, frames % REPLAY_BATCH == 0);
+    }
+
+    connector.flush();
+    connector.disconnect();
+
+    print("replay: sent {} frames from {}", frames, m_path);
+}
+
+void Replay::report(Execution &ex)
+{
+    const auto ingest_ms = m_timer.end();
+
+    auto &tree = ex.tree();
+    const auto nodes = tree.nodeCount();
+    const auto per_sec = ingest_ms > 0 ? (static_cast<int64_t>(nodes) * 1000) / ingest_ms : 0;
+
+    print("replay: {} nodes in {}ms ({} nodes/sec)", nodes, ingest_ms, per_sec);
+
+    tree::VisualFlags vis_flags;
+    tree::Layout layout;
+    tree::LayoutComputer layout_computer(tree, layout, vis_flags);
+
+    perf_helper::Timer layout_timer;
+    layout_timer.begin();
+    layout_computer.compute();
+    print("replay: layout computed in {}ms", layout_timer.end());
+
+    print("replay: peak RSS {} KB", peak_rss_kb());
+}
+
+} // namespace cpprofiler
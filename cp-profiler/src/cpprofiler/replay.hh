@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <thread>
+
+#include "utils/perf_helper.hh"
+
+namespace cpprofiler
+{
+
+class Execution;
+
+/// Plays a capture file (see stream_capture.hh) back to the profiler,
+/// connecting to it the same way a solver would
+class Replay
+{
+    const std::string m_path;
+
+    const unsigned int m_port;
+
+    /// 1 replays at the recorded timing, 2 twice as fast etc.;
+    /// 0 sends everything as fast as possible
+    const double m_speed;
+
+    std::thread m_thread;
+
+    /// Started when the replay starts
+    perf_helper::Timer m_timer;
+
+    void run();
+
+  public:
+    Replay(const std::string &path, unsigned int port, double speed = 0);
+
+    /// Waits for all frames to be sent
+    ~Replay();
+
+    void start();
+
+    /// Print the ingest rate, peak memory usage and layout time for `ex`,
+    /// whose tree has just been built from the replayed frames
+    void report(Execution &ex);
+};
+
+} // namespace cpprofiler
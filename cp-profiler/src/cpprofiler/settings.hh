@@ -8,6 +8,10 @@ class Settings
 public:
     /// delay in ms after receiving a new message
     int receiver_delay = 0;
+    /// max number of nodes the receiver accumulates before handing them to the builder
+    int receiver_batch_size = 4096;
+    /// max time in ms a node can wait in the receiver's batch before it is handed over
+    int receiver_batch_ms = 30;
     int auto_hide_failed = true;
 };
 
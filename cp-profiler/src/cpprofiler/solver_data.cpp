@@ -60,49 +60,77 @@ static std::vector<SolverID> parse_nogoods_json(QJsonValue &json_arr)
     return res;
 }
 
-void SolverData::processInfo(NodeID nid, const std::string &info_str)
+SolverData::ParsedInfo SolverData::parseInfo(const std::string &info_str)
 {
+    ParsedInfo result;
+
     auto info_bytes = QByteArray::fromStdString(info_str);
     QJsonParseError json_err;
     auto json_doc = QJsonDocument::fromJson(info_bytes, &json_err);
 
     if (json_err.error != QJsonParseError::NoError) {
         print("QJsonDocument::fromJson() error: {}\ninfo_str:\n {}\n", json_err.errorString(), info_str);
-        return;
+        return result;
     }
 
     if (json_doc.isNull() || json_doc.isEmpty())
     {
-        print("no info for node {}", nid);
-        return;
+        return result;
     }
 
-    setInfo(nid, info_str);
+    result.valid = true;
 
     QJsonObject json_obj = json_doc.object();
 
     if (json_obj.isEmpty())
     {
-        return;
+        return result;
     }
 
     auto reasons = json_obj.value("reasons");
     if (reasons.isArray())
     {
-        auto constraints = parse_reasons_json(reasons);
-        // print("constraints for {}: {}", nid, constraints);
-        contrib_cs_.insert({nid, std::move(constraints)});
+        result.has_reasons = true;
+        result.reasons = parse_reasons_json(reasons);
     }
 
     auto nogoods_json = json_obj.value("nogoods");
     if (nogoods_json.isArray())
     {
-        auto nogoods = parse_nogoods_json(nogoods_json);
+        result.has_nogoods = true;
+        result.nogoods = parse_nogoods_json(nogoods_json);
+    }
+
+    return result;
+}
+
+void SolverData::processInfo(NodeID nid, const std::string &info_str)
+{
+    setParsedInfo(nid, info_str, parseInfo(info_str));
+}
+
+void SolverData::setParsedInfo(NodeID nid, const std::string &info_str, ParsedInfo &&info)
+{
+    if (!info.valid)
+    {
+        print("no info for node {}", nid);
+        return;
+    }
+
+    setInfo(nid, info_str);
 
+    if (info.has_reasons)
+    {
+        // print("constraints for {}: {}", nid, info.reasons);
+        contrib_cs_.insert(nid, info.reasons);
+    }
+
+    if (info.has_nogoods)
+    {
         /// Nogoods contributing to the failure at `nid`
         std::vector<NodeID> c_nogoods;
 
-        for (const auto sid : nogoods)
+        for (const auto sid : info.nogoods)
         {
             auto ng_nid = getNodeId(sid);
 
@@ -114,25 +142,170 @@ void SolverData::processInfo(NodeID nid, const std::string &info_str)
 
         // print("responsible nogoods for {}: {}", nid, c_nogoods);
 
-        contrib_ngs_.insert({nid, std::move(c_nogoods)});
+        contrib_ngs_.insert(nid, c_nogoods);
     }
 }
 
+Nogood SolverData::getNogood(NodeID nid) const
+{
+    const auto orig = nogoods_.get(nid);
+
+    if (orig.empty())
+    {
+        return Nogood::empty;
+    }
+
+    std::string orig_str(orig.begin(), orig.end());
+
+    if (renamed_nogoods_.contains(nid))
+    {
+        const auto renamed = renamed_nogoods_.get(nid);
+        return Nogood(orig_str, std::string(renamed.begin(), renamed.end()));
+    }
+
+    return Nogood(orig_str);
+}
+
+SolverData::MemoryUsage SolverData::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.id_map = m_id_map.memoryUsage();
+    usage.info = info_.memoryUsage();
+    usage.nogoods = nogoods_.memoryUsage() + renamed_nogoods_.memoryUsage();
+    usage.contrib_cs = contrib_cs_.memoryUsage();
+    usage.contrib_ngs = contrib_ngs_.memoryUsage();
+    usage.node_time = node_time_.memoryUsage();
+    return usage;
+}
+
+/// Solver node numbers further than this beyond the last one seen
+/// for the same (rid, tid) are not stored densely
+static constexpr int32_t MAX_DENSE_GAP = 1 << 16;
+
+/// Thread and restart ids further than this beyond the largest one seen so far
+/// are not stored densely: the tables are sized by the largest ids, so a solver
+/// sending huge (rather than consecutive) ids could otherwise make them grow to match
+static constexpr int32_t MAX_DENSE_ID_GAP = 1024;
+
+/// Whether `sid` may be stored in `IdMap::dense_`
+static bool fits_dense(SolverID sid)
+{
+    return sid.nid >= 0 && sid.rid >= -1 && sid.tid >= -1;
+}
+
+std::vector<NodeID> *IdMap::denseIds(SolverID sid)
+{
+    if (!fits_dense(sid))
+        return nullptr;
+
+    const auto t = static_cast<size_t>(sid.tid + 1);
+    const auto r = static_cast<size_t>(sid.rid + 1);
+
+    if (t >= dense_.size())
+    {
+        if (t - dense_.size() > static_cast<size_t>(MAX_DENSE_ID_GAP))
+            return nullptr;
+        dense_.resize(t + 1);
+    }
+
+    auto &by_rid = dense_[t];
+
+    if (r >= by_rid.size())
+    {
+        if (r - by_rid.size() > static_cast<size_t>(MAX_DENSE_ID_GAP))
+            return nullptr;
+        by_rid.resize(r + 1);
+    }
+
+    auto &ids = by_rid[r];
+
+    if (sid.nid - static_cast<int64_t>(ids.size()) > MAX_DENSE_GAP)
+        return nullptr;
+
+    return &ids;
+}
+
+const std::vector<NodeID> *IdMap::denseIds(SolverID sid) const
+{
+    if (!fits_dense(sid))
+        return nullptr;
+
+    const auto t = static_cast<size_t>(sid.tid + 1);
+    const auto r = static_cast<size_t>(sid.rid + 1);
+
+    if (t >= dense_.size() || r >= dense_[t].size())
+        return nullptr;
+
+    return &dense_[t][r];
+}
+
 void IdMap::addPair(SolverID sid, tree::NodeID nid)
 {
-    QWriteLocker locker(&m_lock);
+    auto ids = denseIds(sid);
+
+    if (ids)
+    {
+        const auto idx = static_cast<size_t>(sid.nid);
+        if (idx >= ids->size())
+        {
+            ids->resize(idx + 1, NodeID::NoNode);
+        }
+        (*ids)[idx] = nid;
+    }
+    else
+    {
+        sparse_[sid] = nid;
+    }
+
+    if (nid >= 0)
+    {
+        const auto idx = static_cast<size_t>(nid);
+        if (idx >= nid2uid_.size())
+        {
+            nid2uid_.resize(idx + 1, SolverID{-1, -1, -1});
+        }
+        nid2uid_[idx] = sid;
+    }
+}
+
+size_t IdMap::memoryUsage() const
+{
+    size_t bytes = dense_.capacity() * sizeof(dense_[0]) + nid2uid_.capacity() * sizeof(SolverID);
 
-    uid2id_.insert({sid, nid});
-    nid2uid_.insert({nid, sid});
+    for (const auto &by_rid : dense_)
+    {
+        bytes += by_rid.capacity() * sizeof(by_rid[0]);
+
+        for (const auto &ids : by_rid)
+        {
+            bytes += ids.capacity() * sizeof(NodeID);
+        }
+    }
+
+    /// one node and one bucket per entry
+    bytes += sparse_.size() * (sizeof(SolverID) + sizeof(NodeID) + 2 * sizeof(void *)) +
+             sparse_.bucket_count() * sizeof(void *);
+
+    return bytes;
 }
 
 tree::NodeID IdMap::get(SolverID sid) const
 {
-    QReadLocker locker(&m_lock);
+    const auto ids = denseIds(sid);
+
+    if (ids && static_cast<size_t>(sid.nid) < ids->size())
+    {
+        const auto nid = (*ids)[static_cast<size_t>(sid.nid)];
+        if (nid != NodeID::NoNode)
+            return nid;
+    }
+
+    if (sparse_.empty())
+        return NodeID::NoNode;
 
-    const auto it = uid2id_.find(sid);
+    const auto it = sparse_.find(sid);
 
-    if (it != uid2id_.end())
+    if (it != sparse_.end())
     {
         return it->second;
     }
@@ -142,4 +315,4 @@ tree::NodeID IdMap::get(SolverID sid) const
     }
 }
 
-} // namespace cpprofiler
\ No newline at end of file
+} // namespace cpprofiler
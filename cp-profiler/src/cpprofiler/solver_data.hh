@@ -1,38 +1,55 @@
 #pragma once
 
-#include <QReadWriteLock>
 #include <unordered_map>
+#include <vector>
 
 #include "core.hh"
 
 #include "solver_id.hh"
+#include "sparse_column.hh"
 
 namespace cpprofiler
 {
 
 class NameMap;
 
+/// Two-way mapping between solver ids and node ids
+///
+/// Solver node numbers are dense within each (restart, thread) pair, so each
+/// pair gets a flat vector indexed by node number; ids that don't fit that
+/// scheme (negative or far beyond what has been seen) go to `sparse_`.
+/// The map has no lock of its own: it is written by the builder while it
+/// holds the tree mutex, like the rest of the tree data.
 class IdMap
 {
+    /// Node ids for each solver node number, indexed by [tid + 1][rid + 1]
+    std::vector<std::vector<std::vector<NodeID>>> dense_;
 
-    mutable QReadWriteLock m_lock;
+    std::unordered_map<SolverID, NodeID> sparse_;
 
-    std::unordered_map<SolverID, NodeID> uid2id_;
+    /// Solver ids indexed by node id
+    std::vector<SolverID> nid2uid_;
 
-    std::unordered_map<NodeID, SolverID> nid2uid_;
+    /// The vector to store `sid` in (created if necessary),
+    /// or nullptr if `sid` should go to `sparse_`
+    std::vector<NodeID> *denseIds(SolverID sid);
+
+    /// The vector `sid` would be stored in if it exists
+    const std::vector<NodeID> *denseIds(SolverID sid) const;
 
   public:
     void addPair(SolverID, NodeID);
 
+    /// Memory (in bytes) reserved by the map
+    size_t memoryUsage() const;
+
     NodeID get(SolverID) const;
 
     SolverID getUID(NodeID nid) const
     {
-        auto it = nid2uid_.find(nid);
-
-        if (it != nid2uid_.end())
+        if (nid >= 0 && static_cast<size_t>(nid) < nid2uid_.size())
         {
-            return nid2uid_.at(nid);
+            return nid2uid_[nid];
         }
         else
         {
@@ -47,20 +64,53 @@ class SolverData
     /// TODO:save/load id map to/from DB
     IdMap m_id_map;
 
-    std::unordered_map<NodeID, Info> info_map_;
+    SparseColumn<char> info_;
+
+    /// Nogoods as sent by the solver
+    SparseColumn<char> nogoods_;
 
-    std::unordered_map<NodeID, Nogood> nogood_map_;
+    /// Nogoods rewritten with a name map (only for those that have one)
+    SparseColumn<char> renamed_nogoods_;
 
     /// Constraints contributing to a no-good at NodeID
-    std::unordered_map<NodeID, std::vector<int>> contrib_cs_;
+    SparseColumn<int> contrib_cs_;
 
     /// Nogoods contributing to the failure at node NodeID
-    std::unordered_map<NodeID, std::vector<NodeID>> contrib_ngs_;
+    SparseColumn<NodeID> contrib_ngs_;
 
     /// Time since the beginning of solving process;
-    std::unordered_map<NodeID, int> node_time_;
+    SparseColumn<int> node_time_;
 
   public:
+    /// Node info parsed from JSON; doesn't depend on any other data, so it
+    /// can be produced on any thread before the node is added
+    struct ParsedInfo
+    {
+        bool valid = false;
+        bool has_reasons = false;
+        std::vector<int> reasons;
+        bool has_nogoods = false;
+        std::vector<SolverID> nogoods;
+    };
+
+    /// Memory (in bytes) taken by each kind of data
+    struct MemoryUsage
+    {
+        size_t id_map;
+        size_t info;
+        size_t nogoods;
+        size_t contrib_cs;
+        size_t contrib_ngs;
+        size_t node_time;
+
+        size_t total() const
+        {
+            return id_map + info + nogoods + contrib_cs + contrib_ngs + node_time;
+        }
+    };
+
+    static ParsedInfo parseInfo(const std::string &info_str);
+
     NodeID getNodeId(SolverID sid) const
     {
         return m_id_map.get(sid);
@@ -77,82 +127,64 @@ class SolverData
     }
 
     /// Get the reasons (constraint ids) for the nogood at node `nid`
-    const std::vector<int> *getContribConstraints(NodeID nid) const
+    SparseColumn<int>::View getContribConstraints(NodeID nid) const
     {
-        const auto it = contrib_cs_.find(nid);
-
-        if (it == contrib_cs_.end())
-            return nullptr;
-        return &(it->second);
+        return contrib_cs_.get(nid);
     }
 
     /// Get nogoods (identified by the NodeID where they were created)
     /// that contribute to the failure at `nid`;
-    const std::vector<NodeID> *getContribNogoods(NodeID nid) const
+    SparseColumn<NodeID>::View getContribNogoods(NodeID nid) const
     {
-        const auto it = contrib_ngs_.find(nid);
-
-        if (it == contrib_ngs_.end())
-            return nullptr;
-        return &(it->second);
+        return contrib_ngs_.get(nid);
     }
 
     /// Associate nogood `ng` with node `nid`
     void setNogood(NodeID nid, const std::string &orig, const std::string &renamed)
     {
-        nogood_map_.insert({nid, Nogood(orig, renamed)});
+        if (nogoods_.insert(nid, orig.data(), orig.size()))
+        {
+            renamed_nogoods_.insert(nid, renamed.data(), renamed.size());
+        }
     }
 
     void setNogood(NodeID nid, const std::string &orig)
     {
-        nogood_map_.insert({nid, Nogood(orig)});
+        nogoods_.insert(nid, orig.data(), orig.size());
     }
 
-    const Nogood &getNogood(NodeID nid) const
-    {
-        auto it = nogood_map_.find(nid);
-        if (it != nogood_map_.end())
-        {
-            return it->second;
-        }
-        else
-        {
-            return Nogood::empty;
-        }
-    }
+    Nogood getNogood(NodeID nid) const;
 
     void setInfo(NodeID nid, const std::string &orig)
     {
-        info_map_.insert({nid, Info(orig)});
+        info_.insert(nid, orig.data(), orig.size());
     }
 
     Info getInfo(NodeID nid) const
     {
-        auto it = info_map_.find(nid);
-        if (it != info_map_.end())
-        {
-            return it->second;
-        }
-        else
-        {
-            return Info("");
-        }
+        const auto info = info_.get(nid);
+        return Info(info.begin(), info.end());
     }
 
     /// Process node info looking for reasons, contributing nogoods for failed nodes etc.
     void processInfo(NodeID nid, const std::string &info_str);
 
+    /// Same as `processInfo`, for info already parsed with `parseInfo`
+    void setParsedInfo(NodeID nid, const std::string &info_str, ParsedInfo &&info);
+
     /// Whether the data stores at least one no-good
     bool hasNogoods() const
     {
-        return !nogood_map_.empty();
+        return !nogoods_.empty();
     }
 
     /// Whether the data stores at least one no-good
     bool hasInfo() const
     {
-        return !info_map_.empty();
+        return !info_.empty();
     }
+
+    MemoryUsage memoryUsage() const;
 };
 
 } // namespace cpprofiler
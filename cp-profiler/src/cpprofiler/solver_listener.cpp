@@ -0,0 +1,139 @@
+#include "solver_listener.hh"
+#include "tcp_server.hh"
+#include "local_server.hh"
+#include "receiver_thread.hh"
+
+#include <iostream>
+#include <QThread>
+
+#include "execution.hh"
+#include "tree_builder.hh"
+
+#include "utils/string_utils.hh"
+
+namespace cpprofiler
+{
+
+constexpr quint16 SolverListener::DEFAULT_PORT;
+
+SolverListener::SolverListener(const Settings &settings, ExecutionFactory create_execution, std::string record_path)
+    : settings_(settings), create_execution_(std::move(create_execution)), record_path_(std::move(record_path))
+{
+    server_.reset(new TcpServer([this](intptr_t socketDesc) {
+        acceptConnection(socketDesc, ReceiverSource::Tcp);
+    }));
+
+    listen_port_ = DEFAULT_PORT;
+
+    // See if the default port is available
+    if (!server_->listen(QHostAddress::Any, listen_port_))
+    {
+        // If not, try any port
+        server_->listen(QHostAddress::Any, 0);
+        listen_port_ = server_->serverPort();
+    }
+
+    std::cerr << "Ready to listen on: " << listen_port_ << std::endl;
+
+    listenLocal();
+}
+
+SolverListener::~SolverListener() = default;
+
+void SolverListener::listenLocal()
+{
+#ifdef Q_OS_UNIX
+    const auto path = LocalServer::socketPath(listen_port_);
+
+    local_server_.reset(new LocalServer([this](intptr_t socketDesc) {
+        acceptConnection(socketDesc, ReceiverSource::Local);
+    }));
+
+    shm_server_.reset(new LocalServer([this](intptr_t socketDesc) {
+        acceptConnection(socketDesc, ReceiverSource::SharedMemory);
+    }));
+
+    local_server_->listenAt(path);
+    shm_server_->listenAt(path + ".shm");
+#endif
+}
+
+std::string SolverListener::nextCapturePath()
+{
+    if (record_path_ == "")
+        return "";
+
+    /// further connections go to "<name>-<count>.<ext>"
+    return utils::numbered_path(record_path_, capture_count_++);
+}
+
+void SolverListener::acceptConnection(intptr_t socket_desc, ReceiverSource source)
+{
+    emit connectionAccepted();
+
+    /// Initiate a receiver thread
+    auto receiver = new ReceiverThread(socket_desc, settings_, source, nextCapturePath());
+    /// Delete the receiver one the thread is finished
+    connect(receiver, &QThread::finished, receiver, &QObject::deleteLater);
+
+    connect(receiver, &QThread::finished, this, &SolverListener::connectionClosed);
+
+    /// Handle the start message on this thread (the receiver waits for it)
+    connect(receiver, &ReceiverThread::notifyStart, this,
+            [this, receiver](const std::string &ex_name, int ex_id, bool restarts) {
+                handleStart(receiver, ex_name, ex_id, restarts);
+            });
+
+    receiver->start();
+}
+
+void SolverListener::handleStart(ReceiverThread *receiver, const std::string &ex_name, int ex_id, bool restarts)
+{
+    /// other connections of a parallel solver join the execution with the same id
+    if (ex_id == 0 || builders_.find(ex_id) == builders_.end())
+    {
+        auto ex = create_execution_(ex_name, ex_id, restarts);
+        ex_id = ex->id();
+
+        /// The builder should only be created for a new execution
+        auto builderThread = new QThread();
+        auto builder = new TreeBuilder(*ex);
+
+        builders_[ex_id] = builder;
+        builder->moveToThread(builderThread);
+
+        /// the owner handles built executions on this thread
+        connect(builder, &TreeBuilder::buildingDone, this, [this, ex_id]() {
+            emit buildingDone(ex_id);
+        });
+
+        connect(builderThread, &QThread::finished, builder, &QObject::deleteLater);
+        connect(builderThread, &QThread::finished, builderThread, &QObject::deleteLater);
+
+        builderThread->start();
+    }
+
+    /// obtain the builder aready assigned to this execution
+    ///(either just now or by another connection)
+    auto builder = builders_[ex_id];
+    builder->addReceiver();
+
+    connect(receiver, &ReceiverThread::newNodes,
+            builder, &TreeBuilder::handleBatch);
+
+    connect(receiver, &ReceiverThread::doneReceiving,
+            builder, &TreeBuilder::finishBuilding);
+}
+
+void SolverListener::releaseBuilder(int ex_id)
+{
+    const auto it = builders_.find(ex_id);
+    if (it == builders_.end())
+        return;
+
+    /// the builder goes away with its thread
+    it->second->thread()->quit();
+    builders_.erase(it);
+}
+
+} // namespace cpprofiler
@@ -0,0 +1,102 @@
+#ifndef CPPROFILER_SOLVER_LISTENER_HH
+#define CPPROFILER_SOLVER_LISTENER_HH
+
+#include <QObject>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "core.hh"
+
+namespace cpprofiler
+{
+
+class TcpServer;
+class LocalServer;
+class Execution;
+class ReceiverThread;
+class TreeBuilder;
+class Settings;
+enum class ReceiverSource;
+
+/// Accepts solver connections (over TCP and, on Unix, the local sockets
+/// derived from the port) and feeds each one to the builder of its execution;
+/// used both by Conductor and by HeadlessRunner
+///
+/// The owner decides how executions are created (see `ExecutionFactory`)
+/// and what happens to them once they are built (see `buildingDone`).
+class SolverListener : public QObject
+{
+    Q_OBJECT
+
+  public:
+    /// Create the execution for a solver starting a new one; `ex_id` is the
+    /// id requested by the solver (0 if none), the execution's own id is used
+    using ExecutionFactory =
+        std::function<Execution *(const std::string &ex_name, int ex_id, bool restarts)>;
+
+    static constexpr quint16 DEFAULT_PORT = 6565;
+
+  private:
+    const Settings &settings_;
+
+    ExecutionFactory create_execution_;
+
+    /// Where to record the frames of each connection (empty if not recording)
+    std::string record_path_;
+
+    /// Number of connections recorded so far
+    int capture_count_ = 0;
+
+    /// Port number opened for solvers to connect to
+    quint16 listen_port_;
+
+    std::unique_ptr<TcpServer> server_;
+
+    /// Unix domain socket for solvers on the same machine
+    std::unique_ptr<LocalServer> local_server_;
+
+    /// Same, but the socket only announces a shared memory ring
+    std::unique_ptr<LocalServer> shm_server_;
+
+    /// a map from exec_id to its builder
+    std::unordered_map<int, TreeBuilder *> builders_;
+
+    /// Also accept solvers on the Unix domain sockets derived from the port
+    void listenLocal();
+
+    /// Start receiving from a newly connected solver
+    void acceptConnection(intptr_t socket_desc, ReceiverSource source);
+
+    void handleStart(ReceiverThread *receiver, const std::string &ex_name, int ex_id, bool restarts);
+
+    /// Where to record the frames of the next connection (empty if not recording)
+    std::string nextCapturePath();
+
+  public:
+    /// Listen on the default port (or any port if it is taken)
+    SolverListener(const Settings &settings, ExecutionFactory create_execution, std::string record_path);
+
+    ~SolverListener();
+
+    quint16 port() const { return listen_port_; }
+
+    /// Stop the builder (and its thread) of execution `ex_id` once it is built
+    void releaseBuilder(int ex_id);
+
+  signals:
+
+    /// A solver connected
+    void connectionAccepted();
+
+    /// A solver's connection is done (its receiver is finished)
+    void connectionClosed();
+
+    /// Execution `ex_id` is built (all of its connections are done)
+    void buildingDone(int ex_id);
+};
+
+} // namespace cpprofiler
+
+#endif
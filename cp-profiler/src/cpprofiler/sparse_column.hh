@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "tree/node_id.hh"
+
+namespace cpprofiler
+{
+
+/// Variable-length values (strings, lists of ints) attached to some of
+/// the nodes of a tree
+///
+/// Node ids are kept in a sorted vector with each value's position in one
+/// shared arena, so an entry costs 16 bytes plus its elements. Values are
+/// expected to arrive (mostly) in node id order, which makes `insert` an
+/// append; an out-of-order id shifts the index but never the arena.
+/// `T` must be trivially copyable.
+template <typename T>
+class SparseColumn
+{
+    using NodeID = tree::NodeID;
+
+    /// Nodes that have a value, in increasing order
+    std::vector<NodeID> ids_;
+    /// Position of each node's value in `arena_`
+    std::vector<uint64_t> offsets_;
+    /// Number of elements in each node's value
+    std::vector<uint32_t> lengths_;
+
+    std::vector<T> arena_;
+
+    /// Index of `nid` in `ids_` or -1 if absent
+    int64_t indexOf(NodeID nid) const
+    {
+        if (ids_.empty())
+            return -1;
+
+        /// Ids without gaps can be indexed directly
+        const int64_t guess = static_cast<int64_t>(nid) - static_cast<int64_t>(ids_.front());
+        if (guess >= 0 && static_cast<size_t>(guess) < ids_.size() && ids_[guess] == nid)
+            return guess;
+
+        const auto it = std::lower_bound(ids_.begin(), ids_.end(), nid);
+        if (it == ids_.end() || *it != nid)
+            return -1;
+
+        return it - ids_.begin();
+    }
+
+  public:
+    /// Read-only view of one value (invalidated by `insert`)
+    class View
+    {
+        const T *data_ = nullptr;
+        size_t size_ = 0;
+
+      public:
+        View() = default;
+        View(const T *data, size_t size) : data_(data), size_(size) {}
+
+        const T *begin() const { return data_; }
+        const T *end() const { return data_ + size_; }
+
+        const T &operator[](size_t i) const { return data_[i]; }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        std::vector<T> toVector() const { return std::vector<T>(begin(), end()); }
+    };
+
+    /// Set the value for `nid` unless it already has one;
+    /// returns false if the value was not set
+    bool insert(NodeID nid, const T *data, size_t size)
+    {
+        auto pos = ids_.size();
+
+        if (!ids_.empty() && nid <= ids_.back())
+        {
+            const auto it = std::lower_bound(ids_.begin(), ids_.end(), nid);
+            if (*it == nid)
+                return false;
+            pos = it - ids_.begin();
+        }
+
+        ids_.insert(ids_.begin() + pos, nid);
+        offsets_.insert(offsets_.begin() + pos, arena_.size());
+        lengths_.insert(lengths_.begin() + pos, static_cast<uint32_t>(size));
+        arena_.insert(arena_.end(), data, data + size);
+
+        return true;
+    }
+
+    bool insert(NodeID nid, const std::vector<T> &value)
+    {
+        return insert(nid, value.data(), value.size());
+    }
+
+    bool contains(NodeID nid) const { return indexOf(nid) >= 0; }
+
+    /// The value for `nid` (empty if there is none)
+    View get(NodeID nid) const
+    {
+        const auto idx = indexOf(nid);
+
+        if (idx < 0)
+            return {};
+
+        return {arena_.data() + offsets_[idx], lengths_[idx]};
+    }
+
+    /// Number of nodes with a value
+    size_t size() const { return ids_.size(); }
+
+    bool empty() const { return ids_.empty(); }
+
+    /// Memory (in bytes) reserved by the column
+    size_t memoryUsage() const
+    {
+        return ids_.capacity() * sizeof(NodeID) +
+               offsets_.capacity() * sizeof(uint64_t) +
+               lengths_.capacity() * sizeof(uint32_t) +
+               arena_.capacity() * sizeof(T);
+    }
+};
+
+} // namespace cpprofiler
@@ -0,0 +1,71 @@
+#include "stream_capture.hh"
+
+#include <cstring>
+
+namespace cpprofiler
+{
+
+constexpr char CaptureWriter::MAGIC[];
+constexpr size_t CaptureWriter::MAGIC_SIZE;
+
+CaptureWriter::CaptureWriter(const std::string &path)
+    : m_out(path, std::ios::binary | std::ios::trunc)
+{
+    if (m_out.is_open())
+    {
+        m_out.write(MAGIC, MAGIC_SIZE);
+    }
+}
+
+void CaptureWriter::write(const char *data, int32_t size)
+{
+    if (!isOpen())
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (!m_started)
+    {
+        m_start = now;
+        m_started = true;
+    }
+
+    const int64_t time_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - m_start).count();
+
+    m_out.write(reinterpret_cast<const char *>(&time_us), sizeof(time_us));
+    m_out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    m_out.write(data, size);
+}
+
+CaptureReader::CaptureReader(const std::string &path)
+    : m_in(path, std::ios::binary)
+{
+    char magic[CaptureWriter::MAGIC_SIZE];
+
+    if (m_in.read(magic, sizeof(magic)))
+    {
+        m_valid = std::memcmp(magic, CaptureWriter::MAGIC, sizeof(magic)) == 0;
+    }
+}
+
+bool CaptureReader::next(CaptureRecord &record)
+{
+    if (!m_valid)
+        return false;
+
+    int32_t size = 0;
+
+    if (!m_in.read(reinterpret_cast<char *>(&record.time_us), sizeof(record.time_us)) ||
+        !m_in.read(reinterpret_cast<char *>(&size), sizeof(size)) || size < 0)
+    {
+        return false;
+    }
+
+    record.data.resize(static_cast<size_t>(size));
+
+    /// a truncated last record (e.g. the profiler was killed) is dropped
+    return static_cast<bool>(m_in.read(record.data.data(), size));
+}
+
+} // namespace cpprofiler
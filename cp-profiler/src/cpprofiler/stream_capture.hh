@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace cpprofiler
+{
+
+/// A `.cpplog` capture file starts with `MAGIC`, followed by one record
+/// per received frame: the time since the first frame (int64, microseconds),
+/// the frame size (int32) and the frame itself, exactly as it was received.
+
+/// A frame read back from a capture file
+struct CaptureRecord
+{
+    int64_t time_us = 0;
+    std::vector<char> data;
+};
+
+/// Records every frame received from a solver into a capture file
+class CaptureWriter
+{
+    std::ofstream m_out;
+
+    std::chrono::steady_clock::time_point m_start;
+
+    bool m_started = false;
+
+  public:
+    static constexpr char MAGIC[] = "CPPLOG01";
+    static constexpr size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+
+    explicit CaptureWriter(const std::string &path);
+
+    bool isOpen() const { return m_out.is_open() && m_out.good(); }
+
+    void write(const char *data, int32_t size);
+};
+
+/// Reads frames back from a capture file
+class CaptureReader
+{
+    std::ifstream m_in;
+
+    bool m_valid = false;
+
+  public:
+    explicit CaptureReader(const std::string &path);
+
+    /// Whether the file exists and starts with `CaptureWriter::MAGIC`
+    bool isValid() const { return m_valid; }
+
+    /// Read the next record; returns false at the end of the file
+    bool next(CaptureRecord &record);
+};
+
+} // namespace cpprofiler
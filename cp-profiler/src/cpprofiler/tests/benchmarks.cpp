@@ -0,0 +1,772 @@
+#include "benchmarks.hh"
+
+#include "../execution.hh"
+#include "../tree_builder.hh"
+#include "../message_wrapper.hh"
+#include "../frame_buffer.hh"
+#include "../solver_data.hh"
+#include "../tree/node_tree.hh"
+#include "../tree/structure.hh"
+#include "../tree/layout.hh"
+#include "../tree/layout_computer.hh"
+#include "../tree/visual_flags.hh"
+#include "../tree/node_drawing.hh"
+#include "../tree/cursors/drawing_cursor.hh"
+#include "../tree/cursors/nodevisitor.hh"
+#include "../utils/tree_utils.hh"
+#include "../config.hh"
+
+#include "../utils/perf_helper.hh"
+#include "../utils/debug.hh"
+
+#include "../../cpp-integration/connector.hpp"
+
+#include <QImage>
+#include <QPainter>
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef WIN32
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+namespace cpprofiler
+{
+namespace tests
+{
+namespace benchmarks
+{
+
+/// Node messages (in the order a solver would send them) describing
+/// a complete binary tree of depth `depth`
+static std::vector<Message> binary_tree_messages(int depth)
+{
+    std::vector<Message> msgs;
+    MessageMarshalling mm;
+
+    struct Item
+    {
+        int nid;
+        int pid;
+        int alt;
+        int depth;
+    };
+
+    std::queue<Item> queue;
+    queue.push({0, -1, -1, 1});
+
+    int next_nid = 1;
+
+    while (!queue.empty())
+    {
+        const auto item = queue.front();
+        queue.pop();
+
+        const bool is_leaf = item.depth == depth;
+        const int kids = is_leaf ? 0 : 2;
+        const auto status = is_leaf ? FAILED : BRANCH;
+
+        auto &msg = mm.makeNode({item.nid, 0, 0}, {item.pid, 0, 0}, item.alt, kids, status);
+        msg.set_label("x[" + std::to_string(item.depth) + "]=" + std::to_string(item.alt));
+        msgs.push_back(msg);
+
+        for (auto alt = 0; alt < kids; ++alt)
+        {
+            queue.push({next_nid++, item.nid, alt, item.depth + 1});
+        }
+    }
+
+    return msgs;
+}
+
+static void report(const char *name, size_t nodes, int64_t ms)
+{
+    const auto per_sec = ms > 0 ? (nodes * 1000) / ms : 0;
+    print("{}: {} nodes in {}ms ({} nodes/sec)", name, nodes, ms, per_sec);
+}
+
+/// Compare building the tree one node at a time against building it in batches
+static void ingest_batching(int depth, int batch_size)
+{
+    const auto msgs = binary_tree_messages(depth);
+
+    {
+        Execution ex("one node at a time");
+        TreeBuilder builder(ex);
+
+        perf_helper::Timer timer;
+        timer.begin();
+        for (const auto &msg : msgs)
+        {
+            builder.handleNode(MessageWrapper{msg});
+        }
+        report("handleNode", msgs.size(), timer.end());
+    }
+
+    {
+        Execution ex("batched");
+        TreeBuilder builder(ex);
+
+        perf_helper::Timer timer;
+        timer.begin();
+
+        MessageBatch batch;
+        for (const auto &msg : msgs)
+        {
+            batch.push_back(msg);
+            if (batch.size() == static_cast<size_t>(batch_size))
+            {
+                builder.handleBatch(batch);
+                batch = MessageBatch{};
+            }
+        }
+        builder.handleBatch(batch);
+
+        report("handleBatch", msgs.size(), timer.end());
+    }
+}
+
+/// Build the tree from messages as a parallel search with `threads` workers
+/// would send them: nodes are spread across solver threads and carry info
+static void parallel_ingest(int depth, int threads, int batch_size)
+{
+    auto msgs = binary_tree_messages(depth);
+
+    for (auto &msg : msgs)
+    {
+        auto n_uid = msg.nodeUID();
+        auto p_uid = msg.parentUID();
+        n_uid.tid = n_uid.nid % threads;
+        if (p_uid.nid != -1)
+            p_uid.tid = p_uid.nid % threads;
+        msg.set_nodeUID(n_uid);
+        msg.set_parentUID(p_uid);
+        msg.set_info("{\"reasons\": [" + std::to_string(n_uid.nid) + ", 1, 2]}");
+    }
+
+    Execution ex("parallel ingest");
+    TreeBuilder builder(ex);
+
+    perf_helper::Timer timer;
+    timer.begin();
+
+    MessageBatch batch;
+    for (const auto &msg : msgs)
+    {
+        batch.push_back(msg);
+        if (batch.size() == static_cast<size_t>(batch_size))
+        {
+            builder.handleBatch(batch);
+            batch = MessageBatch{};
+        }
+    }
+    builder.handleBatch(batch);
+
+    const auto name = "parallel_ingest (" + std::to_string(threads) + " threads)";
+    report(name.c_str(), msgs.size(), timer.end());
+}
+
+/// Insert and look up `count` solver ids spread across `threads` solver threads
+static void id_map_lookup(int count, int threads)
+{
+    IdMap id_map;
+
+    perf_helper::Timer timer;
+    timer.begin();
+
+    for (auto i = 0; i < count; ++i)
+    {
+        id_map.addPair({i / threads, 0, i % threads}, NodeID{i});
+    }
+
+    int found = 0;
+    for (auto i = 0; i < count; ++i)
+    {
+        if (id_map.get({i / threads, 0, i % threads}) == NodeID{i})
+            ++found;
+    }
+
+    report("id_map", static_cast<size_t>(found), timer.end());
+}
+
+/// Memory per node of the tree structure and the time of a full post-order traversal
+static void structure_traversal(int depth)
+{
+    {
+        tree::Structure structure;
+        structure.createRoot(2);
+
+        /// children of node n are created after all nodes before them
+        for (auto nid = 1; nid < structure.nodeCount(); ++nid)
+        {
+            if (nid < (1 << (depth - 1)) - 1)
+                structure.addChildren(NodeID{nid}, 2);
+        }
+
+        const auto nodes = structure.nodeCount();
+        print("structure: {} nodes, {} bytes per node", nodes,
+              static_cast<double>(structure.memoryUsage()) / nodes);
+    }
+
+    const auto msgs = binary_tree_messages(depth);
+
+    Execution ex("traversal");
+    TreeBuilder builder(ex);
+
+    MessageBatch batch;
+    for (const auto &msg : msgs)
+        batch.push_back(msg);
+    builder.handleBatch(batch);
+
+    perf_helper::Timer timer;
+    timer.begin();
+    const auto order = utils::post_order(ex.tree());
+    report("post_order", order.size(), timer.end());
+}
+
+/// Memory taken by the labels of a tree: interned vs one string per node
+static void label_memory(int depth)
+{
+    const auto msgs = binary_tree_messages(depth);
+
+    Execution ex("labels");
+    TreeBuilder builder(ex);
+
+    MessageBatch batch;
+    for (const auto &msg : msgs)
+        batch.push_back(msg);
+    builder.handleBatch(batch);
+
+    const auto &nt = ex.tree();
+    const auto nodes = static_cast<size_t>(nt.nodeCount());
+
+    size_t per_node = 0;
+    for (const auto &msg : msgs)
+    {
+        const auto &label = msg.label();
+        per_node += sizeof(Label);
+        if (label.size() >= sizeof(Label))
+            per_node += label.size() + 1;
+    }
+
+    const auto interned = nt.labelPool().memoryUsage() + nodes * sizeof(tree::LabelID);
+
+    print("labels: {} distinct, {} bytes per node (strings: {})", nt.labelPool().size(),
+          static_cast<double>(interned) / nodes, static_cast<double>(per_node) / nodes);
+}
+
+/// Memory and lookup time of solver data for a trace where every node has a nogood
+static void solver_data_memory(int count)
+{
+    SolverData sd;
+
+    for (auto i = 0; i < count; ++i)
+    {
+        const NodeID nid{i};
+        sd.setNogood(nid, "X_INTRODUCED_" + std::to_string(i) + " >= 1 \\/ x[" + std::to_string(i % 100) + "] <= 3");
+        sd.processInfo(nid, "{\"reasons\": [1, 2, " + std::to_string(i % 50) + "], \"nogoods\": []}");
+    }
+
+    const auto usage = sd.memoryUsage();
+    print("solver data: {} bytes per node (nogoods: {}, reasons: {})",
+          static_cast<double>(usage.total()) / count,
+          static_cast<double>(usage.nogoods) / count,
+          static_cast<double>(usage.contrib_cs) / count);
+
+    perf_helper::Timer timer;
+    timer.begin();
+    size_t found = 0;
+    for (auto i = 0; i < count; ++i)
+    {
+        found += sd.getNogood(NodeID{i}).original().size() > 0;
+        found += sd.getContribConstraints(NodeID{i}).size();
+    }
+    report("solver_data", found, timer.end());
+}
+
+/// Subtree queries on a finished tree before and after it is frozen
+static void frozen_queries(int depth)
+{
+    const auto msgs = binary_tree_messages(depth);
+
+    Execution ex("frozen");
+    TreeBuilder builder(ex);
+
+    MessageBatch batch;
+    for (const auto &msg : msgs)
+        batch.push_back(msg);
+    builder.handleBatch(batch);
+
+    auto &nt = ex.tree();
+
+    const auto queries = [&nt]() {
+        size_t total = 0;
+        total += utils::pre_order(nt).size();
+        total += utils::nodes_below(nt, nt.getRoot()).size();
+        total += utils::calc_subtree_sizes(nt)[0];
+        return total;
+    };
+
+    const auto growable = nt.structureMemoryUsage();
+
+    perf_helper::Timer timer;
+    timer.begin();
+    report("subtree_queries", queries(), timer.end());
+
+    timer.begin();
+    nt.setDone();
+    report("freeze", static_cast<size_t>(nt.nodeCount()), timer.end());
+
+    timer.begin();
+    report("frozen_subtree_queries", queries(), timer.end());
+
+    print("structure: {} bytes per node (frozen: {})",
+          static_cast<double>(growable) / nt.nodeCount(),
+          static_cast<double>(nt.structureMemoryUsage()) / nt.nodeCount());
+}
+
+/// Full layout of a finished tree on one thread and in parallel
+static void parallel_layout(int depth)
+{
+    const auto msgs = binary_tree_messages(depth);
+
+    Execution ex("layout");
+    TreeBuilder builder(ex);
+
+    MessageBatch batch;
+    for (const auto &msg : msgs)
+        batch.push_back(msg);
+    builder.handleBatch(batch);
+
+    ex.tree().setDone();
+
+    tree::VisualFlags vf;
+
+    for (const auto parallel : {false, true})
+    {
+        tree::Layout layout;
+        tree::LayoutComputer lc(ex.tree(), layout, vf);
+        lc.setParallel(parallel);
+
+        perf_helper::Timer timer;
+        timer.begin();
+        lc.compute();
+        report(parallel ? "parallel_layout" : "sequential_layout",
+               static_cast<size_t>(ex.tree().nodeCount()), timer.end());
+    }
+}
+
+/// Layout of a finished, entirely failed tree with all labels shown: subtrees
+/// at the same depth are identical, so nearly all shapes come from the cache
+static void shape_sharing(int depth)
+{
+    const auto msgs = binary_tree_messages(depth);
+
+    Execution ex("shapes");
+    TreeBuilder builder(ex);
+
+    MessageBatch batch;
+    for (const auto &msg : msgs)
+        batch.push_back(msg);
+    builder.handleBatch(batch);
+
+    ex.tree().setDone();
+
+    const auto nodes = ex.tree().nodeCount();
+
+    tree::VisualFlags vf;
+    for (auto nid = 0; nid < nodes; ++nid)
+    {
+        vf.setLabelShown(NodeID{nid}, true);
+    }
+
+    tree::Layout layout;
+    tree::LayoutComputer lc(ex.tree(), layout, vf);
+
+    perf_helper::Timer timer;
+    timer.begin();
+    lc.compute();
+    report("shape_sharing", static_cast<size_t>(nodes), timer.end());
+
+    const auto &cache = layout.shapeCache();
+    print("shape cache: {} lookups, hit rate {}%, layout memory: {} bytes/node",
+          cache.lookups(), static_cast<int>(cache.hitRate() * 100),
+          static_cast<double>(layout.memoryUsage()) / nodes);
+}
+
+/// Drawing a whole finished tree (squeezed into an image, so that every
+/// node is drawn) one node at a time and with nodes batched by type
+static void paint_tree(int depth)
+{
+    const auto msgs = binary_tree_messages(depth);
+
+    Execution ex("paint");
+    TreeBuilder builder(ex);
+
+    MessageBatch batch;
+    for (const auto &msg : msgs)
+        batch.push_back(msg);
+    builder.handleBatch(batch);
+
+    ex.tree().setDone();
+
+    tree::VisualFlags vf;
+    tree::Layout layout;
+    tree::LayoutComputer lc(ex.tree(), layout, vf);
+    lc.compute();
+
+    const auto root = ex.tree().getRoot();
+    const auto &bb = layout.getBoundingBox(root);
+    const auto width = bb.right - bb.left;
+    const auto height = (layout.getHeight(root) + 1) * tree::layout::dist_y;
+
+    const QRect clip{QPoint{0, 0}, QSize{width, height}};
+
+    QImage image(4096, 1024, QImage::Format_ARGB32_Premultiplied);
+
+    for (const auto batched : {false, true})
+    {
+        image.fill(Qt::white);
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.scale(static_cast<double>(image.width()) / width, static_cast<double>(image.height()) / height);
+        painter.setPen(Qt::black);
+
+        tree::draw::NodeBatch nodes;
+
+        perf_helper::Timer timer;
+        timer.begin();
+
+        tree::DrawingCursor dc(root, ex.tree(), layout, ex.userData(), vf, painter, QPoint{-bb.left, 0}, clip,
+                               false, false, 0, batched ? &nodes : nullptr);
+        tree::PreorderNodeVisitor<tree::DrawingCursor>(dc).run();
+        nodes.flush(painter);
+
+        report(batched ? "batched_paint" : "per_node_paint", static_cast<size_t>(ex.tree().nodeCount()), timer.end());
+    }
+}
+
+/// The bytes a solver would send for `msgs` (each message prefixed by its size)
+/// using protocol `version`
+static std::vector<char> byte_stream(const std::vector<Message> &msgs, int version)
+{
+    std::vector<char> stream;
+    MessageMarshalling mm;
+    mm.set_protocol_version(version);
+
+    for (const auto &msg : msgs)
+    {
+        auto &copy = mm.makeNode(msg.nodeUID(), msg.parentUID(), msg.alt(), msg.kids(), msg.status());
+        if (msg.has_label())
+            copy.set_label(msg.label());
+
+        const auto data = mm.serialize();
+        const auto size = static_cast<int32_t>(data.size());
+
+        const auto *size_bytes = reinterpret_cast<const char *>(&size);
+        stream.insert(stream.end(), size_bytes, size_bytes + sizeof(size));
+        stream.insert(stream.end(), data.begin(), data.end());
+    }
+
+    return stream;
+}
+
+/// Replay a recorded byte stream through the receiver's framing layer,
+/// `chunk` bytes at a time (as if read from a socket)
+static void framing_throughput(int depth, size_t chunk, int version)
+{
+    const auto stream = byte_stream(binary_tree_messages(depth), version);
+
+    FrameBuffer frames;
+    MessageMarshalling mm;
+    mm.set_protocol_version(version);
+
+    size_t msg_count = 0;
+    size_t offset = 0;
+
+    perf_helper::Timer timer;
+    timer.begin();
+
+    while (offset < stream.size())
+    {
+        char *dest = frames.writePtr();
+        const auto n = std::min({chunk, frames.writable(), stream.size() - offset});
+        std::memcpy(dest, stream.data() + offset, n);
+        frames.commit(n);
+        offset += n;
+
+        FrameView frame;
+        while (frames.nextFrame(frame))
+        {
+            mm.deserialize(frame.data, frame.size);
+            ++msg_count;
+        }
+    }
+
+    const auto ms = timer.end();
+
+    report("framing", msg_count, ms);
+    print("framing (v{}): {} bytes ({} per node), {} MB/s", version, stream.size(),
+          msg_count > 0 ? stream.size() / msg_count : 0, ms > 0 ? (stream.size() / 1000) / ms : 0);
+}
+
+#ifndef WIN32
+/// A listening socket that a `Connector` using `transport` will connect to;
+/// for local transports `port` is only used to derive the socket path
+static int listen_for(Transport transport, unsigned int &port)
+{
+    if (transport == Transport::TCP)
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t addr_len = sizeof(addr);
+
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), addr_len) != 0 || listen(fd, 1) != 0 ||
+            getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &addr_len) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+
+        port = ntohs(addr.sin_port);
+        return fd;
+    }
+
+    port = 40000 + static_cast<unsigned int>(getpid()) % 20000;
+    const auto path = Connector::localSocketPath(port) + (transport == Transport::SHM ? ".shm" : "");
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        return -1;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    unlink(path.c_str());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 1) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/// Time spent inside the solver process per node sent through `Connector`
+/// (with `batch_size` nodes per write) to a local socket that discards everything
+static void connector_overhead(int depth, int batch_size)
+{
+    const auto msgs = binary_tree_messages(depth);
+
+    unsigned int port = 0;
+    const int listen_fd = listen_for(Transport::TCP, port);
+
+    if (listen_fd == -1)
+    {
+        print("connector_overhead: could not open a local socket");
+        return;
+    }
+
+    std::thread drain([listen_fd]() {
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        std::vector<char> buf(1 << 16);
+        while (fd >= 0 && recv(fd, buf.data(), buf.size(), 0) > 0)
+        {
+        }
+        close(fd);
+    });
+
+    Connector connector(port);
+    connector.set_batch_size(batch_size);
+    connector.connect(Transport::TCP);
+    connector.start("connector_overhead");
+
+    perf_helper::Timer timer;
+    timer.begin();
+
+    for (const auto &msg : msgs)
+    {
+        auto node = connector.createNode(msg.nodeUID(), msg.parentUID(), msg.alt(), msg.kids(), msg.status());
+        node.set_label(msg.label());
+        node.send();
+    }
+    connector.done();
+
+    const auto ms = timer.end();
+
+    connector.disconnect();
+    drain.join();
+    close(listen_fd);
+
+    print("connector (batch size {}): {} nodes in {}ms ({} ns per node)", batch_size, msgs.size(), ms,
+          msgs.size() > 0 ? (ms * 1000000) / static_cast<int64_t>(msgs.size()) : 0);
+}
+
+/// Receive and parse everything a connector sends over `fd` the way
+/// ReceiverWorker does; returns the number of messages parsed
+static size_t consume(int fd, bool shared_memory)
+{
+    FrameBuffer frames;
+    MessageMarshalling mm;
+    ShmRing ring;
+
+    size_t msg_count = 0;
+    bool closed = false;
+
+    while (true)
+    {
+        FrameView frame;
+        while (frames.nextFrame(frame))
+        {
+            if (shared_memory && !ring.valid())
+            {
+                if (!ring.open(std::string(frame.data, static_cast<size_t>(frame.size))))
+                    return msg_count;
+                ring.unlink();
+                frames.clear();
+                break;
+            }
+
+            mm.deserialize(frame.data, frame.size);
+            ++msg_count;
+        }
+
+        char *dest = frames.writePtr();
+        ssize_t n = 0;
+
+        if (ring.valid())
+        {
+            n = static_cast<ssize_t>(ring.read(dest, frames.writable()));
+            if (n == 0)
+            {
+                if (closed)
+                    break;
+                if (ring.prepareWait())
+                {
+                    /// sleep until the doorbell (or the solver disconnecting)
+                    char bells[64];
+                    closed = recv(fd, bells, sizeof(bells), 0) <= 0;
+                }
+                continue;
+            }
+        }
+        else
+        {
+            n = recv(fd, dest, frames.writable(), 0);
+            if (n <= 0)
+                break;
+        }
+
+        frames.commit(static_cast<size_t>(n));
+    }
+
+    return msg_count;
+}
+
+/// End-to-end ingest rate (solver sending to profiler parsing) over `transport`
+static void transport_ingest(int depth, Transport transport)
+{
+    static const char *names[] = {"default", "tcp", "uds", "shm"};
+    const char *name = names[static_cast<int>(transport)];
+
+    const auto msgs = binary_tree_messages(depth);
+
+    unsigned int port = 0;
+    const int listen_fd = listen_for(transport, port);
+
+    if (listen_fd == -1)
+    {
+        print("transport_ingest: could not listen for {}", name);
+        return;
+    }
+
+    const auto socket_path = Connector::localSocketPath(port) + (transport == Transport::SHM ? ".shm" : "");
+
+    perf_helper::Timer timer;
+    timer.begin();
+
+    Connector connector(port);
+    connector.connect(transport);
+
+    /// the connector falls back to TCP on some other port, so nothing
+    /// would ever arrive at `listen_fd`
+    if (connector.transport() != transport)
+    {
+        print("transport_ingest: could not connect using {}, skipping", name);
+        connector.disconnect();
+        close(listen_fd);
+        if (transport != Transport::TCP)
+        {
+            unlink(socket_path.c_str());
+        }
+        return;
+    }
+
+    size_t received = 0;
+    std::thread consumer([listen_fd, transport, &received]() {
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        received = consume(fd, transport == Transport::SHM);
+        close(fd);
+    });
+
+    connector.start("transport_ingest");
+    for (const auto &msg : msgs)
+    {
+        auto node = connector.createNode(msg.nodeUID(), msg.parentUID(), msg.alt(), msg.kids(), msg.status());
+        node.set_label(msg.label());
+        node.send();
+    }
+    connector.done();
+    connector.disconnect();
+    consumer.join();
+
+    const auto ms = timer.end();
+
+    close(listen_fd);
+    if (transport != Transport::TCP)
+    {
+        unlink(socket_path.c_str());
+    }
+
+    report(name, received, ms);
+}
+#endif
+
+void run()
+{
+    // ingest_batching(20, 4096);
+    // parallel_ingest(18, 1, 4096);
+    // parallel_ingest(18, 16, 4096);
+    // id_map_lookup(10000000, 16);
+    // structure_traversal(22);
+    // label_memory(20);
+    // solver_data_memory(1000000);
+    // frozen_queries(22);
+    // parallel_layout(22);
+    // shape_sharing(20);
+    // paint_tree(20);
+    // framing_throughput(20, 64 * 1024, 3);
+    // framing_throughput(20, 64 * 1024, PROFILER_PROTOCOL_VERSION);
+#ifndef WIN32
+    // connector_overhead(20, 1);
+    // connector_overhead(20, 256);
+    // transport_ingest(20, Transport::TCP);
+    // transport_ingest(20, Transport::UDS);
+    // transport_ingest(20, Transport::SHM);
+#endif
+}
+
+} // namespace benchmarks
+} // namespace tests
+} // namespace cpprofiler
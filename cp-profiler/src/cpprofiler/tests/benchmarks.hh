@@ -0,0 +1,19 @@
+#ifndef CPPROFILER_TESTS_BENCHMARKS_HH
+#define CPPROFILER_TESTS_BENCHMARKS_HH
+
+namespace cpprofiler
+{
+
+namespace tests
+{
+
+namespace benchmarks
+{
+void run();
+}
+
+} // namespace tests
+
+} // namespace cpprofiler
+
+#endif
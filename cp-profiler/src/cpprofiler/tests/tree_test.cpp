@@ -1,5 +1,7 @@
 #include "../tree/node_tree.hh"
 #include "../tree/structure.hh"
+#include "../tree/frozen_structure.hh"
+#include "../solver_data.hh"
 
 #include "../utils/array.hh"
 #include "../utils/debug.hh"
@@ -92,11 +94,80 @@ void growing_tree()
     assert(n3 == str.getChild(root, 2));
 }
 
+void frozen_tree()
+{
+    tree::Structure str;
+
+    const auto root = str.createRoot(2);
+    const auto n1 = str.getChild(root, 0);
+    const auto n2 = str.getChild(root, 1);
+    str.addChildren(n1, 2);
+    const auto n5 = str.addExtraChild(root);
+
+    tree::FrozenStructure frozen(str);
+
+    assert(frozen.nodeCount() == str.nodeCount());
+    assert(frozen.childrenCount(root) == 3);
+    assert(frozen.getChild(root, 2) == n5);
+    assert(frozen.getAlternative(n5) == 2);
+    assert(frozen.getParent(n1) == root);
+
+    /// subtrees are contiguous in pre-order
+    assert(frozen.subtreeSize(root) == 6);
+    assert(frozen.subtreeSize(n1) == 3);
+
+    const auto below_n1 = frozen.subtree(n1);
+    assert(below_n1.size() == 3);
+    assert(below_n1.begin()[0] == n1);
+    assert(below_n1.begin()[1] == str.getChild(n1, 0));
+    assert(below_n1.begin()[2] == str.getChild(n1, 1));
+    assert(*frozen.subtree(n2).begin() == n2);
+}
+
+/// Consecutive restart and thread ids are stored densely however many there are,
+/// ids far beyond them go to the hash map; both have to be found again
+void id_map_ids()
+{
+    IdMap map;
+
+    const int restarts = 5000;
+    const int threads = 2000;
+
+    for (auto rid = 0; rid < restarts; ++rid)
+        map.addPair({0, rid, 0}, tree::NodeID{rid});
+
+    for (auto tid = 0; tid < threads; ++tid)
+        map.addPair({1, 0, tid}, tree::NodeID{restarts + tid});
+
+    map.addPair({2, 1 << 30, 0}, tree::NodeID{restarts + threads});
+    map.addPair({3, 0, 1 << 30}, tree::NodeID{restarts + threads + 1});
+
+    for (auto rid = 0; rid < restarts; ++rid)
+        assert(map.get({0, rid, 0}) == tree::NodeID{rid});
+
+    for (auto tid = 0; tid < threads; ++tid)
+        assert(map.get({1, 0, tid}) == tree::NodeID{restarts + tid});
+
+    assert(map.get({2, 1 << 30, 0}) == tree::NodeID{restarts + threads});
+    assert(map.get({3, 0, 1 << 30}) == tree::NodeID{restarts + threads + 1});
+    assert(map.getUID(tree::NodeID{restarts + threads}).rid == 1 << 30);
+
+    assert(map.get({1, restarts, 0}) == tree::NodeID::NoNode);
+    assert(map.get({0, 1 << 29, 0}) == tree::NodeID::NoNode);
+
+    /// the huge ids did not make the tables grow
+    assert(map.memoryUsage() < 1024 * 1024);
+}
+
 void run()
 {
 
     growing_tree();
 
+    frozen_tree();
+
+    id_map_ids();
+
     // array_usage();
 }
 
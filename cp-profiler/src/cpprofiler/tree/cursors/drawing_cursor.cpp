@@ -15,6 +15,8 @@
 #include <QDebug>
 #include <QPainter>
 
+#include <algorithm>
+
 namespace cpprofiler
 {
 namespace tree
@@ -55,7 +57,9 @@ DrawingCursor::DrawingCursor(NodeID start,
                              QPoint start_pos,
                              const QRect &clip,
                              bool debug,
-                             bool dark_mode)
+                             bool dark_mode,
+                             int lod_width,
+                             draw::NodeBatch *batch)
     : NodeCursor(start, tree),
       layout_(layout),
       user_data_(user_data),
@@ -63,10 +67,21 @@ DrawingCursor::DrawingCursor(NodeID start,
       painter_(painter),
       clippingRect(clip),
       debug_mode_(debug),
-      dark_mode_(dark_mode)
+      dark_mode_(dark_mode),
+      lod_width_(lod_width),
+      batch_(batch)
 {
     cur_x = start_pos.x();
     cur_y = start_pos.y();
+
+    if (lod_width_ > 0)
+    {
+        for (auto nid = user_data.getSelectedNode(); nid != NodeID::NoNode; nid = tree.getParent(nid))
+        {
+            selected_path_.push_back(nid);
+        }
+        std::sort(selected_path_.begin(), selected_path_.end());
+    }
 }
 
 static void drawTriangle(QPainter &painter, int x, int y, bool selected, bool has_gradient, bool has_solutions)
@@ -101,7 +116,7 @@ static void drawTriangle(QPainter &painter, int x, int y, bool selected, bool ha
     painter.drawConvexPolygon(points, 3);
 }
 
-static void drawShape(QPainter &painter, int x, int y, NodeID nid, const Layout &layout)
+void draw_shape(QPainter &painter, int x, int y, NodeID nid, const Layout &layout)
 {
     using namespace traditional;
 
@@ -116,8 +131,10 @@ static void drawShape(QPainter &painter, int x, int y, NodeID nid, const Layout
     const int height = shape.height();
     QPointF *points = new QPointF[height * 2];
 
-    int l_x = x + shape[0].l;
-    int r_x = x + shape[0].r;
+    Shape::Cursor extent(shape);
+
+    int l_x = x + (*extent).l;
+    int r_x = x + (*extent).r;
     y = y + BRANCH_WIDTH / 2;
 
     points[0] = QPointF(l_x, y);
@@ -125,9 +142,10 @@ static void drawShape(QPainter &painter, int x, int y, NodeID nid, const Layout
 
     for (int i = 1; i < height; i++)
     {
+        ++extent;
         y += static_cast<double>(layout::dist_y);
-        l_x = x + shape[i].l;
-        r_x = x + shape[i].r;
+        l_x = x + (*extent).l;
+        r_x = x + (*extent).r;
         points[i] = QPointF(l_x, y);
         points[height * 2 - i - 1] = QPointF(r_x, y);
     }
@@ -140,6 +158,50 @@ static void drawShape(QPainter &painter, int x, int y, NodeID nid, const Layout
     painter.setBrush(old_brush);
 }
 
+/// Fill the contour of the subtree of `nid` at (`x`, `y`) with a colour
+/// summarising the subtree: whether it has solutions and whether it is open
+static void drawSummary(QPainter &painter, int x, int y, NodeID nid, const NodeTree &tree, const Layout &layout)
+{
+    using namespace traditional;
+
+    const bool open = tree.hasOpenChildren(nid);
+    const bool has_solutions = tree.hasSolvedChildren(nid);
+
+    if (has_solutions)
+    {
+        painter.setBrush(open ? colors::lightGreen : colors::green);
+    }
+    else
+    {
+        painter.setBrush(open ? colors::lightBlue : colors::red);
+    }
+
+    auto old_pen = painter.pen();
+    painter.setPen(Qt::NoPen);
+
+    const auto &shape = *layout.getShape(nid);
+    const int height = shape.height();
+
+    /// down the left side of the contour, then up the right one
+    std::vector<QPointF> points(2 * height + 2);
+
+    Shape::Cursor extent(shape);
+    for (int i = 0; i < height; ++i, ++extent)
+    {
+        const auto level_y = y + i * layout::dist_y;
+        points[i] = QPointF(x + (*extent).l, level_y);
+        points[2 * height + 1 - i] = QPointF(x + (*extent).r, level_y);
+    }
+
+    const auto bottom = y + (height - 1) * layout::dist_y + MAX_NODE_W;
+    points[height] = QPointF(points[height - 1].x(), bottom);
+    points[height + 1] = QPointF(points[height + 2].x(), bottom);
+
+    painter.drawPolygon(points.data(), static_cast<int>(points.size()));
+
+    painter.setPen(old_pen);
+}
+
 static void drawBoundingBox(QPainter &painter, int x, int y, NodeID nid, const Layout &layout)
 {
     auto bb = layout.getBoundingBox(nid);
@@ -147,99 +209,142 @@ static void drawBoundingBox(QPainter &painter, int x, int y, NodeID nid, const L
     painter.drawRect(x + bb.left, y, bb.right - bb.left, height);
 }
 
-void DrawingCursor::processCurrentNode()
+void draw_node(QPainter &painter, const NodeTree &tree, const Layout &layout, const UserData &user_data,
+               const VisualFlags &vis_flags, NodeID node, NodeID start, int x, int y, bool debug, bool dark_mode,
+               draw::NodeBatch *batch)
 {
     using namespace traditional;
 
     bool phantom_node = false;
 
-    painter_.setPen(QColor{dark_mode_ ? Qt::white : Qt::black});
-
-    const auto node = cur_node();
+    if (!batch)
+    {
+        painter.setPen(QColor{dark_mode ? Qt::white : Qt::black});
+    }
 
-    if (node != start_node())
+    if (node != start)
     {
-        auto parent_x = cur_x - layout_.getOffset(node);
-        auto parent_y = cur_y - static_cast<double>(layout::dist_y);
+        auto parent_x = x - layout.getOffset(node);
+        auto parent_y = y - static_cast<double>(layout::dist_y);
 
-        painter_.drawLine(parent_x, parent_y + BRANCH_WIDTH, cur_x, cur_y);
+        if (batch)
+        {
+            batch->edge(parent_x, parent_y + BRANCH_WIDTH, x, y);
+        }
+        else
+        {
+            painter.drawLine(parent_x, parent_y + BRANCH_WIDTH, x, y);
+        }
     }
 
-    auto status = tree_.getStatus(node);
+    auto status = tree.getStatus(node);
 
     /// NOTE: this should be consisten with the layout
-    if (vis_flags_.isLabelShown(node))
+    if (vis_flags.isLabelShown(node))
     {
 
-        auto draw_left = !utils::is_right_most_child(tree_, node);
-        // painter_.setPen(QPen{Qt::black, 2});
-        const Label &label = debug_mode_ ? std::to_string(node) : tree_.getLabel(node);
+        auto draw_left = !utils::is_right_most_child(tree, node);
+        // painter.setPen(QPen{Qt::black, 2});
+        const Label &label = debug ? std::to_string(node) : tree.getLabel(node);
 
-        auto fm = painter_.fontMetrics();
+        auto fm = painter.fontMetrics();
         auto label_width = fm.horizontalAdvance(label.c_str());
 
         {
-            auto font = painter_.font();
+            auto font = painter.font();
             font.setStyleHint(QFont::Monospace);
-            painter_.setFont(font);
+            painter.setFont(font);
         }
 
         int label_x;
         if (draw_left)
         {
-            label_x = cur_x - HALF_MAX_NODE_W - label_width;
+            label_x = x - HALF_MAX_NODE_W - label_width;
         }
         else
         {
-            label_x = cur_x + HALF_MAX_NODE_W;
+            label_x = x + HALF_MAX_NODE_W;
         }
 
-        painter_.drawText(QPoint{label_x, cur_y}, label.c_str());
+        painter.drawText(QPoint{label_x, y}, label.c_str());
     }
 
-    if (vis_flags_.isHighlighted(node))
+    if (vis_flags.isHighlighted(node))
     {
-        drawShape(painter_, cur_x, cur_y, node, layout_);
+        draw_shape(painter, x, y, node, layout);
     }
 
-    const auto sel_node = user_data_.getSelectedNode();
+    const auto sel_node = user_data.getSelectedNode();
     const auto selected = (sel_node == node) ? true : false;
 
     // if (selected)
     // {
-    //     painter_.setBrush(QColor{0, 0, 0, 20});
+    //     painter.setBrush(QColor{0, 0, 0, 20});
 
-    //     drawBoundingBox(painter_, cur_x, cur_y, node, layout_);
+    //     drawBoundingBox(painter, x, y, node, layout);
 
-    //     drawShape(painter_, cur_x, cur_y, node, layout_);
+    //     draw_shape(painter, x, y, node, layout);
     // }
 
     /// see if the node is hidden
 
-    auto hidden = vis_flags_.isHidden(node);
+    auto hidden = vis_flags.isHidden(node);
 
     if (hidden)
     {
 
         if (status == NodeStatus::MERGED)
         {
-            draw::big_pentagon(painter_, cur_x, cur_y, selected);
+            draw::big_pentagon(painter, x, y, selected);
             return;
         }
 
-        const bool has_gradient = tree_.hasOpenChildren(node);
-        const bool has_solutions = tree_.hasSolvedChildren(node);
+        const bool has_gradient = tree.hasOpenChildren(node);
+        const bool has_solutions = tree.hasSolvedChildren(node);
 
         /// check if the node is a lantern node
-        const auto lantern_size = vis_flags_.lanternSize(node);
+        const auto lantern_size = vis_flags.lanternSize(node);
         if (lantern_size == -1)
         {
 
-            drawTriangle(painter_, cur_x, cur_y, selected, has_gradient, has_solutions);
+            drawTriangle(painter, x, y, selected, has_gradient, has_solutions);
         }
         else
         {
-            draw::lantern(painter_, cur_x, cur_y, lantern_size, selected, has_gradient, has_solutions);
+            draw::lantern(painter, x, y, lantern_size, selected, has_gradient, has_solutions);
+        }
+
+        return;
+    }
+
+    /// the selected node keeps being drawn on its own (in gold)
+    if (batch && !selected)
+    {
+        switch (status)
+        {
+        case NodeStatus::SOLVED:
+            batch->solution(x, y);
+            break;
+        case NodeStatus::FAILED:
+            batch->failure(x, y);
+            break;
+        case NodeStatus::BRANCH:
+            batch->branch(x, y);
+            break;
+        case NodeStatus::SKIPPED:
+            batch->skipped(x, y);
+            break;
+        case NodeStatus::MERGED:
+            batch->pentagon(x, y);
+            break;
+        default:
+            batch->unexplored(x, y);
+            break;
+        }
+
+        if (user_data.isBookmarked(node))
+        {
+            batch->bookmark(x, y);
         }
 
         return;
@@ -249,41 +354,80 @@ void DrawingCursor::processCurrentNode()
     {
     case NodeStatus::SOLVED:
     {
-        draw::solution(painter_, cur_x, cur_y, selected);
+        draw::solution(painter, x, y, selected);
     }
     break;
     case NodeStatus::FAILED:
     {
-        draw::failure(painter_, cur_x, cur_y, selected);
+        draw::failure(painter, x, y, selected);
     }
     break;
     case NodeStatus::BRANCH:
     {
-        draw::branch(painter_, cur_x, cur_y, selected);
+        draw::branch(painter, x, y, selected);
     }
     break;
     case NodeStatus::SKIPPED:
     {
-        draw::skipped(painter_, cur_x, cur_y, selected);
+        draw::skipped(painter, x, y, selected);
     }
     break;
     case NodeStatus::MERGED:
     {
-        draw::pentagon(painter_, cur_x, cur_y, selected);
+        draw::pentagon(painter, x, y, selected);
     }
     break;
     default:
     {
-        draw::unexplored(painter_, cur_x, cur_y, selected);
+        draw::unexplored(painter, x, y, selected);
     }
     break;
     }
 
-    if (user_data_.isBookmarked(node))
+    if (user_data.isBookmarked(node))
     {
-        painter_.setBrush(Qt::black);
-        painter_.drawEllipse(cur_x - 10, cur_y, 10.0, 10.0);
+        painter.setBrush(Qt::black);
+        painter.drawEllipse(x - 10, y, 10.0, 10.0);
+    }
+}
+
+void DrawingCursor::processCurrentNode()
+{
+    if (isSummarised())
+    {
+        const auto node = cur_node();
+
+        if (!batch_)
+        {
+            painter_.setPen(QColor{dark_mode_ ? Qt::white : Qt::black});
+        }
+
+        if (node != start_node())
+        {
+            auto parent_x = cur_x - layout_.getOffset(node);
+            auto parent_y = cur_y - static_cast<double>(layout::dist_y);
+
+            if (batch_)
+            {
+                batch_->edge(parent_x, parent_y + traditional::BRANCH_WIDTH, cur_x, cur_y);
+            }
+            else
+            {
+                painter_.drawLine(parent_x, parent_y + traditional::BRANCH_WIDTH, cur_x, cur_y);
+            }
+        }
+
+        drawSummary(painter_, cur_x, cur_y, node, tree_, layout_);
+
+        if (vis_flags_.isHighlighted(node))
+        {
+            draw_shape(painter_, cur_x, cur_y, node, layout_);
+        }
+        return;
     }
+
+    draw_node(painter_, tree_, layout_, user_data_, vis_flags_, cur_node(), start_node(), cur_x, cur_y, debug_mode_, dark_mode_,
+              batch_);
 }
 
 void DrawingCursor::moveUpwards()
@@ -341,6 +485,9 @@ bool DrawingCursor::mayMoveDownwards()
     if (hidden)
         return false;
 
+    if (isSummarised())
+        return false;
+
     const auto kid = tree_.getChild(cur_node(), 0);
     const auto kid_layout_done = layout_.getLayoutDone(kid);
 
@@ -352,6 +499,27 @@ bool DrawingCursor::mayMoveUpwards()
     return NodeCursor::mayMoveUpwards();
 }
 
+bool DrawingCursor::isSummarised()
+{
+    if (lod_width_ == 0)
+        return false;
+
+    const auto node = cur_node();
+
+    if (tree_.childrenCount(node) == 0 || vis_flags_.isHidden(node))
+        return false;
+
+    /// only the first kid is needed for the node to be drawn with its kids
+    if (!layout_.getLayoutDone(tree_.getChild(node, 0)))
+        return false;
+
+    const auto bb = layout_.getBoundingBox(node);
+    if (bb.right - bb.left >= lod_width_)
+        return false;
+
+    return !std::binary_search(selected_path_.begin(), selected_path_.end(), node);
+}
+
 bool DrawingCursor::isClipped()
 {
     const auto bb = layout_.getBoundingBox(cur_node());
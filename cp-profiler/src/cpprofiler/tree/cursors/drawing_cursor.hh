@@ -6,6 +6,8 @@
 #include <QPoint>
 #include <QRect>
 
+#include <vector>
+
 class QPainter;
 
 namespace cpprofiler
@@ -15,7 +17,12 @@ class UserData;
 namespace tree
 {
 class VisualFlags;
+
+namespace draw
+{
+class NodeBatch;
 }
+} // namespace tree
 } // namespace cpprofiler
 
 namespace cpprofiler
@@ -25,6 +32,17 @@ namespace tree
 
 class Layout;
 
+/// Draw the shape of the subtree of `nid` at (`x`, `y`) as a translucent outline
+void draw_shape(QPainter &painter, int x, int y, NodeID nid, const Layout &layout);
+
+/// Draw node `node` at (`x`, `y`) along with the edge to its parent (unless
+/// `node` is `start`, the node drawing started from); with a `batch`, the
+/// edge and plain unselected nodes are only added to it, and the pen is left
+/// for the caller to set
+void draw_node(QPainter &painter, const NodeTree &tree, const Layout &layout, const UserData &user_data,
+               const VisualFlags &vis_flags, NodeID node, NodeID start, int x, int y, bool debug, bool dark_mode,
+               draw::NodeBatch *batch = nullptr);
+
 /// This uses unsafe methods for tree structure!
 class DrawingCursor : public NodeCursor
 {
@@ -44,8 +62,20 @@ class DrawingCursor : public NodeCursor
 
     int cur_x, cur_y;
 
+    /// Subtrees narrower than this are drawn as a single shape (0: never)
+    const int lod_width_;
+
+    /// Sorted ancestors of the selected node, never drawn as a single shape
+    std::vector<NodeID> selected_path_;
+
+    /// Where nodes are collected (if not drawn straight away)
+    draw::NodeBatch *batch_;
+
     bool isClipped();
 
+    /// Whether the subtree of the current node is drawn as a single shape
+    bool isSummarised();
+
   public:
     DrawingCursor(NodeID start,
                   const NodeTree &tree,
@@ -56,7 +86,9 @@ class DrawingCursor : public NodeCursor
                   QPoint start_pos,
                   const QRect &clippingRect0,
                   bool debug,
-                  bool darkMode);
+                  bool darkMode,
+                  int lod_width = 0,
+                  draw::NodeBatch *batch = nullptr);
 
     void processCurrentNode();
 
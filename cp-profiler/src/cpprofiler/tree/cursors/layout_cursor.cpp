@@ -10,6 +10,7 @@
 #include "../node_tree.hh"
 #include "../structure.hh"
 #include "../shape.hh"
+#include "../shape_cache.hh"
 #include "../../config.hh"
 #include "../../utils/tree_utils.hh"
 #include "../../utils/debug.hh"
@@ -26,8 +27,9 @@ namespace cpprofiler
 namespace tree
 {
 
-LayoutCursor::LayoutCursor(NodeID start, const NodeTree &tree, const VisualFlags &nf, Layout &lo, bool debug)
-    : NodeCursor(start, tree), m_layout(lo), tree_(tree), m_vis_flags(nf), debug_mode_(debug) {}
+LayoutCursor::LayoutCursor(NodeID start, const NodeTree &tree, const VisualFlags &nf, Layout &lo, bool debug,
+                           std::vector<NodeID> *changed)
+    : NodeCursor(start, tree), m_layout(lo), tree_(tree), m_vis_flags(nf), debug_mode_(debug), changed_(changed) {}
 
 bool LayoutCursor::mayMoveDownwards()
 {
@@ -52,10 +54,13 @@ static int distance_between(const Shape &s1, const Shape &s2)
 {
     const auto common_depth = std::min(s1.height(), s2.height());
 
+    Shape::Cursor c1(s1);
+    Shape::Cursor c2(s2);
+
     auto max = INT_MIN;
-    for (auto i = 0; i < common_depth; ++i)
+    for (auto i = 0; i < common_depth; ++i, ++c1, ++c2)
     {
-        auto cur_dist = s1[i].r - s2[i].l;
+        auto cur_dist = (*c1).r - (*c2).l;
         if (cur_dist > max)
             max = cur_dist;
     }
@@ -65,19 +70,36 @@ static int distance_between(const Shape &s1, const Shape &s2)
 
 /// Combine shapes s1 and s2 to form a shape of a shape for the parent node;
 /// offsets will contain the resulting relative distance from the parent node (along x);
-static ShapeUniqPtr combine_shapes(const Shape &s1, const Shape &s2, std::vector<int> &offsets)
+/// only the levels shared by both shapes are computed, those below are
+/// shared with the longer shape, so this takes time proportional to the
+/// height of the shorter one
+static std::shared_ptr<Shape> combine_shapes(const ShapePtr &p1, const ShapePtr &p2, std::vector<int> &offsets)
 {
+    const auto &s1 = *p1;
+    const auto &s2 = *p2;
 
     const auto depth_left = s1.height();
     const auto depth_right = s2.height();
 
-    const auto max_depth = std::max(depth_left, depth_right);
     const auto common_depth = std::min(depth_left, depth_right);
 
     const auto distance = distance_between(s1, s2);
     const auto half_dist = distance / 2;
 
-    auto combined = ShapeUniqPtr(new Shape{max_depth + 1});
+    std::shared_ptr<Shape> combined;
+
+    if (depth_left > depth_right)
+    {
+        combined = std::make_shared<Shape>(common_depth + 1, p1, common_depth, -half_dist);
+    }
+    else if (depth_right > depth_left)
+    {
+        combined = std::make_shared<Shape>(common_depth + 1, p2, common_depth, half_dist);
+    }
+    else
+    {
+        combined = std::make_shared<Shape>(common_depth + 1);
+    }
 
     {
         const auto bb_left = std::min(s1.boundingBox().left - half_dist,
@@ -91,73 +113,14 @@ static ShapeUniqPtr combine_shapes(const Shape &s1, const Shape &s2, std::vector
     offsets[1] = half_dist;
 
     /// Calculate extents for levels shared by both shapes
-    for (auto depth = 0; depth < common_depth; ++depth)
-    {
-        (*combined)[depth + 1] = {s1[depth].l - half_dist, s2[depth].r + half_dist};
-    }
-
-    /// Calculate extents for levels where only one subtree has nodes
-    if (max_depth != common_depth)
+    Shape::Cursor c1(s1);
+    Shape::Cursor c2(s2);
+    for (auto depth = 0; depth < common_depth; ++depth, ++c1, ++c2)
     {
-        const auto &longer_shape = depth_left > depth_right ? s1 : s2;
-        const int offset = depth_left > depth_right ? -half_dist : half_dist;
-
-        for (auto depth = common_depth; depth < max_depth; ++depth)
-        {
-            (*combined)[depth + 1] = {longer_shape[depth].l + offset,
-                                      longer_shape[depth].r + offset};
-        }
+        combined->setExtent(depth + 1, {(*c1).l - half_dist, (*c2).r + half_dist});
     }
 
-    return std::move(combined);
-}
-
-/// Merge two "sibling" shapes, without adding a new depth level;
-/// `dist` is the disntance between s2 and the left extent
-static Shape merge_left(const Shape &s1, const Shape &s2, int &dist)
-{
-
-    const auto depth_left = s1.height();
-    const auto depth_right = s2.height();
-
-    const auto common_depth = std::min(depth_left, depth_right);
-    const auto max_depth = std::max(depth_left, depth_right);
-
-    const auto distance = distance_between(s1, s2);
-
-    dist = distance - s1.boundingBox().left;
-
-    Shape result{max_depth};
-
-    /// compute bounding box
-    {
-        auto bb_left = std::min(s1.boundingBox().left,
-                                s2.boundingBox().left + distance);
-        auto bb_right = std::max(s1.boundingBox().right,
-                                 s2.boundingBox().right + distance);
-        result.setBoundingBox(BoundingBox{bb_left, bb_right});
-    }
-
-    /// Calculate extents for levels shared by both shapes
-    for (auto depth = 0; depth < common_depth; ++depth)
-    {
-        result[depth] = {s1[depth].l, s2[depth].r + distance};
-    }
-
-    /// Calculate extents for levels where only one subtree has nodes
-    if (max_depth != common_depth)
-    {
-        const auto &longer_shape = depth_left > depth_right ? s1 : s2;
-        const int offset = depth_left > depth_right ? 0 : distance;
-
-        for (auto depth = common_depth; depth < max_depth; ++depth)
-        {
-            result[depth] = {longer_shape[depth].l + offset,
-                             longer_shape[depth].r + offset};
-        }
-    }
-
-    return result;
+    return combined;
 }
 
 static Extent calculateForSingleNode(NodeID nid, const NodeTree &nt, bool label_shown, bool hidden, bool debug)
@@ -199,19 +162,16 @@ static Extent calculateForSingleNode(NodeID nid, const NodeTree &nt, bool label_
     return result;
 }
 
-inline static void computeForNodeBinary(NodeID nid, Layout &layout, const NodeTree &nt, bool label_shown, bool debug)
+inline static void computeForNodeBinary(NodeID nid, Extent top, Layout &layout, const NodeTree &nt)
 {
 
     auto kid_l = nt.getChild(nid, 0);
     auto kid_r = nt.getChild(nid, 1);
 
-    const auto &s1 = *layout.getShape(kid_l);
-    const auto &s2 = *layout.getShape(kid_r);
-
     std::vector<int> offsets(2);
-    auto combined = combine_shapes(s1, s2, offsets);
+    auto combined = combine_shapes(layout.getShapePtr(kid_l), layout.getShapePtr(kid_r), offsets);
 
-    (*combined)[0] = calculateForSingleNode(nid, nt, label_shown, false, debug);
+    combined->setExtent(0, top);
 
     /// Extents for root node changed -> check if bounding box is correct
     const auto &bb = combined->boundingBox();
@@ -243,19 +203,7 @@ inline static std::vector<int> compute_distances(NodeID nid, int nkids, Layout &
     return distances;
 }
 
-inline static int kids_max_depth(NodeID nid, int nkids, const Layout &lo, const NodeTree &tree)
-{
-    int max_depth = 0;
-    for (auto i = 0; i < nkids; ++i)
-    {
-        auto kid = tree.getChild(nid, i);
-        const auto &s1 = *lo.getShape(kid);
-        max_depth = std::max(max_depth, s1.height());
-    }
-    return max_depth;
-}
-
-static inline void computeForNodeNary(NodeID nid, int nkids, Layout &layout, const NodeTree &tree, bool debug)
+static inline void computeForNodeNary(NodeID nid, Extent top, int nkids, Layout &layout, const NodeTree &tree)
 {
 
     /// calculate all distances
@@ -268,11 +216,6 @@ static inline void computeForNodeNary(NodeID nid, int nkids, Layout &layout, con
         max_dist += distance;
     }
 
-    /// calculate the depth of the resulting shape
-    const auto new_depth = kids_max_depth(nid, nkids, layout, tree) + 1;
-
-    auto combined = ShapeUniqPtr(new Shape{new_depth});
-
     std::vector<int> x_offsets(nkids);
     /// calculate offsets
     auto cur_x = -max_dist / 2;
@@ -286,10 +229,49 @@ static inline void computeForNodeNary(NodeID nid, int nkids, Layout &layout, con
         }
     }
 
+    /// find the deepest kid and the height of the second deepest one:
+    /// levels in between only contain the deepest kid's extents
+    int deepest = 0;
+    int max_height = 0;
+    int second_height = 0;
+    for (auto alt = 0; alt < nkids; ++alt)
+    {
+        const auto height = layout.getShape(tree.getChild(nid, alt))->height();
+        if (height > max_height)
+        {
+            second_height = max_height;
+            max_height = height;
+            deepest = alt;
+        }
+        else if (height > second_height)
+        {
+            second_height = height;
+        }
+    }
+
+    std::shared_ptr<Shape> combined;
+
+    if (second_height < max_height)
+    {
+        const auto &deepest_shape = layout.getShapePtr(tree.getChild(nid, deepest));
+        combined = std::make_shared<Shape>(second_height + 1, deepest_shape, second_height, x_offsets[deepest]);
+    }
+    else
+    {
+        combined = std::make_shared<Shape>(max_height + 1);
+    }
+
     /// calculate extents
-    /// TODO: does this need to take labels into account?
-    (*combined)[0] = {-traditional::HALF_MAX_NODE_W, traditional::HALF_MAX_NODE_W};
-    for (auto depth = 1; depth < new_depth; ++depth)
+    combined->setExtent(0, top);
+
+    std::vector<Shape::Cursor> cursors;
+    cursors.reserve(nkids);
+    for (auto alt = 0; alt < nkids; ++alt)
+    {
+        cursors.emplace_back(*layout.getShape(tree.getChild(nid, alt)));
+    }
+
+    for (auto depth = 1; depth < combined->storedHeight(); ++depth)
     {
 
         auto leftmost_x = INT_MAX;
@@ -297,25 +279,26 @@ static inline void computeForNodeNary(NodeID nid, int nkids, Layout &layout, con
         for (auto alt = 0; alt < nkids; ++alt)
         {
             const auto kid = tree.getChild(nid, alt);
-            const auto &shape = *layout.getShape(kid);
-            if (shape.height() > depth - 1)
+            if (layout.getShape(kid)->height() > depth - 1)
             {
-                leftmost_x = std::min(leftmost_x, shape[depth - 1].l + x_offsets[alt]);
-                rightmost_x = std::max(leftmost_x, shape[depth - 1].r + x_offsets[alt]);
+                const auto extent = *cursors[alt];
+                leftmost_x = std::min(leftmost_x, extent.l + x_offsets[alt]);
+                rightmost_x = std::max(rightmost_x, extent.r + x_offsets[alt]);
+                ++cursors[alt];
             }
         }
 
-        (*combined)[depth].l = leftmost_x;
-        (*combined)[depth].r = rightmost_x;
+        combined->setExtent(depth, {leftmost_x, rightmost_x});
     }
 
-    /// calculate bounding box
-    int l_bound = INT_MAX;
-    int r_bound = INT_MIN;
-    for (auto depth = 0; depth < new_depth; ++depth)
+    /// calculate bounding box (from the kids' ones rather than visiting every level)
+    int l_bound = (*combined)[0].l;
+    int r_bound = (*combined)[0].r;
+    for (auto alt = 0; alt < nkids; ++alt)
     {
-        l_bound = std::min((*combined)[depth].l, l_bound);
-        r_bound = std::max((*combined)[depth].r, r_bound);
+        const auto &bb = layout.getShape(tree.getChild(nid, alt))->boundingBox();
+        l_bound = std::min(bb.left + x_offsets[alt], l_bound);
+        r_bound = std::max(bb.right + x_offsets[alt], r_bound);
     }
 
     combined->setBoundingBox({l_bound, r_bound});
@@ -324,23 +307,23 @@ static inline void computeForNodeNary(NodeID nid, int nkids, Layout &layout, con
 }
 
 /// Calculate shape for sized rectangle (lantern); size is between 0 and 127
-static ShapeUniqPtr calc_for_sized_rect(int size)
+static std::shared_ptr<Shape> calc_for_sized_rect(int size)
 {
 
     // using namespace lantern;
 
     int levels = std::ceil((size * lantern::K + lantern::BASE_HEIGHT) / (float)layout::dist_y) + 1;
 
-    auto shape = ShapeUniqPtr(new Shape(levels));
+    auto shape = std::make_shared<Shape>(levels);
 
     for (auto i = 0u; i < levels; ++i)
     {
-        (*shape)[i] = {-lantern::HALF_WIDTH, lantern::HALF_WIDTH};
+        shape->setExtent(i, {-lantern::HALF_WIDTH, lantern::HALF_WIDTH});
     }
 
     shape->setBoundingBox({-lantern::HALF_WIDTH, lantern::HALF_WIDTH});
 
-    return std::move(shape);
+    return shape;
 }
 
 /// Computes layout for nid (shape, bounding box, offsets for its children)
@@ -348,92 +331,130 @@ void LayoutCursor::computeForNode(NodeID nid)
 {
     const bool hidden = m_vis_flags.isHidden(nid);
     const bool label_shown = m_vis_flags.isLabelShown(nid);
+    const auto lsize = hidden ? m_vis_flags.lanternSize(nid) : -1;
+    const auto nkids = hidden ? 0 : tree_.childrenCount(nid);
 
-    /// Check if the node is hidden:
-    if (hidden)
+    /// the node's shape and its children's offsets are about to change
+    if (changed_)
     {
-        const auto lsize = m_vis_flags.lanternSize(nid);
-
-        if (lsize > -1)
+        changed_->push_back(nid);
+        for (auto alt = 0; alt < nkids; ++alt)
         {
-            /// Lantern node
-            auto shape = calc_for_sized_rect(lsize);
-            if (label_shown)
-            {
-                /// overriting the first extent in case of a label
-                (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, true, debug_mode_);
-                shape->setBoundingBox({(*shape)[0].l, (*shape)[0].r});
-            }
-            m_layout.setShape(nid, std::move(shape));
+            changed_->push_back(tree_.getChild(nid, alt));
         }
-        else
-        {
-            /// Normal failure node (triangle)
+    }
 
-            if (!label_shown)
-            {
-                m_layout.setShape(nid, ShapeUniqPtr(&Shape::hidden));
-            }
-            else
-            {
-                auto shape = ShapeUniqPtr{new Shape{2}};
-                (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, true, debug_mode_);
-                (*shape)[1] = (*shape)[0];
-                shape->setBoundingBox({(*shape)[0].l, (*shape)[0].r});
-                m_layout.setShape(nid, std::move(shape));
-            }
-        }
+    /// Leaves and failure nodes (triangles) without labels share static shapes
+    if (!label_shown && nkids == 0 && lsize == -1)
+    {
+        m_layout.setShape(nid, static_shape(hidden ? Shape::hidden : Shape::leaf));
+        m_layout.setLayoutDone(nid, true);
+        return;
     }
-    else
+
+    /// Identical subtrees are common among failed subtrees (which, once closed,
+    /// never change) and collapsed ones; elsewhere the cache would mostly
+    /// hold shapes that are never reused
+    const bool shareable = hidden || (!tree_.isOpen(nid) && !tree_.hasSolvedChildren(nid));
+
+    ShapeCache::Key key;
+    key.kind = !hidden ? ShapeCache::VISIBLE : (lsize > -1 ? lsize : ShapeCache::COLLAPSED);
+
+    /// TODO: does this need to take labels into account for n-ary nodes?
+    key.top = nkids > 2 ? Extent{-traditional::HALF_MAX_NODE_W, traditional::HALF_MAX_NODE_W}
+                        : calculateForSingleNode(nid, tree_, label_shown, hidden, debug_mode_);
+
+    auto &cache = m_layout.shapeCache();
+    std::vector<int> offsets;
+
+    if (shareable)
     {
-        auto nkids = tree_.childrenCount(nid);
+        key.kids.reserve(nkids);
+        for (auto alt = 0; alt < nkids; ++alt)
+        {
+            key.kids.push_back(m_layout.getShape(tree_.getChild(nid, alt))->id());
+        }
 
-        if (nkids == 0)
+        /// An identical subtree has been laid out already
+        if (auto shape = cache.find(key, offsets))
         {
-            if (!m_vis_flags.isLabelShown(nid))
+            for (auto alt = 0; alt < nkids; ++alt)
             {
-                auto other = ShapeUniqPtr(&Shape::leaf);
-                // m_layout.setShape(nid, ShapeUniqPtr(&Shape::leaf));
-                m_layout.setShape(nid, std::move(other));
-            }
-            else
-            {
-                auto shape = ShapeUniqPtr{new Shape{1}};
-                (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, false, debug_mode_);
-
-                shape->setBoundingBox({(*shape)[0].l, (*shape)[0].r});
-                m_layout.setShape(nid, std::move(shape));
+                m_layout.setChildOffset(tree_.getChild(nid, alt), offsets[alt]);
             }
+            m_layout.setShape(nid, std::move(shape));
+            m_layout.setLayoutDone(nid, true);
+            return;
         }
-        else if (nkids == 1)
+    }
+
+    if (lsize > -1)
+    {
+        /// Lantern node
+        auto shape = calc_for_sized_rect(lsize);
+        if (label_shown)
         {
+            /// overriting the first extent in case of a label
+            shape->setExtent(0, key.top);
+            shape->setBoundingBox({key.top.l, key.top.r});
+        }
+        m_layout.setShape(nid, std::move(shape));
+    }
+    else if (hidden)
+    {
+        /// Normal failure node (triangle) with a label
+        auto shape = std::make_shared<Shape>(2);
+        shape->setExtent(0, key.top);
+        shape->setExtent(1, key.top);
+        shape->setBoundingBox({key.top.l, key.top.r});
+        m_layout.setShape(nid, std::move(shape));
+    }
+    else if (nkids == 0)
+    {
+        /// Leaf node with a label
+        auto shape = std::make_shared<Shape>(1);
+        shape->setExtent(0, key.top);
 
-            const auto kid = tree_.getChild(nid, 0);
-            const auto &kid_s = *m_layout.getShape(kid);
+        shape->setBoundingBox({key.top.l, key.top.r});
+        m_layout.setShape(nid, std::move(shape));
+    }
+    else if (nkids == 1)
+    {
 
-            auto shape = ShapeUniqPtr(new Shape(kid_s.height() + 1));
+        const auto kid = tree_.getChild(nid, 0);
+        const auto &kid_s = m_layout.getShapePtr(kid);
 
-            (*shape)[0] = calculateForSingleNode(nid, tree_, label_shown, false, debug_mode_);
+        /// all levels below the node itself are the kid's
+        auto shape = std::make_shared<Shape>(1, kid_s, 0, 0);
 
-            for (auto depth = 0; depth < kid_s.height(); depth++)
-            {
-                (*shape)[depth + 1] = kid_s[depth];
-            }
+        shape->setExtent(0, key.top);
 
-            shape->setBoundingBox(kid_s.boundingBox());
+        shape->setBoundingBox(kid_s->boundingBox());
 
-            m_layout.setChildOffset(kid, 0);
+        m_layout.setChildOffset(kid, 0);
 
-            m_layout.setShape(nid, std::move(shape));
-        }
-        else if (nkids == 2)
-        {
-            computeForNodeBinary(nid, m_layout, tree_, label_shown, debug_mode_);
-        }
-        else if (nkids > 2)
+        m_layout.setShape(nid, std::move(shape));
+    }
+    else if (nkids == 2)
+    {
+        computeForNodeBinary(nid, key.top, m_layout, tree_);
+    }
+    else
+    {
+        computeForNodeNary(nid, key.top, nkids, m_layout, tree_);
+    }
+
+    if (shareable)
+    {
+        offsets.resize(nkids);
+        for (auto alt = 0; alt < nkids; ++alt)
         {
-            computeForNodeNary(nid, nkids, m_layout, tree_, debug_mode_);
+            offsets[alt] = static_cast<int>(m_layout.getOffset(tree_.getChild(nid, alt)));
         }
+
+        /// Use the cached shape if another thread has just computed the same one
+        auto shape = cache.insert(std::move(key), m_layout.getShapePtr(nid), std::move(offsets));
+        m_layout.setShape(nid, std::move(shape));
     }
 
     /// Layout is done for `nid` and its children
@@ -24,9 +24,13 @@ class LayoutCursor : public NodeCursor
 
     const bool debug_mode_;
 
+    /// If not null, nodes whose layout data is modified are appended here
+    std::vector<NodeID> *changed_;
+
   public:
     // Constructor
-    LayoutCursor(NodeID start, const NodeTree &tree, const VisualFlags &nf, Layout &lo, bool debug);
+    LayoutCursor(NodeID start, const NodeTree &tree, const VisualFlags &nf, Layout &lo, bool debug,
+                 std::vector<NodeID> *changed = nullptr);
 
     void computeForNode(NodeID nid);
 
@@ -0,0 +1,111 @@
+#include "frozen_structure.hh"
+
+#include "structure.hh"
+
+#include <vector>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+FrozenStructure::FrozenStructure(const Structure &structure)
+{
+    const auto count = structure.nodeCount();
+
+    parent_.resize(count);
+    first_child_.resize(count + 1);
+
+    auto total_kids = 0;
+    for (auto nid = 0; nid < count; ++nid)
+    {
+        total_kids += structure.childrenCount(NodeID{nid});
+    }
+
+    children_.reserve(total_kids);
+
+    for (auto nid = 0; nid < count; ++nid)
+    {
+        parent_[nid] = structure.getParent(NodeID{nid});
+        first_child_[nid] = static_cast<int>(children_.size());
+
+        const auto kids = structure.childrenCount(NodeID{nid});
+        for (auto alt = 0; alt < kids; ++alt)
+        {
+            children_.push_back(structure.getChild(NodeID{nid}, alt));
+        }
+    }
+
+    first_child_[count] = static_cast<int>(children_.size());
+
+    preorder_pos_.resize(count, -1);
+    subtree_size_.resize(count, 1);
+
+    if (count == 0)
+        return;
+
+    preorder_.reserve(count);
+
+    std::vector<NodeID> stack{getRoot()};
+
+    while (!stack.empty())
+    {
+        const auto nid = stack.back();
+        stack.pop_back();
+
+        preorder_pos_[nid] = static_cast<int>(preorder_.size());
+        preorder_.push_back(nid);
+
+        for (auto alt = childrenCount(nid) - 1; alt >= 0; --alt)
+        {
+            stack.push_back(getChild(nid, alt));
+        }
+    }
+
+    /// every node comes after its parent, so sizes can be accumulated backwards
+    for (auto i = static_cast<int>(preorder_.size()) - 1; i > 0; --i)
+    {
+        const auto nid = preorder_[i];
+        subtree_size_[parent_[nid]] += subtree_size_[nid];
+    }
+}
+
+int FrozenStructure::getAlternative(NodeID nid) const
+{
+    const auto pid = getParent(nid);
+
+    if (pid == NodeID::NoNode)
+        return -1;
+
+    for (auto i = first_child_[pid]; i < first_child_[pid + 1]; ++i)
+    {
+        if (children_[i] == nid)
+            return i - first_child_[pid];
+    }
+
+    return -1;
+}
+
+FrozenStructure::Range FrozenStructure::subtree(NodeID nid) const
+{
+    const auto pos = preorder_pos_[nid];
+
+    if (pos < 0)
+        return {preorder_.end(), preorder_.end()};
+
+    const auto begin = preorder_.begin() + pos;
+    return {begin, begin + subtree_size_[nid]};
+}
+
+size_t FrozenStructure::memoryUsage() const
+{
+    return parent_.capacity() * sizeof(NodeID) +
+           first_child_.capacity() * sizeof(int) +
+           children_.capacity() * sizeof(NodeID) +
+           preorder_.capacity() * sizeof(NodeID) +
+           preorder_pos_.capacity() * sizeof(int) +
+           subtree_size_.capacity() * sizeof(int);
+}
+
+} // namespace tree
+} // namespace cpprofiler
@@ -0,0 +1,87 @@
+#ifndef CPPROFILER_TREE_FROZEN_STRUCTURE_HH
+#define CPPROFILER_TREE_FROZEN_STRUCTURE_HH
+
+#include "node_id.hh"
+#include "../utils/pod_vector.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+class Structure;
+
+/// Immutable, compact copy of a finished tree's structure
+///
+/// Children are stored in CSR (compressed sparse row) form: the children of
+/// node `n` are `children_[first_child_[n]]` up to `children_[first_child_[n + 1]]`.
+/// Nodes are also listed in pre-order, so that the subtree of any node is a
+/// contiguous range of that list. Being immutable, it can be read from any
+/// thread without locking.
+class FrozenStructure
+{
+    utils::PodVector<NodeID> parent_;
+
+    /// Position of each node's first child in `children_` (plus one entry past the end)
+    utils::PodVector<int> first_child_;
+
+    utils::PodVector<NodeID> children_;
+
+    /// Nodes reachable from the root in pre-order
+    utils::PodVector<NodeID> preorder_;
+
+    /// Position of each node in `preorder_` (-1 if it is not reachable)
+    utils::PodVector<int> preorder_pos_;
+
+    /// Number of nodes in each node's subtree (including the node itself)
+    utils::PodVector<int> subtree_size_;
+
+  public:
+    /// A contiguous range of nodes
+    class Range
+    {
+        const NodeID *begin_;
+        const NodeID *end_;
+
+      public:
+        Range(const NodeID *begin, const NodeID *end) : begin_(begin), end_(end) {}
+
+        const NodeID *begin() const { return begin_; }
+        const NodeID *end() const { return end_; }
+
+        int size() const { return static_cast<int>(end_ - begin_); }
+    };
+
+    /// Copy the structure (which must not change in the meantime)
+    explicit FrozenStructure(const Structure &structure);
+
+    NodeID getRoot() const { return NodeID{0}; }
+
+    NodeID getParent(NodeID nid) const { return parent_[nid]; }
+
+    NodeID getChild(NodeID pid, int alt) const { return children_[first_child_[pid] + alt]; }
+
+    int childrenCount(NodeID pid) const { return first_child_[pid + 1] - first_child_[pid]; }
+
+    /// Get the position of node `nid` relative to its left-most sibling
+    int getAlternative(NodeID nid) const;
+
+    int nodeCount() const { return static_cast<int>(parent_.size()); }
+
+    /// Number of nodes in the subtree of `nid` (including `nid`)
+    int subtreeSize(NodeID nid) const { return subtree_size_[nid]; }
+
+    /// Nodes of the subtree of `nid` in pre-order (starting with `nid`)
+    Range subtree(NodeID nid) const;
+
+    /// All nodes reachable from the root in pre-order
+    Range preorder() const { return {preorder_.begin(), preorder_.end()}; }
+
+    /// Memory (in bytes) taken by the structure
+    size_t memoryUsage() const;
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,104 @@
+#include "label_pool.hh"
+
+#include <cstring>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+constexpr LabelID LabelPool::EMPTY;
+constexpr LabelID LabelPool::NO_LABEL;
+
+LabelPool::LabelPool()
+{
+    offsets_.push_back(0);
+    rehash(1024);
+    intern("");
+}
+
+uint64_t LabelPool::hash(const char *str, size_t len)
+{
+    /// FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; ++i)
+    {
+        h ^= static_cast<unsigned char>(str[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool LabelPool::equals(LabelID id, const std::string &label) const
+{
+    const auto begin = offsets_[id];
+    const auto len = offsets_[id + 1] - begin;
+
+    return len == label.size() && std::memcmp(chars_.data() + begin, label.data(), len) == 0;
+}
+
+void LabelPool::rehash(size_t slots)
+{
+    table_.clear();
+    table_.resize(slots, NO_LABEL);
+
+    const auto mask = slots - 1;
+
+    for (LabelID id = 0; id < size(); ++id)
+    {
+        const auto begin = offsets_[id];
+        auto slot = hash(chars_.data() + begin, offsets_[id + 1] - begin) & mask;
+
+        while (table_[slot] != NO_LABEL)
+            slot = (slot + 1) & mask;
+
+        table_[slot] = id;
+    }
+}
+
+LabelID LabelPool::intern(const std::string &label)
+{
+    if (table_.empty())
+    {
+        size_t slots = 1024;
+        while (slots < 2 * (size() + 1))
+            slots *= 2;
+        rehash(slots);
+    }
+
+    const auto mask = table_.size() - 1;
+    auto slot = hash(label.data(), label.size()) & mask;
+
+    while (table_[slot] != NO_LABEL)
+    {
+        if (equals(table_[slot], label))
+            return table_[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    const auto id = static_cast<LabelID>(size());
+
+    chars_.append(label.data(), label.size());
+    offsets_.push_back(chars_.size());
+
+    table_[slot] = id;
+
+    if (2 * size() > table_.size())
+        rehash(table_.size() * 2);
+
+    return id;
+}
+
+void LabelPool::compact()
+{
+    table_ = utils::PodVector<LabelID>();
+}
+
+size_t LabelPool::memoryUsage() const
+{
+    return chars_.capacity() + offsets_.capacity() * sizeof(uint64_t) +
+           table_.capacity() * sizeof(LabelID);
+}
+
+} // namespace tree
+} // namespace cpprofiler
@@ -0,0 +1,72 @@
+#ifndef CPPROFILER_TREE_LABEL_POOL_HH
+#define CPPROFILER_TREE_LABEL_POOL_HH
+
+#include <cstdint>
+#include <string>
+
+#include "../utils/pod_vector.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+using LabelID = uint32_t;
+
+/// Stores every distinct label once and identifies it by a 32-bit id,
+/// so that nodes only need to keep the id and labels of the same pool
+/// can be compared by comparing ids
+///
+/// Labels are kept back to back in one character array and looked up
+/// through an open-addressing hash table of ids, so that all of the pool
+/// can live in memory-mapped files (see `utils::mapped_storage_dir`)
+class LabelPool
+{
+    /// Characters of all labels
+    utils::PodVector<char> chars_;
+
+    /// Start of each label in `chars_`; label `id` ends where `id + 1` starts
+    utils::PodVector<uint64_t> offsets_;
+
+    /// Hash table of label ids (size is a power of two, at most half full)
+    utils::PodVector<LabelID> table_;
+
+    /// Marks an empty slot in `table_`
+    static constexpr LabelID NO_LABEL = UINT32_MAX;
+
+    static uint64_t hash(const char *str, size_t len);
+
+    bool equals(LabelID id, const std::string &label) const;
+
+    /// Rebuild `table_` with `slots` slots
+    void rehash(size_t slots);
+
+  public:
+    /// The id of the empty label (in any pool)
+    static constexpr LabelID EMPTY = 0;
+
+    LabelPool();
+
+    /// The id of `label`, adding it to the pool if necessary
+    LabelID intern(const std::string &label);
+
+    std::string get(LabelID id) const
+    {
+        return std::string(chars_.data() + offsets_[id], chars_.data() + offsets_[id + 1]);
+    }
+
+    /// Number of distinct labels
+    size_t size() const { return offsets_.size() - 1; }
+
+    /// Release the lookup table (e.g. once the tree is done); it is
+    /// rebuilt if another label is interned afterwards
+    void compact();
+
+    /// Approximate memory used for the labels (in bytes)
+    size_t memoryUsage() const;
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
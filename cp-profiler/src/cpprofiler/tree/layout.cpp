@@ -2,6 +2,7 @@
 
 #include <QDebug>
 #include <iostream>
+#include <unordered_set>
 
 #include "../utils/std_ext.hh"
 
@@ -10,7 +11,7 @@ namespace cpprofiler
 namespace tree
 {
 
-void Layout::setShape(NodeID nid, std::unique_ptr<Shape, ShapeDeleter> shape)
+void Layout::setShape(NodeID nid, ShapePtr shape)
 {
     shapes_[nid] = std::move(shape);
 }
@@ -20,7 +21,7 @@ utils::Mutex &Layout::getMutex() const
     return layout_;
 }
 
-Layout::Layout()
+Layout::Layout() : shape_cache_(std::make_shared<ShapeCache>())
 {
 }
 
@@ -40,7 +41,56 @@ bool Layout::getLayoutDone(NodeID nid) const
 {
     if (layout_done_.size() <= nid)
         return false;
-    return layout_done_[nid];
+    return layout_done_[nid] != 0;
+}
+
+void Layout::copyNodes(const Layout &other, const std::vector<NodeID> &nodes)
+{
+    growDataStructures(static_cast<int>(other.shapes_.size()));
+
+    for (const auto n : nodes)
+    {
+        shapes_[n] = other.shapes_[n];
+        child_offsets_[n] = other.child_offsets_[n];
+        layout_done_[n] = other.layout_done_[n];
+        dirty_[n] = other.dirty_[n];
+    }
+
+    ++version_;
+}
+
+size_t Layout::nodeDataMemoryUsage() const
+{
+    return shapes_.capacity() * sizeof(ShapePtr) +
+           child_offsets_.capacity() * sizeof(double) +
+           layout_done_.capacity() + dirty_.capacity();
+}
+
+size_t Layout::memoryUsage() const
+{
+    size_t bytes = nodeDataMemoryUsage();
+
+    /// shapes referred to more than once (shared by identical subtrees or
+    /// by a parent's shape) are only counted the first time
+    std::unordered_set<const Shape *> shared;
+
+    for (const auto &shape : shapes_)
+    {
+        /// leaf and hidden shapes are shared by all nodes; levels shared
+        /// with another shape are counted with that shape
+        if (!shape || shape.get() == &Shape::leaf || shape.get() == &Shape::hidden)
+            continue;
+
+        if (shape.use_count() > 1 && !shared.insert(shape.get()).second)
+            continue;
+
+        /// the control block is allocated together with the shape
+        bytes += sizeof(Shape) + 2 * sizeof(long) + shape->storedHeight() * sizeof(Extent);
+    }
+
+    bytes += shape_cache_->memoryUsage();
+
+    return bytes;
 }
 
 void Layout::growDataStructures(int n_nodes)
@@ -9,6 +9,7 @@
 
 #include "../core.hh"
 #include "shape.hh"
+#include "shape_cache.hh"
 
 namespace cpprofiler
 {
@@ -19,9 +20,6 @@ class Shape;
 class LayoutComputer;
 class Structure;
 class BoundingBox;
-class ShapeDeleter;
-
-using ShapeUniqPtr = std::unique_ptr<Shape, ShapeDeleter>;
 
 class Layout : public QObject
 {
@@ -30,16 +28,24 @@ class Layout : public QObject
   mutable utils::Mutex layout_;
 
   /// TODO: make sure this is always protected by a mutex
-  std::vector<ShapeUniqPtr> shapes_;
+  std::vector<ShapePtr> shapes_;
 
   /// Relative offset from the parent node along the x axis
   std::vector<double> child_offsets_;
 
-  /// Whether layout for the node and its children is done (indexed by NodeID)
-  std::vector<bool> layout_done_;
+  /// Whether layout for the node and its children is done (indexed by NodeID);
+  /// a byte per node rather than std::vector<bool>, so that threads laying out
+  /// different subtrees never write to the same memory location
+  std::vector<char> layout_done_;
 
   /// Whether a node's shape need to be recomputed (indexed by NodeID)
-  std::vector<bool> dirty_;
+  std::vector<char> dirty_;
+
+  /// Shapes shared between identical subtrees (possibly with another layout)
+  std::shared_ptr<ShapeCache> shape_cache_;
+
+  /// Number of times nodes were copied in from another layout
+  size_t version_ = 0;
 
 public:
   utils::Mutex &getMutex() const;
@@ -52,7 +58,10 @@ public:
   /// if it was hidden before layout was run
   const Shape *getShape(NodeID nid) const { return shapes_[nid].get(); }
 
-  void setShape(NodeID nid, ShapeUniqPtr shape);
+  /// Shared pointer to the shape of `nid`, for shapes reusing parts of it
+  const ShapePtr &getShapePtr(NodeID nid) const { return shapes_[nid]; }
+
+  void setShape(NodeID nid, ShapePtr shape);
 
   double getOffset(NodeID nid) const { return child_offsets_[nid]; }
 
@@ -68,7 +77,7 @@ public:
   bool ready(NodeID nid) const;
 
   /// Whether node `nid` is dirty (needs layout update)
-  bool isDirty(NodeID nid) const { return dirty_[nid]; }
+  bool isDirty(NodeID nid) const { return dirty_[nid] != 0; }
 
   /// Set node `nid` as (dirty) / (not dirty) based on `val`
   void setDirty(NodeID nid, bool val) { dirty_[nid] = val; }
@@ -76,6 +85,26 @@ public:
   /// Get bounding box of node `nid`
   const BoundingBox &getBoundingBox(NodeID nid) const { return getShape(nid)->boundingBox(); }
 
+  ShapeCache &shapeCache() { return *shape_cache_; }
+
+  const ShapeCache &shapeCache() const { return *shape_cache_; }
+
+  /// Use the same shape cache as `other`
+  void shareShapeCache(const Layout &other) { shape_cache_ = other.shape_cache_; }
+
+  /// Copy the layout data of `nodes` from `other`, which has at least
+  /// as many nodes as this layout
+  void copyNodes(const Layout &other, const std::vector<NodeID> &nodes);
+
+  /// Changes whenever `copyNodes` is used, i.e. whenever a new layout is published
+  size_t version() const { return version_; }
+
+  /// Memory (in bytes) taken by shapes and per-node layout data
+  size_t memoryUsage() const;
+
+  /// Memory (in bytes) taken by per-node layout data alone
+  size_t nodeDataMemoryUsage() const;
+
   Layout();
   ~Layout();
 
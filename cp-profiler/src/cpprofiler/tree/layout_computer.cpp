@@ -2,9 +2,12 @@
 #include "layout.hh"
 #include "structure.hh"
 #include "node_tree.hh"
+#include "frozen_structure.hh"
+#include "visual_flags.hh"
 #include "shape.hh"
 #include "../utils/std_ext.hh"
 #include "../utils/perf_helper.hh"
+#include "../utils/work_stealing_pool.hh"
 
 #include "cursors/layout_cursor.hh"
 #include "cursors/nodevisitor.hh"
@@ -19,6 +22,31 @@ namespace cpprofiler
 namespace tree
 {
 
+/// Subtrees with fewer nodes than this are laid out by a single task
+static constexpr int PARALLEL_LAYOUT_THRESHOLD = 4096;
+
+static int &layout_threads()
+{
+    static int threads = 0;
+    return threads;
+}
+
+void set_layout_threads(int threads)
+{
+    layout_threads() = threads;
+}
+
+/// Pool shared by all layout computers (the calling thread counts as a worker)
+static utils::WorkStealingPool &layout_pool()
+{
+    static utils::WorkStealingPool pool([]() {
+        const int threads = layout_threads() > 0 ? layout_threads()
+                                                 : static_cast<int>(std::thread::hardware_concurrency());
+        return static_cast<unsigned>(std::max(threads - 1, 0));
+    }());
+    return pool;
+}
+
 LayoutComputer::LayoutComputer(const NodeTree &tree, Layout &layout, const VisualFlags &nf)
     : m_tree(tree), m_layout(layout), m_vis_flags(nf)
 {
@@ -60,36 +88,143 @@ void LayoutComputer::dirtyUpLater(NodeID nid)
     // if (m_layout.ready(nid))
     // {
     // print("dirty up {} later", nid);
+    utils::MutexLocker lock(&du_mutex_, "dirty up");
     du_node_set_.insert(nid);
     // }
 }
 
+void LayoutComputer::recordChanges(const std::vector<NodeID> &nodes)
+{
+    if (nodes.empty())
+        return;
+
+    utils::MutexLocker lock(&changed_mutex_, "layout changes");
+    changed_.insert(changed_.end(), nodes.begin(), nodes.end());
+}
+
+std::vector<NodeID> LayoutComputer::takeChanges()
+{
+    std::vector<NodeID> changes;
+
+    utils::MutexLocker lock(&changed_mutex_, "layout changes");
+    changes.swap(changed_);
+
+    return changes;
+}
+
+bool LayoutComputer::hasChanges()
+{
+    utils::MutexLocker lock(&changed_mutex_, "layout changes");
+    return !changed_.empty();
+}
+
+void LayoutComputer::layoutSequentially(NodeID start)
+{
+    std::vector<NodeID> changed;
+
+    LayoutCursor lc(start, m_tree, m_vis_flags, m_layout, debug_mode_, track_changes_ ? &changed : nullptr);
+    PostorderNodeVisitor<LayoutCursor> visitor(lc);
+
+    while (!cancelled() && visitor.next())
+    {
+    }
+
+    recordChanges(changed);
+}
+
+/// Equivalent to running `LayoutCursor` over the subtree: a node's shape only
+/// depends on the shapes of its children, so sibling subtrees are independent
+void LayoutComputer::layoutSubtree(NodeID nid, const FrozenStructure &frozen)
+{
+    if (cancelled() || !m_layout.isDirty(nid))
+        return;
+
+    const auto kids = frozen.childrenCount(nid);
+
+    if (kids == 0 || m_vis_flags.isHidden(nid) || frozen.subtreeSize(nid) < PARALLEL_LAYOUT_THRESHOLD)
+    {
+        layoutSequentially(nid);
+        return;
+    }
+
+    {
+        utils::WorkStealingPool::TaskGroup group(layout_pool());
+
+        for (auto alt = 0; alt < kids; ++alt)
+        {
+            const auto kid = frozen.getChild(nid, alt);
+            group.run([this, kid, &frozen]() { layoutSubtree(kid, frozen); });
+        }
+
+        group.wait();
+    }
+
+    /// some of the children might not be laid out
+    if (cancelled())
+        return;
+
+    std::vector<NodeID> changed;
+
+    LayoutCursor lc(nid, m_tree, m_vis_flags, m_layout, debug_mode_, track_changes_ ? &changed : nullptr);
+    lc.computeForNode(nid);
+    m_layout.setDirty(nid, false);
+
+    recordChanges(changed);
+}
+
 bool LayoutComputer::compute()
 {
 
+    /// Take the nodes to dirty up before the snapshot: the tree publishes
+    /// new children before asking for their parent to be dirtied up,
+    /// so the snapshot is guaranteed to contain them
+    std::set<NodeID> du_nodes;
+    {
+        utils::MutexLocker lock(&du_mutex_, "dirty up");
+        du_nodes.swap(du_node_set_);
+    }
+
+    /// The tree is read through a snapshot rather than under the tree mutex,
+    /// so that the builder can keep adding nodes in the meantime
+    NodeTree::ReadSnapshot snapshot(m_tree);
+
     /// do nothing if there is no nodes
 
-    if (m_tree.nodeCount() == 0)
+    if (snapshot.nodeCount() == 0)
+    {
+        /// try again next time
+        utils::MutexLocker lock(&du_mutex_, "dirty up");
+        du_node_set_.insert(du_nodes.begin(), du_nodes.end());
         return false;
+    }
 
-    /// TODO: come back here (ensure mutexes work correctly)
-    utils::MutexLocker tree_lock(&m_tree.treeMutex());
     utils::MutexLocker layout_lock(&m_layout.getMutex());
 
     /// Ensures that sufficient memory is allocated for every node's shape
-    m_layout.growDataStructures(m_tree.nodeCount());
+    m_layout.growDataStructures(snapshot.nodeCount());
 
     // print("to dirty up size: {}", du_node_set_.size());
 
-    for (auto n : du_node_set_)
+    for (auto n : du_nodes)
     {
         dirtyUp(n);
     }
 
-    du_node_set_.clear();
+    const auto root = m_tree.getRoot();
 
-    LayoutCursor lc(m_tree.getRoot(), m_tree, m_vis_flags, m_layout, debug_mode_);
-    PostorderNodeVisitor<LayoutCursor>(lc).run();
+    /// Subtree sizes (needed to split the work sensibly) are only known for
+    /// finished trees, which is also when big relayouts (e.g. unhiding all nodes) happen
+    const auto frozen = m_tree.frozen();
+
+    if (parallel_ && frozen && layout_pool().size() > 0 &&
+        frozen->subtreeSize(root) >= PARALLEL_LAYOUT_THRESHOLD)
+    {
+        layoutSubtree(root, *frozen);
+    }
+    else
+    {
+        layoutSequentially(root);
+    }
 
     static int counter = 0;
     // std::cerr << "computed layout " << ++counter   << " times\n";
@@ -4,7 +4,9 @@
 class QMutex;
 
 #include "node_id.hh"
+#include "../core.hh"
 
+#include <atomic>
 #include <set>
 #include <vector>
 
@@ -15,8 +17,14 @@ namespace tree
 
 class Layout;
 class NodeTree;
+class FrozenStructure;
 class VisualFlags;
 
+/// Number of threads used to lay out large subtrees in parallel
+/// (0, the default, means one per core; 1 disables parallel layout);
+/// must be called before any layout is computed
+void set_layout_threads(int threads);
+
 class LayoutComputer
 {
 
@@ -28,17 +36,60 @@ class LayoutComputer
 
     bool debug_mode_ = false;
 
+    /// Whether large subtrees of finished trees may be laid out in parallel
+    bool parallel_ = true;
+
     /// Nodes to dirty up right before next layout update
     std::set<NodeID> du_node_set_;
 
+    /// Protects `du_node_set_` (filled by the builder's thread)
+    utils::Mutex du_mutex_;
+
+    /// Set by the owner to abandon the current pass (can be null)
+    const std::atomic<bool> *cancel_ = nullptr;
+
+    /// Whether to record the nodes whose layout data changes
+    bool track_changes_ = false;
+
+    /// Nodes whose shape, offset or flags changed since `takeChanges`
+    std::vector<NodeID> changed_;
+
+    /// Protects `changed_` (appended to by parallel layout tasks)
+    utils::Mutex changed_mutex_;
+
+    bool cancelled() const { return cancel_ && cancel_->load(std::memory_order_relaxed); }
+
     void dirtyUp(NodeID nid);
 
+    /// Lay out the dirty part of the subtree of `start` on this thread
+    void layoutSequentially(NodeID start);
+
+    /// Lay out the dirty part of the subtree of `nid`, laying out the
+    /// children of large subtrees as parallel tasks
+    void layoutSubtree(NodeID nid, const FrozenStructure &frozen);
+
+    void recordChanges(const std::vector<NodeID> &nodes);
+
   public:
     LayoutComputer(const NodeTree &tree, Layout &layout, const VisualFlags &nf);
 
-    /// compute the layout and return where any work was required
+    /// compute the layout and return where any work was required;
+    /// if cancelled, nodes not laid out yet stay dirty, so that
+    /// the next call continues where this one stopped
     bool compute();
 
+    /// Make `compute` return early whenever `flag` is set
+    void setCancelFlag(const std::atomic<bool> *flag) { cancel_ = flag; }
+
+    /// Record the nodes whose layout changes (see `takeChanges`)
+    void setTrackChanges(bool val) { track_changes_ = val; }
+
+    /// Nodes whose layout data changed since the last call (possibly repeated)
+    std::vector<NodeID> takeChanges();
+
+    /// Whether any changes have been recorded since `takeChanges`
+    bool hasChanges();
+
     /// Mark node's ancestors as dirty without stopping at an already dirty node
     void dirtyUpUnconditional(NodeID nid);
 
@@ -49,6 +100,11 @@ class LayoutComputer
     void setDirty(NodeID nid);
 
     void setDebugMode(bool val) { debug_mode_ = val; }
+
+    bool debugMode() const { return debug_mode_; }
+
+    /// Allow/disallow parallel layout; the result is the same either way
+    void setParallel(bool val) { parallel_ = val; }
 };
 
 } // namespace tree
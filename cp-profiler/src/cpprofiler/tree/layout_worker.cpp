@@ -0,0 +1,152 @@
+#include "layout_worker.hh"
+#include "node_tree.hh"
+
+#include "../utils/debug.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+LayoutWorker::LayoutWorker(const NodeTree &tree, const VisualFlags &vf, Layout &front)
+    : tree_(tree), vis_flags_(vf), front_(front), computer_(tree, back_, vf), cancel_(false), back_memory_(0)
+{
+    /// the cache is filled by the back layout, but its statistics are read from the front
+    back_.shareShapeCache(front_);
+
+    computer_.setCancelFlag(&cancel_);
+    computer_.setTrackChanges(true);
+
+    thread_ = std::thread(&LayoutWorker::run, this);
+}
+
+LayoutWorker::~LayoutWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stop_ = true;
+    }
+    cancel_ = true;
+    state_cv_.notify_one();
+
+    thread_.join();
+}
+
+void LayoutWorker::run()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            state_cv_.wait(lock, [this]() {
+                return stop_ || (requested_ && paused_ == 0 && !awaiting_publish_);
+            });
+
+            if (stop_)
+                return;
+
+            requested_ = false;
+            running_ = true;
+        }
+
+        std::unique_lock<std::mutex> pass(pass_mutex_);
+
+        computer_.compute();
+        back_memory_ = back_.nodeDataMemoryUsage();
+
+        bool ready;
+        {
+            /// still holding `pass_mutex_`, so that whoever pauses next sees the outcome
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            running_ = false;
+
+            if (cancel_.load())
+            {
+                /// resume once no longer paused
+                requested_ = true;
+                continue;
+            }
+
+            ready = computer_.hasChanges();
+            awaiting_publish_ = ready;
+        }
+
+        pass.unlock();
+
+        if (ready)
+        {
+            emit layoutReady();
+        }
+    }
+}
+
+void LayoutWorker::pause()
+{
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (paused_++ > 0)
+            return;
+    }
+
+    cancel_ = true;
+    pass_mutex_.lock();
+
+    /// changes made while paused must apply on top of the latest layout
+    publish();
+}
+
+void LayoutWorker::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (--paused_ > 0)
+            return;
+    }
+
+    cancel_ = false;
+    pass_mutex_.unlock();
+    state_cv_.notify_one();
+}
+
+void LayoutWorker::request()
+{
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        requested_ = true;
+    }
+    state_cv_.notify_one();
+}
+
+bool LayoutWorker::publish()
+{
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (!awaiting_publish_)
+            return false;
+    }
+
+    {
+        /// the worker does not touch the back layout until `awaiting_publish_` is reset
+        const auto changed = computer_.takeChanges();
+
+        utils::MutexLocker lock(&front_.getMutex(), "publish layout");
+        front_.copyNodes(back_, changed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        awaiting_publish_ = false;
+    }
+    state_cv_.notify_one();
+
+    return true;
+}
+
+bool LayoutWorker::busy()
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return requested_ || running_ || awaiting_publish_;
+}
+
+} // namespace tree
+} // namespace cpprofiler
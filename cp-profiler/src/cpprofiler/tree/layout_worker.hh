@@ -0,0 +1,126 @@
+#ifndef CPPROFILER_TREE_LAYOUT_WORKER_HH
+#define CPPROFILER_TREE_LAYOUT_WORKER_HH
+
+#include <QObject>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "layout.hh"
+#include "layout_computer.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+class NodeTree;
+class VisualFlags;
+
+/// Keeps a layout up to date on a dedicated thread
+///
+/// The worker lays out into a layout of its own (the back layout), so that
+/// the GUI keeps drawing the last published one (the front layout) in the
+/// meantime. Requests are coalesced: however many arrive during a pass,
+/// they result in a single follow-up pass. Once a pass is complete,
+/// `layoutReady` is emitted and the GUI copies the nodes that changed into
+/// the front layout (`publish`), so it never sees a partially computed layout.
+///
+/// Visual flags and the layout computer must only be modified while the
+/// worker is paused (see `Pause`). Pausing abandons the current pass; since
+/// nodes that were laid out are no longer dirty, the pass is later resumed
+/// rather than started over.
+class LayoutWorker : public QObject
+{
+    Q_OBJECT
+
+    const NodeTree &tree_;
+
+    const VisualFlags &vis_flags_;
+
+    Layout &front_;
+
+    Layout back_;
+
+    LayoutComputer computer_;
+
+    /// Protects the flags below
+    std::mutex state_mutex_;
+    std::condition_variable state_cv_;
+
+    /// Another pass is required
+    bool requested_ = false;
+
+    /// A pass is being computed
+    bool running_ = false;
+
+    /// A completed pass is waiting for `publish`
+    bool awaiting_publish_ = false;
+
+    bool stop_ = false;
+
+    /// Nesting level of `Pause` guards
+    int paused_ = 0;
+
+    /// Makes the computer abandon the current pass
+    std::atomic<bool> cancel_;
+
+    /// Held by the worker during a pass and by the GUI while paused
+    std::mutex pass_mutex_;
+
+    /// Memory taken by the back layout as of the last pass
+    std::atomic<size_t> back_memory_;
+
+    std::thread thread_;
+
+    void run();
+
+    void pause();
+
+    void resume();
+
+  public:
+    /// Lay out `tree` for `front`, which must outlive the worker
+    LayoutWorker(const NodeTree &tree, const VisualFlags &vf, Layout &front);
+    ~LayoutWorker();
+
+    /// Stops the worker for as long as it exists; guards can be nested
+    class Pause
+    {
+        LayoutWorker &worker_;
+
+      public:
+        explicit Pause(LayoutWorker &worker) : worker_(worker) { worker_.pause(); }
+        ~Pause() { worker_.resume(); }
+
+        Pause(const Pause &) = delete;
+        Pause &operator=(const Pause &) = delete;
+    };
+
+    /// The layout computer; only to be used while paused
+    LayoutComputer &computer() { return computer_; }
+
+    /// Bring the layout up to date (asynchronously)
+    void request();
+
+    /// Make the result of the last completed pass visible in the front
+    /// layout (GUI thread only); returns false if there was nothing new
+    bool publish();
+
+    /// Whether there is a pass that is running, pending or not yet published
+    bool busy();
+
+    /// Memory (in bytes) taken by the worker's own layout data
+    size_t memoryUsage() const { return back_memory_.load(); }
+
+  signals:
+    /// A pass is complete and can be published
+    void layoutReady();
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <QPainter>
 
+#include <utility>
+
 namespace cpprofiler
 {
 namespace tree
@@ -211,6 +213,136 @@ void lantern(QPainter &painter, int x, int y, int size, bool selected, bool has_
     painter.drawConvexPolygon(points, 5);
 }
 
+/// Add the polygon with `points` (relative to (`x`, `y`)) to `path`
+template <size_t N>
+static void add_polygon(QPainterPath &path, const QPointF (&points)[N], int x, int y)
+{
+    path.moveTo(x + points[0].x(), y + points[0].y());
+
+    for (size_t i = 1; i < N; ++i)
+    {
+        path.lineTo(x + points[i].x(), y + points[i].y());
+    }
+
+    path.closeSubpath();
+}
+
+NodeBatch::NodeBatch()
+{
+    reset();
+}
+
+void NodeBatch::reset()
+{
+    edges_.clear();
+    failed_.clear();
+    skipped_.clear();
+
+    for (auto path : {&solved_, &branch_, &unexplored_, &pentagons_, &bookmarks_})
+    {
+        *path = QPainterPath();
+        /// shapes of different nodes should not cancel out where they overlap
+        path->setFillRule(Qt::WindingFill);
+    }
+}
+
+void NodeBatch::edge(double x1, double y1, double x2, double y2)
+{
+    edges_.emplace_back(x1, y1, x2, y2);
+}
+
+void NodeBatch::solution(int x, int y)
+{
+    using namespace traditional;
+    static const QPointF diamond[4] = {QPointF(0, 0),
+                                       QPointF(HALF_SOL_W, HALF_SOL_W),
+                                       QPointF(0, SOL_WIDTH),
+                                       QPointF(-HALF_SOL_W, HALF_SOL_W)};
+    add_polygon(solved_, diamond, x, y);
+}
+
+void NodeBatch::failure(int x, int y)
+{
+    using namespace traditional;
+    failed_.emplace_back(x - HALF_FAILED_WIDTH, y, FAILED_WIDTH, FAILED_WIDTH);
+}
+
+void NodeBatch::branch(int x, int y)
+{
+    using namespace traditional;
+    branch_.addEllipse(x - HALF_BRANCH_W, y, BRANCH_WIDTH, BRANCH_WIDTH);
+}
+
+void NodeBatch::unexplored(int x, int y)
+{
+    using namespace traditional;
+    unexplored_.addEllipse(x - HALF_UNDET_WIDTH, y, UNDET_WIDTH, UNDET_WIDTH);
+}
+
+void NodeBatch::skipped(int x, int y)
+{
+    using namespace traditional;
+    skipped_.emplace_back(x - HALF_SKIPPED_WIDTH, y, SKIPPED_WIDTH, SKIPPED_WIDTH);
+}
+
+void NodeBatch::pentagon(int x, int y)
+{
+    using namespace traditional;
+    static const QPointF pentagon[5] = {QPointF(0, 0),
+                                        QPointF(PENTAGON_HALF_W, PENTAGON_THIRD_W),
+                                        QPointF(PENTAGON_THIRD_W, PENTAGON_WIDTH),
+                                        QPointF(-PENTAGON_THIRD_W, PENTAGON_WIDTH),
+                                        QPointF(-PENTAGON_HALF_W, PENTAGON_THIRD_W)};
+    add_polygon(pentagons_, pentagon, x, y);
+}
+
+void NodeBatch::bookmark(int x, int y)
+{
+    bookmarks_.addEllipse(x - 10, y, 10.0, 10.0);
+}
+
+void NodeBatch::flush(QPainter &painter)
+{
+    if (!edges_.empty())
+    {
+        painter.drawLines(edges_.data(), static_cast<int>(edges_.size()));
+    }
+
+    if (!failed_.empty())
+    {
+        painter.setBrush(colors::red);
+        painter.drawRects(failed_.data(), static_cast<int>(failed_.size()));
+    }
+
+    if (!skipped_.empty())
+    {
+        painter.setBrush(colors::grey);
+        painter.drawRects(skipped_.data(), static_cast<int>(skipped_.size()));
+    }
+
+    const std::pair<const QPainterPath *, const QColor *> paths[] = {{&solved_, &colors::green},
+                                                                     {&branch_, &colors::blue},
+                                                                     {&unexplored_, &colors::white},
+                                                                     {&pentagons_, &colors::pentagonColor}};
+
+    for (const auto &path : paths)
+    {
+        if (path.first->isEmpty())
+            continue;
+
+        painter.setBrush(*path.second);
+        painter.drawPath(*path.first);
+    }
+
+    if (!bookmarks_.isEmpty())
+    {
+        painter.setBrush(Qt::black);
+        painter.drawPath(bookmarks_);
+    }
+
+    reset();
+}
+
 } // namespace draw
 } // namespace tree
 } // namespace cpprofiler
\ No newline at end of file
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <QLineF>
+#include <QPainterPath>
+#include <QRectF>
+
+#include <vector>
+
 class QPainter;
 
 namespace cpprofiler
@@ -24,6 +30,44 @@ void big_pentagon(QPainter &painter, int x, int y, bool selected);
 
 void lantern(QPainter &painter, int x, int y, int size, bool selected, bool has_gradient, bool has_solutions);
 
+/// Nodes and edges collected during a drawing pass to be drawn type by type:
+/// the brush is set once per type (rather than once per node) and every type
+/// is drawn with a single call
+class NodeBatch
+{
+    std::vector<QLineF> edges_;
+
+    std::vector<QRectF> failed_;
+    std::vector<QRectF> skipped_;
+
+    QPainterPath solved_;
+    QPainterPath branch_;
+    QPainterPath unexplored_;
+    QPainterPath pentagons_;
+    QPainterPath bookmarks_;
+
+    void reset();
+
+  public:
+    NodeBatch();
+
+    void edge(double x1, double y1, double x2, double y2);
+
+    /// Same as the functions above for unselected nodes
+    void solution(int x, int y);
+    void failure(int x, int y);
+    void branch(int x, int y);
+    void unexplored(int x, int y);
+    void skipped(int x, int y);
+    void pentagon(int x, int y);
+
+    /// Bookmark mark of a node at (`x`, `y`)
+    void bookmark(int x, int y);
+
+    /// Draw everything collected so far (with the painter's current pen) and start over
+    void flush(QPainter &painter);
+};
+
 } // namespace draw
 } // namespace tree
 } // namespace cpprofiler
\ No newline at end of file
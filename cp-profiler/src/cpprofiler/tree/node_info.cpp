@@ -9,28 +9,31 @@ namespace tree
 
 constexpr NumFlagLoc STATUS = {0, 4};
 
+constexpr uint8_t NodeInfo::HAS_SOLVED_CHILDREN;
+constexpr uint8_t NodeInfo::HAS_OPEN_CHILDREN;
+
 void NodeInfoEntry::setFlag(NodeFlag flag, bool value)
 {
-    m_bitset[static_cast<int>(flag)] = value;
+    const auto bit = static_cast<uint8_t>(1 << static_cast<int>(flag));
+    m_bits = static_cast<uint8_t>(value ? (m_bits | bit) : (m_bits & ~bit));
 }
 
 bool NodeInfoEntry::getFlag(NodeFlag flag) const
 {
-    return m_bitset[static_cast<int>(flag)];
+    return (m_bits >> static_cast<int>(flag)) & 1;
 }
 
 void NodeInfoEntry::setNumericFlag(NumFlagLoc loc, int value)
 {
     uint32_t mask = (1 << loc.len) - 1;
     uint32_t clearmask = ~(mask << loc.pos);
-    m_bitset &= std::bitset<4>(clearmask);
-    m_bitset |= (value & mask) << loc.pos;
+    m_bits = static_cast<uint8_t>((m_bits & clearmask) | ((value & mask) << loc.pos));
 }
 
 int NodeInfoEntry::getNumericFlag(NumFlagLoc loc) const
 {
     uint32_t mask = (1 << loc.len) - 1;
-    return ((m_bitset >> loc.pos) & std::bitset<4>(mask)).to_ulong();
+    return (m_bits >> loc.pos) & mask;
 }
 
 } // namespace tree
@@ -43,6 +46,11 @@ namespace tree
 
 NodeStatus NodeInfo::getStatus(NodeID nid) const
 {
+    if (m_frozen.load(std::memory_order_acquire))
+    {
+        return static_cast<NodeStatus>(m_flags[nid].getNumericFlag(STATUS));
+    }
+
     utils::MutexLocker lock(&m_mutex, "node info");
     if (static_cast<int>(nid) >= m_flags.size())
         throw;
@@ -63,28 +71,32 @@ void NodeInfo::addEntry(NodeID nid)
     if (nid != m_flags.size())
         throw;
     m_flags.push_back({});
-    m_has_solved_children.push_back(false);
-    m_has_open_children.push_back(true);
+    m_children_flags.push_back(HAS_OPEN_CHILDREN);
 }
 
 void NodeInfo::setHasSolvedChildren(NodeID nid, bool val)
 {
-    m_has_solved_children[nid] = val;
+    setChildrenFlag(nid, HAS_SOLVED_CHILDREN, val);
 }
 
 bool NodeInfo::hasSolvedChildren(NodeID nid) const
 {
-    return m_has_solved_children[nid];
+    return (m_children_flags[nid] & HAS_SOLVED_CHILDREN) != 0;
 }
 
 void NodeInfo::setHasOpenChildren(NodeID nid, bool val)
 {
-    m_has_open_children[nid] = val;
+    setChildrenFlag(nid, HAS_OPEN_CHILDREN, val);
 }
 
 bool NodeInfo::hasOpenChildren(NodeID nid) const
 {
-    return m_has_open_children[nid];
+    return (m_children_flags[nid] & HAS_OPEN_CHILDREN) != 0;
+}
+
+size_t NodeInfo::memoryUsage() const
+{
+    return m_flags.capacity() * sizeof(NodeInfoEntry) + m_children_flags.capacity();
 }
 
 } // namespace tree
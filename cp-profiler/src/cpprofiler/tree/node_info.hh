@@ -3,10 +3,11 @@
 
 #include "../core.hh"
 
-#include <bitset>
+#include <atomic>
 #include <vector>
 #include <QMutex>
 #include "node_id.hh"
+#include "../utils/stable_vector.hh"
 
 namespace cpprofiler
 {
@@ -30,7 +31,8 @@ class NodeInfoEntry
 {
 
   private:
-    std::bitset<4> m_bitset;
+    /// Status and flag bits (the builder may update them while they are read)
+    utils::RelaxedAtomic<uint8_t> m_bits;
 
   public:
     void setFlag(NodeFlag flag, bool value);
@@ -45,10 +47,27 @@ class NodeInfo
 
     mutable utils::Mutex m_mutex;
 
-    std::vector<NodeInfoEntry> m_flags;
+    /// Set once statuses no longer change; `m_mutex` is not needed after that
+    std::atomic<bool> m_frozen{false};
 
-    std::vector<bool> m_has_solved_children;
-    std::vector<bool> m_has_open_children;
+    /// Per-node arrays (memory-mapped if `utils::mapped_storage_dir()` is set);
+    /// entries never move, so flags can be read while nodes are being added
+    utils::StableVector<NodeInfoEntry> m_flags;
+
+    /// `HAS_SOLVED_CHILDREN` and `HAS_OPEN_CHILDREN` bits for each node
+    utils::StableVector<utils::RelaxedAtomic<uint8_t>> m_children_flags;
+
+    static constexpr uint8_t HAS_SOLVED_CHILDREN = 1;
+    static constexpr uint8_t HAS_OPEN_CHILDREN = 2;
+
+    void setChildrenFlag(NodeID nid, uint8_t flag, bool val)
+    {
+        auto &flags = m_children_flags[nid];
+        if (val)
+            flags = static_cast<uint8_t>(flags | flag);
+        else
+            flags = static_cast<uint8_t>(flags & ~flag);
+    }
 
   public:
     NodeStatus getStatus(NodeID nid) const;
@@ -56,11 +75,17 @@ class NodeInfo
 
     void addEntry(NodeID nid);
 
+    /// Statuses are not modified after this call, so reading them needs no locking
+    void freeze() { m_frozen.store(true, std::memory_order_release); }
+
     void setHasSolvedChildren(NodeID nid, bool val);
     bool hasSolvedChildren(NodeID nid) const;
 
     void setHasOpenChildren(NodeID nid, bool val);
     bool hasOpenChildren(NodeID nid) const;
+
+    /// Memory (in bytes) reserved for node statuses and flags
+    size_t memoryUsage() const;
 };
 
 } // namespace tree
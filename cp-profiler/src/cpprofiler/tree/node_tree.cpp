@@ -1,19 +1,61 @@
 #include "node_tree.hh"
 
 #include "structure.hh"
+#include "frozen_structure.hh"
 #include "node_info.hh"
 #include "../solver_data.hh"
 #include "../utils/tree_utils.hh"
 #include "../name_map.hh"
 #include <QDebug>
 #include <cassert>
+#include <climits>
 
 namespace cpprofiler
 {
 namespace tree
 {
 
-NodeTree::NodeTree() : structure_{new Structure()}, node_info_(new NodeInfo)
+/// Innermost snapshot (of any tree) taken by the current thread
+static thread_local const NodeTree::ReadSnapshot *current_snapshot = nullptr;
+
+NodeTree::ReadSnapshot::ReadSnapshot(const NodeTree &tree)
+    : tree_(tree), prev_(current_snapshot), node_count_(tree.readLimit())
+{
+    /// registered before anything is read, so that `freeze` either sees
+    /// this reader or this reader sees the frozen structure
+    tree.active_readers_.fetch_add(1);
+
+    if (node_count_ == INT_MAX)
+    {
+        node_count_ = tree.published_count_.load(std::memory_order_acquire);
+    }
+    current_snapshot = this;
+}
+
+NodeTree::ReadSnapshot::~ReadSnapshot()
+{
+    current_snapshot = prev_;
+
+    tree_.leaveReader();
+}
+
+NodeTree::StructureAccess::StructureAccess(const NodeTree &tree)
+    : tree_(tree), registered_(tree.readLimit() == INT_MAX)
+{
+    /// (a snapshot of the tree counts as a reader already)
+    if (registered_)
+        tree.active_readers_.fetch_add(1);
+}
+
+NodeTree::StructureAccess::~StructureAccess()
+{
+    if (registered_)
+        tree_.leaveReader();
+}
+
+NodeTree::NodeTree()
+    : structure_{new Structure()}, frozen_(nullptr), node_info_(new NodeInfo),
+      published_count_(0), active_readers_(0), release_pending_(false)
 {
     qRegisterMetaType<NodeID>();
 }
@@ -33,7 +75,80 @@ void NodeTree::setNameMap(std::shared_ptr<const NameMap> nm)
 void NodeTree::addEntry(NodeID nid)
 {
     node_info_->addEntry(nid);
-    labels_.push_back({});
+    label_ids_.push_back(LabelPool::EMPTY);
+}
+
+void NodeTree::publish()
+{
+    published_count_.store(static_cast<int>(label_ids_.size()), std::memory_order_release);
+}
+
+void NodeTree::setDone()
+{
+    is_done_ = true;
+    freeze();
+}
+
+void NodeTree::freeze()
+{
+    utils::MutexLocker lock(&tree_mutex_, "freeze");
+
+    if (frozen_.load() || structure_->nodeCount() == 0)
+        return;
+
+    frozen_storage_.reset(new FrozenStructure(*structure_));
+    frozen_.store(frozen_storage_.get());
+
+    node_info_->freeze();
+
+    {
+        utils::MutexLocker labels_lock(&labels_mutex_, "labels");
+        label_pool_.compact();
+    }
+
+    /// readers that started before this point may still be using `structure_`
+    release_pending_.store(true);
+    if (active_readers_.load() == 0 && release_pending_.exchange(false))
+    {
+        releaseStructure();
+    }
+}
+
+bool NodeTree::refuseFrozen()
+{
+    if (!frozen_.load())
+        return false;
+
+    if (!late_nodes_reported_)
+    {
+        print("error: nodes received after the tree was done are ignored");
+        late_nodes_reported_ = true;
+    }
+
+    return true;
+}
+
+void NodeTree::releaseStructure() const
+{
+    structure_.reset();
+}
+
+void NodeTree::leaveReader() const
+{
+    if (active_readers_.fetch_sub(1) == 1 && release_pending_.exchange(false))
+    {
+        releaseStructure();
+    }
+}
+
+int NodeTree::readLimit() const
+{
+    for (auto snapshot = current_snapshot; snapshot; snapshot = snapshot->prev_)
+    {
+        if (&snapshot->tree_ == this)
+            return snapshot->node_count_;
+    }
+    return INT_MAX;
 }
 
 const NodeInfo &NodeTree::node_info() const
@@ -58,6 +173,9 @@ void NodeTree::promoteNode(NodeID nid, int kids, tree::NodeStatus status, Label
 
 NodeID NodeTree::createRoot(int kids, Label label)
 {
+    if (refuseFrozen())
+        return NodeID::NoNode;
+
     auto nid = structure_->createRoot(kids);
     addEntry(nid);
     setLabel(nid, label);
@@ -75,6 +193,8 @@ NodeID NodeTree::createRoot(int kids, Label label)
         node_info_->setStatus(child_nid, NodeStatus::UNDETERMINED);
     }
 
+    publish();
+
     node_stats_.add_undetermined(kids);
 
     emit structureUpdated();
@@ -85,6 +205,8 @@ NodeID NodeTree::createRoot(int kids, Label label)
 /// Note that this form does not create children
 void NodeTree::db_createRoot(NodeID nid, Label label)
 {
+    if (refuseFrozen())
+        return;
 
     structure_->db_createRoot(nid);
     addEntry(nid);
@@ -93,6 +215,8 @@ void NodeTree::db_createRoot(NodeID nid, Label label)
     node_stats_.inform_depth(1);
     node_stats_.add_branch(1);
     node_info_->setStatus(nid, NodeStatus::BRANCH);
+
+    publish();
 }
 
 static bool is_closing(NodeStatus status)
@@ -105,12 +229,17 @@ static bool is_closing(NodeStatus status)
 /// Note: alt is unnecessary here
 void NodeTree::db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, Label label)
 {
+    if (refuseFrozen())
+        return;
+
     structure_->db_addChild(nid, pid, alt);
     addEntry(nid);
 
     node_info_->setStatus(nid, status);
     setLabel(nid, label);
 
+    publish();
+
     emit childrenStructureChanged(pid);
 
     auto cur_depth = utils::calculate_depth(*this, nid);
@@ -128,12 +257,17 @@ void NodeTree::db_addChild(NodeID nid, NodeID pid, int alt, NodeStatus status, L
 
 void NodeTree::addExtraChild(NodeID pid)
 {
+    if (refuseFrozen())
+        return;
+
     const auto nid = structure_->addExtraChild(pid);
     addEntry(nid);
 
     node_info_->setStatus(nid, NodeStatus::UNDETERMINED);
     node_stats_.add_undetermined(1);
 
+    publish();
+
     emit childrenStructureChanged(pid);
 
     emit structureUpdated();
@@ -141,6 +275,8 @@ void NodeTree::addExtraChild(NodeID pid)
 
 NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStatus status, Label label)
 {
+    if (refuseFrozen())
+        return NodeID::NoNode;
 
     NodeID nid;
 
@@ -162,7 +298,6 @@ NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStat
     if (kids > 0)
     {
         structure_->addChildren(nid, kids);
-        emit childrenStructureChanged(nid); /// updates dirty status for nodes
 
         for (auto i = 0; i < kids; ++i)
         {
@@ -171,6 +306,10 @@ NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStat
             node_info_->setStatus(child_nid, NodeStatus::UNDETERMINED);
         }
 
+        /// the children must be visible by the time their layout is requested
+        publish();
+        emit childrenStructureChanged(nid); /// updates dirty status for nodes
+
         node_stats_.add_undetermined(kids);
 
         auto cur_depth = utils::calculate_depth(*this, nid);
@@ -199,21 +338,46 @@ NodeID NodeTree::promoteNode(NodeID parent_id, int alt, int kids, tree::NodeStat
 
 int NodeTree::nodeCount() const
 {
+    if (const auto frozen = frozen_.load())
+        return frozen->nodeCount();
+
+    const auto limit = readLimit();
+    if (limit != INT_MAX)
+        return limit;
+
+    const StructureAccess access(*this);
+    if (const auto frozen = access.frozen())
+        return frozen->nodeCount();
+
     return structure_->nodeCount();
 }
 
 NodeID NodeTree::getParent(NodeID nid) const
 {
+    if (const auto frozen = frozen_.load())
+        return frozen->getParent(nid);
+
+    const StructureAccess access(*this);
+    if (const auto frozen = access.frozen())
+        return frozen->getParent(nid);
+
     return structure_->getParent(nid);
 }
 
 NodeID NodeTree::getRoot() const
 {
-    return structure_->getRoot();
+    return NodeID{0};
 }
 
 NodeID NodeTree::getChild(NodeID nid, int alt) const
 {
+    if (const auto frozen = frozen_.load())
+        return frozen->getChild(nid, alt);
+
+    const StructureAccess access(*this);
+    if (const auto frozen = access.frozen())
+        return frozen->getChild(nid, alt);
+
     return structure_->getChild(nid, alt);
 }
 
@@ -229,7 +393,7 @@ const SolverData &NodeTree::solver_data() const
 
 utils::Mutex &NodeTree::treeMutex() const
 {
-    return structure_->getMutex();
+    return tree_mutex_;
 }
 
 NodeStatus NodeTree::getStatus(NodeID nid) const
@@ -239,7 +403,7 @@ NodeStatus NodeTree::getStatus(NodeID nid) const
 
 int NodeTree::getNumberOfSiblings(NodeID nid) const
 {
-    return structure_->getNumberOfSiblings(nid);
+    return childrenCount(getParent(nid));
 }
 
 int NodeTree::depth() const
@@ -249,11 +413,29 @@ int NodeTree::depth() const
 
 int NodeTree::getAlternative(NodeID nid) const
 {
+    if (const auto frozen = frozen_.load())
+        return frozen->getAlternative(nid);
+
+    const StructureAccess access(*this);
+    if (const auto frozen = access.frozen())
+        return frozen->getAlternative(nid);
+
     return structure_->getAlternative(nid);
 }
 
 int NodeTree::childrenCount(NodeID nid) const
 {
+    if (const auto frozen = frozen_.load())
+        return frozen->childrenCount(nid);
+
+    const auto limit = readLimit();
+    if (limit != INT_MAX)
+        return structure_->childrenCount(nid, limit);
+
+    const StructureAccess access(*this);
+    if (const auto frozen = access.frozen())
+        return frozen->childrenCount(nid);
+
     return structure_->childrenCount(nid);
 }
 
@@ -278,7 +460,18 @@ const Label NodeTree::getLabel(NodeID nid) const
     // auto uid = solver_data_->getSolverID(nid);
     // return uid.toString();
 
-    auto &orig = labels_.at(nid);
+    Label orig;
+    if (frozen_.load())
+    {
+        /// labels no longer change
+        orig = label_pool_.get(label_ids_.at(nid));
+    }
+    else
+    {
+        utils::MutexLocker lock(&labels_mutex_, "labels");
+        orig = label_pool_.get(label_ids_.at(nid));
+    }
+
     if (name_map_)
     {
         return name_map_->replaceNames(orig);
@@ -286,7 +479,35 @@ const Label NodeTree::getLabel(NodeID nid) const
     return orig;
 }
 
-const Nogood &NodeTree::getNogood(NodeID nid) const
+LabelID NodeTree::getLabelID(NodeID nid) const
+{
+    return label_ids_.at(nid);
+}
+
+size_t NodeTree::structureMemoryUsage() const
+{
+    if (const auto frozen = frozen_.load())
+        return frozen->memoryUsage();
+
+    const StructureAccess access(*this);
+    if (const auto frozen = access.frozen())
+        return frozen->memoryUsage();
+
+    return structure_->memoryUsage();
+}
+
+size_t NodeTree::nodeInfoMemoryUsage() const
+{
+    return node_info_->memoryUsage();
+}
+
+size_t NodeTree::labelMemoryUsage() const
+{
+    utils::MutexLocker lock(&labels_mutex_, "labels");
+    return label_pool_.memoryUsage() + label_ids_.capacity() * sizeof(LabelID);
+}
+
+Nogood NodeTree::getNogood(NodeID nid) const
 {
     return solver_data_->getNogood(nid);
 }
@@ -345,11 +566,17 @@ void NodeTree::closeNode(NodeID nid)
 
 void NodeTree::setLabel(NodeID nid, const Label &label)
 {
-    labels_[nid] = label;
+    utils::MutexLocker lock(&labels_mutex_, "labels");
+    label_ids_[nid] = label_pool_.intern(label);
 }
 
 void NodeTree::removeNode(NodeID nid)
 {
+    if (frozen_.load())
+    {
+        print("warning: cannot remove nodes from a finished tree");
+        return;
+    }
 
     const auto pid = getParent(nid);
     if (pid == NodeID::NoNode)
@@ -2,12 +2,15 @@
 #define CPPROFILER_TREE_NODE_TREE_HH
 
 #include <QObject>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <stack>
 #include "node_id.hh"
 #include "node.hh"
+#include "label_pool.hh"
 #include "../core.hh"
+#include "../utils/stable_vector.hh"
 
 #include "node_stats.hh"
 
@@ -23,6 +26,7 @@ namespace tree
 {
 
 class Structure;
+class FrozenStructure;
 class NodeInfo;
 
 static Label emptyLabel = {};
@@ -32,22 +36,48 @@ static Label emptyLabel = {};
 class NodeTree : public QObject
 {
     Q_OBJECT
-    /// Tree structural information
-    std::unique_ptr<Structure> structure_;
+    /// Protects the tree while it is being modified
+    mutable utils::Mutex tree_mutex_;
+    /// Tree structural information (released once the tree is frozen and no
+    /// reader is using it; the last reader may be the one releasing it, hence
+    /// `mutable`); readers without a snapshot go through `StructureAccess`
+    mutable std::unique_ptr<Structure> structure_;
+    /// Compact copy of the structure made when the tree is done
+    std::unique_ptr<FrozenStructure> frozen_storage_;
+    /// `frozen_storage_` once it is complete (readers check this first)
+    std::atomic<const FrozenStructure *> frozen_;
     /// Nodes' statuses and flags (has solved/open children etc.)
     std::unique_ptr<NodeInfo> node_info_;
     /// Mapping from ugly to nice names (if present, owned by Execution)
     std::shared_ptr<const NameMap> name_map_;
     /// Contains a mapping from node ids to their original solver ids (triplets)
     std::shared_ptr<SolverData> solver_data_;
-    /// Nodes' labels
-    std::vector<Label> labels_;
+    /// Distinct labels of the tree, each stored once
+    LabelPool label_pool_;
+    /// Protects `label_pool_`, which relocates its data as it grows
+    mutable utils::Mutex labels_mutex_;
+    /// Nodes' labels (as ids into `label_pool_`; memory-mapped like the structure)
+    utils::StableVector<LabelID> label_ids_;
+    /// Number of nodes (a prefix of all ids) whose structure, status and label
+    /// are complete; this is what readers with a `ReadSnapshot` get to see
+    std::atomic<int> published_count_;
+    /// Number of live `ReadSnapshot`s and `StructureAccess`es (which may be using `structure_`)
+    mutable std::atomic<int> active_readers_;
+    /// Whether `structure_` is to be released when the last snapshot goes away
+    mutable std::atomic<bool> release_pending_;
     /// Count of different types of nodes, tree depth
     NodeStats node_stats_;
 
     /// Indicates whether the tree is fully built
     bool is_done_ = false;
 
+    /// Whether nodes arriving after the tree was frozen have been reported
+    bool late_nodes_reported_ = false;
+
+    /// Whether the tree is frozen, in which case the node being added is dropped
+    /// (the structure it would go into may be gone); reported once per tree
+    bool refuseFrozen();
+
     /// Ensure all relevant data structures contain this node
     void addEntry(NodeID nid);
 
@@ -60,7 +90,71 @@ class NodeTree : public QObject
     /// Set closed and notify ancestors
     void closeNode(NodeID nid);
 
+    /// Make all nodes created so far visible to readers with a `ReadSnapshot`
+    void publish();
+
+    /// Number of nodes visible to the calling thread (INT_MAX if
+    /// it has no snapshot of this tree)
+    int readLimit() const;
+
+    /// Replace the structure with its frozen form (see `setDone`)
+    void freeze();
+
+    /// Release the build-time structure unless a snapshot might be reading it
+    void releaseStructure() const;
+
+    /// Stop counting the caller in `active_readers_`, releasing the
+    /// build-time structure if it was only kept for the last reader
+    void leaveReader() const;
+
+    /// Keeps the build-time structure alive during a single query by a thread
+    /// without a snapshot (counted as a reader meanwhile); as the tree may
+    /// have been frozen, and its structure released, just before, `frozen()`
+    /// is to be checked first
+    class StructureAccess
+    {
+        const NodeTree &tree_;
+        const bool registered_;
+
+      public:
+        explicit StructureAccess(const NodeTree &tree);
+        ~StructureAccess();
+
+        StructureAccess(const StructureAccess &) = delete;
+        StructureAccess &operator=(const StructureAccess &) = delete;
+
+        const FrozenStructure *frozen() const { return tree_.frozen_.load(); }
+    };
+
   public:
+    /// Lets the current thread read the tree without holding `treeMutex()`
+    /// while another thread keeps adding nodes
+    ///
+    /// While a snapshot is alive, queries made from the same thread only see
+    /// the nodes that were published when it was taken (nested snapshots of
+    /// the same tree share the outer one's view). Nodes are only ever added,
+    /// so these nodes stay valid; statuses and flags of visible nodes are
+    /// read as they are at the moment. Tree modifications other than adding
+    /// nodes (e.g. `removeNode`) still require `treeMutex()`.
+    class ReadSnapshot
+    {
+        const NodeTree &tree_;
+        const ReadSnapshot *prev_;
+        int node_count_;
+
+        friend class NodeTree;
+
+      public:
+        explicit ReadSnapshot(const NodeTree &tree);
+        ~ReadSnapshot();
+
+        ReadSnapshot(const ReadSnapshot &) = delete;
+        ReadSnapshot &operator=(const ReadSnapshot &) = delete;
+
+        /// Number of nodes visible through the snapshot
+        int nodeCount() const { return node_count_; }
+    };
+
     NodeTree();
     ~NodeTree();
 
@@ -77,7 +171,9 @@ class NodeTree : public QObject
 
     void setNameMap(std::shared_ptr<const NameMap> nm);
 
-    void setDone() { is_done_ = true; }
+    /// Mark the tree as finished; this compacts the structure into an
+    /// immutable form, after which nodes can no longer be added or removed
+    void setDone();
 
     bool isDone() const { return is_done_; }
 
@@ -113,6 +209,10 @@ class NodeTree : public QObject
     /// Get the total nuber of nodes (including undetermined)
     int nodeCount() const;
 
+    /// The immutable form of the structure (null until the tree is done);
+    /// it can be read without locks and supports subtree range queries
+    const FrozenStructure *frozen() const { return frozen_.load(); }
+
     /// Get the total nuber of siblings of `nid` including the node itself
     int getNumberOfSiblings(NodeID nid) const;
 
@@ -134,8 +234,24 @@ class NodeTree : public QObject
     /// Get the label of node `nid`
     const Label getLabel(NodeID nid) const;
 
+    /// Get the id of the label of node `nid` (names are not replaced);
+    /// nodes of this tree have equal labels iff they have equal ids
+    LabelID getLabelID(NodeID nid) const;
+
+    /// The pool of this tree's (original) labels
+    const LabelPool &labelPool() const { return label_pool_; }
+
+    /// Memory (in bytes) taken by the tree structure
+    size_t structureMemoryUsage() const;
+
+    /// Memory (in bytes) taken by node statuses and flags
+    size_t nodeInfoMemoryUsage() const;
+
+    /// Memory (in bytes) taken by labels
+    size_t labelMemoryUsage() const;
+
     /// Get the nogood of node `nid`
-    const Nogood &getNogood(NodeID nid) const;
+    Nogood getNogood(NodeID nid) const;
 
     /// Check if the node `nid` has solved children (ancestors?)
     bool hasSolvedChildren(NodeID nid) const;
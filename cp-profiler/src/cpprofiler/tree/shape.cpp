@@ -2,21 +2,85 @@
 #include "../config.hh"
 #include <QDebug>
 #include <ostream>
+#include <atomic>
+#include <vector>
 
 namespace cpprofiler
 {
 namespace tree
 {
 
-Shape::Shape(int height) : extents_(height) {}
+static uint64_t next_shape_id()
+{
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+Shape::Shape(int height) : extents_(height), height_(height), id_(next_shape_id()) {}
+
+Shape::Shape(std::initializer_list<Extent> init_list, const BoundingBox &bb)
+    : extents_{init_list}, height_{extents_.size()}, id_(next_shape_id()), bb_{bb} {}
+
+Shape::Shape(int stored, ShapePtr tail, int tail_start, int tail_shift)
+    : extents_(stored), tail_(std::move(tail)), tail_start_(tail_start), tail_shift_(tail_shift),
+      id_(next_shape_id())
+{
+    height_ = stored + (tail_ ? tail_->height() - tail_start_ : 0);
+}
+
+/// Tails waiting to be released by the outermost `~Shape` on this thread
+static thread_local std::vector<ShapePtr> pending_tails;
+static thread_local bool releasing_tails = false;
+
+Shape::~Shape()
+{
+    /// Releasing the tail right here could destroy a long chain of shapes
+    /// recursively and overflow the stack for very deep trees, so it is queued
+    /// and released by the outermost destructor instead. Only the shape being
+    /// destroyed is modified: a tail may still be revived through `ShapeCache`
+    /// by another layout thread even if nothing else seems to use it
+    if (!tail_)
+        return;
+
+    pending_tails.push_back(std::move(tail_));
+
+    if (releasing_tails)
+        return;
+
+    releasing_tails = true;
+    while (!pending_tails.empty())
+    {
+        auto tail = std::move(pending_tails.back());
+        pending_tails.pop_back();
+        tail.reset();
+    }
+    releasing_tails = false;
+}
+
+Shape::Cursor::Cursor(const Shape &shape, int depth) : shape_(&shape), depth_(depth), shift_(0)
+{
+    settle();
+}
+
+void Shape::Cursor::settle()
+{
+    while (depth_ >= shape_->extents_.size() && shape_->tail_)
+    {
+        depth_ += shape_->tail_start_ - shape_->extents_.size();
+        shift_ += shape_->tail_shift_;
+        shape_ = shape_->tail_.get();
+    }
+}
 
 std::ostream &operator<<(std::ostream &os, const cpprofiler::tree::Shape &s)
 {
     os << "{ height: " << s.height() << ", [ ";
 
-    for (auto i = 0; i < s.extents_.size(); ++i)
+    Shape::Cursor cursor(s);
+    for (auto i = 0; i < s.height(); ++i, ++cursor)
     {
-        os << "{" << s.extents_[i].l << ":" << s.extents_[i].r << "} ";
+        const auto extent = *cursor;
+        os << "{" << extent.l << ":" << extent.r << "} ";
     }
 
     return os << "]}";
@@ -2,7 +2,9 @@
 #define CPPROFILER_TREE_SHAPE
 
 #include "../utils/array.hh"
+#include <cstdint>
 #include <ostream>
+#include <memory>
 #include <initializer_list>
 
 namespace cpprofiler
@@ -36,34 +38,103 @@ struct BoundingBox
     }
 };
 
+class Shape;
+
+/// Shapes are immutable once computed and shared between nodes
+using ShapePtr = std::shared_ptr<const Shape>;
+
 /// Subtree's shape (outline) represented by extents on each depth level
+///
+/// Only the top levels of the outline are stored in the shape itself; below
+/// them the outline continues as another shape's outline (typically that of
+/// the deepest child) shifted along x, which is shared rather than copied.
+/// This keeps the memory taken by the shapes of a tree linear in the number of
+/// nodes (as opposed to nodes * depth if every shape stored all its levels).
 class Shape
 {
 
-    /// Shape's extents
+    /// Extents of the top levels
     utils::Array<Extent> extents_;
 
+    /// Shape continuing the outline below `extents_` (can be null)
+    ShapePtr tail_;
+
+    /// Level of `tail_` corresponding to the level right below `extents_`
+    int tail_start_ = 0;
+
+    /// Offset of `tail_` relative to this shape along x
+    int tail_shift_ = 0;
+
+    int height_;
+
+    /// Unique (never reused) identifier of the shape
+    uint64_t id_;
+
     /// Shapes's bounding box
     BoundingBox bb_;
 
     friend std::ostream &operator<<(std::ostream &, const Shape &);
 
   public:
+    /// Walks down the levels of a shape, following shared parts of the outline
+    class Cursor
+    {
+        const Shape *shape_;
+        /// current level in `shape_`
+        int depth_;
+        /// offset of `shape_` relative to the original shape
+        int shift_;
+
+        /// Move to the shape actually storing the current level
+        void settle();
+
+      public:
+        /// Start at level `depth` of `shape`
+        explicit Cursor(const Shape &shape, int depth = 0);
+
+        /// Extent at the current level
+        Extent operator*() const
+        {
+            const auto &e = shape_->extents_[depth_];
+            return {e.l + shift_, e.r + shift_};
+        }
+
+        /// Move one level down (must not go past the shape's height)
+        Cursor &operator++()
+        {
+            ++depth_;
+            settle();
+            return *this;
+        }
+    };
+
     /// Create a shape of depth/height of `height` with extents uninitialized
     explicit Shape(int height);
 
+    /// Create a shape with `stored` levels of uninitialized extents followed by
+    /// the levels of `tail` (starting from `tail_start`) shifted by `tail_shift`
+    Shape(int stored, ShapePtr tail, int tail_start, int tail_shift);
+
     /// Create a shape using initializer list and a pre-computed bounding box
-    Shape(std::initializer_list<Extent> init_list, const BoundingBox &bb)
-        : extents_{init_list}, bb_{bb} {}
+    Shape(std::initializer_list<Extent> init_list, const BoundingBox &bb);
+
+    ~Shape();
 
     /// Get the depth/height of the shape
-    int height() const { return extents_.size(); }
+    int height() const { return height_; }
+
+    /// Number of levels stored in this shape (the rest is shared)
+    int storedHeight() const { return extents_.size(); }
+
+    /// Identifier which, unlike the shape's address, is never reused
+    uint64_t id() const { return id_; }
 
-    /// Get the extent at `depth`
-    Extent &operator[](int depth) { return extents_[depth]; }
+    /// Get the extent at `depth`; takes time linear in `depth`, so
+    /// use `Cursor` for visiting consecutive levels
+    Extent operator[](int depth) const { return *Cursor(*this, depth); }
 
-    /// Get the extent at `depth`
-    const Extent &operator[](int depth) const { return extents_[depth]; }
+    /// Set the extent at `depth`, which must be one of the stored levels
+    void setExtent(int depth, Extent extent) { extents_[depth] = extent; }
 
     /// Set bounding box
     void setBoundingBox(BoundingBox bb) { bb_ = bb; }
@@ -77,19 +148,13 @@ class Shape
     static Shape hidden;
 };
 
-class ShapeDeleter
+/// Pointer to one of the static shapes (not owning, so not reference counted)
+inline ShapePtr static_shape(const Shape &shape)
 {
-  public:
-    void operator()(Shape *s)
-    {
-        if (s != &Shape::leaf && s != &Shape::hidden)
-        {
-            delete s;
-        }
-    }
-};
+    return ShapePtr(ShapePtr(), &shape);
+}
 
 } // namespace tree
 } // namespace cpprofiler
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,133 @@
+#include "shape_cache.hh"
+
+#include <functional>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+/// Entries are not checked for being unused until a shard has this many
+static constexpr size_t MIN_PURGE_SIZE = 1024;
+
+constexpr int ShapeCache::VISIBLE;
+constexpr int ShapeCache::COLLAPSED;
+
+static inline void hash_combine(size_t &seed, size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+bool ShapeCache::Key::operator==(const Key &other) const
+{
+    return kind == other.kind && top.l == other.top.l && top.r == other.top.r && kids == other.kids;
+}
+
+size_t ShapeCache::KeyHash::operator()(const Key &key) const
+{
+    size_t seed = std::hash<int>()(key.kind);
+    hash_combine(seed, std::hash<int>()(key.top.l));
+    hash_combine(seed, std::hash<int>()(key.top.r));
+
+    for (const auto kid : key.kids)
+    {
+        hash_combine(seed, std::hash<uint64_t>()(kid));
+    }
+
+    return seed;
+}
+
+ShapeCache::ShapeCache() : lookups_(0), hits_(0)
+{
+    for (auto &shard : shards_)
+    {
+        shard.purge_at = MIN_PURGE_SIZE;
+    }
+}
+
+ShapePtr ShapeCache::find(const Key &key, std::vector<int> &offsets) const
+{
+    lookups_.fetch_add(1, std::memory_order_relaxed);
+
+    auto &shard = shardFor(KeyHash()(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    const auto it = shard.entries.find(key);
+
+    if (it == shard.entries.end())
+        return nullptr;
+
+    auto shape = it->second.shape.lock();
+
+    if (shape)
+    {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        offsets = it->second.offsets;
+    }
+
+    return shape;
+}
+
+ShapePtr ShapeCache::insert(Key key, ShapePtr shape, std::vector<int> offsets)
+{
+    auto &shard = shardFor(KeyHash()(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto &entry = shard.entries[std::move(key)];
+
+    if (auto existing = entry.shape.lock())
+        return existing;
+
+    entry.shape = shape;
+    entry.offsets = std::move(offsets);
+
+    if (shard.entries.size() >= shard.purge_at)
+    {
+        for (auto it = shard.entries.begin(); it != shard.entries.end();)
+        {
+            if (it->second.shape.expired())
+            {
+                it = shard.entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        shard.purge_at = std::max(MIN_PURGE_SIZE, 2 * shard.entries.size());
+    }
+
+    return shape;
+}
+
+double ShapeCache::hitRate() const
+{
+    const auto total = lookups();
+    return total > 0 ? static_cast<double>(hits()) / total : 0;
+}
+
+size_t ShapeCache::memoryUsage() const
+{
+    size_t bytes = 0;
+
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        bytes += shard.entries.bucket_count() * sizeof(void *);
+
+        for (const auto &entry : shard.entries)
+        {
+            /// map node (two pointers' worth of overhead) plus the vectors' contents
+            bytes += sizeof(entry) + 2 * sizeof(void *) +
+                     entry.first.kids.capacity() * sizeof(uint64_t) +
+                     entry.second.offsets.capacity() * sizeof(int);
+        }
+    }
+
+    return bytes;
+}
+
+} // namespace tree
+} // namespace cpprofiler
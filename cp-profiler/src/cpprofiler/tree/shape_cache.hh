@@ -0,0 +1,105 @@
+#ifndef CPPROFILER_TREE_SHAPE_CACHE_HH
+#define CPPROFILER_TREE_SHAPE_CACHE_HH
+
+#include "shape.hh"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+/// Hash-consing table for layout shapes
+///
+/// A node's shape and its children's offsets only depend on the node's own
+/// extent, its kind (visible node, collapsed subtree or lantern) and its
+/// children's shapes. Structurally identical subtrees -- such as the countless
+/// failed subtrees of a typical search tree -- can therefore share a single
+/// immutable shape, which is looked up here instead of being recomputed.
+/// Since identical children already share their shapes, children are
+/// compared by their shapes' ids.
+///
+/// The cache does not keep shapes alive: entries whose shape is no longer
+/// used by any node are dropped from time to time. It can be used from
+/// several layout threads at once.
+class ShapeCache
+{
+  public:
+    /// Everything a node's shape is computed from
+    struct Key
+    {
+        /// `VISIBLE`, `COLLAPSED` or the size of a lantern
+        int kind;
+        /// The node's own (top) extent, which depends on its label
+        Extent top;
+        /// Ids of the children's shapes
+        std::vector<uint64_t> kids;
+
+        bool operator==(const Key &other) const;
+    };
+
+    static constexpr int VISIBLE = -1;
+    static constexpr int COLLAPSED = -2;
+
+  private:
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const;
+    };
+
+    struct Entry
+    {
+        std::weak_ptr<const Shape> shape;
+        /// Offsets of the children relative to the node
+        std::vector<int> offsets;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<Key, Entry, KeyHash> entries;
+        /// Drop unused entries once there are this many
+        size_t purge_at;
+    };
+
+    static constexpr int SHARDS = 16;
+
+    /// Split to reduce contention between layout threads
+    mutable std::array<Shard, SHARDS> shards_;
+
+    mutable std::atomic<long long> lookups_;
+    mutable std::atomic<long long> hits_;
+
+    Shard &shardFor(size_t hash) const { return shards_[(hash >> 8) % SHARDS]; }
+
+  public:
+    ShapeCache();
+
+    /// Get the shape for `key` (null if there is none) and its children's offsets
+    ShapePtr find(const Key &key, std::vector<int> &offsets) const;
+
+    /// Remember `shape` (computed for `key`); returns the shape to be used,
+    /// which is an identical one if another thread has just added it
+    ShapePtr insert(Key key, ShapePtr shape, std::vector<int> offsets);
+
+    long long lookups() const { return lookups_.load(std::memory_order_relaxed); }
+
+    long long hits() const { return hits_.load(std::memory_order_relaxed); }
+
+    /// Fraction of lookups that found a shape (0 if there were none)
+    double hitRate() const;
+
+    /// Memory (in bytes) taken by the entries (not counting the shapes)
+    size_t memoryUsage() const;
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -0,0 +1,120 @@
+#include "spatial_index.hh"
+
+#include "node_tree.hh"
+#include "visual_flags.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+std::shared_ptr<const SpatialIndex> SpatialIndex::build(const NodeTree &tree, const Layout &layout,
+                                                        const VisualFlags &vf, NodeID root,
+                                                        const std::atomic<bool> *cancel)
+{
+    std::shared_ptr<SpatialIndex> index(new SpatialIndex);
+    index->root_ = root;
+
+    if (root == NodeID::NoNode || !layout.getLayoutDone(root))
+        return index;
+
+    NodeTree::ReadSnapshot snapshot(tree);
+
+    struct Item
+    {
+        NodeID nid;
+        int x;
+        int parent_x;
+        int depth;
+    };
+
+    /// pre-order, left to right: every row is filled from left to right
+    std::vector<Item> stack{{root, 0, 0, 0}};
+
+    int visited = 0;
+
+    while (!stack.empty())
+    {
+        const auto item = stack.back();
+        stack.pop_back();
+
+        if (++visited % 4096 == 0 && cancel && cancel->load(std::memory_order_relaxed))
+            return nullptr;
+
+        if (static_cast<int>(index->rows_.size()) <= item.depth)
+        {
+            index->rows_.resize(item.depth + 1);
+        }
+
+        const auto &top = (*layout.getShape(item.nid))[0];
+        auto left = item.x + top.l;
+        auto right = item.x + top.r;
+
+        if (item.nid != root)
+        {
+            left = std::min(left, item.parent_x);
+            right = std::max(right, item.parent_x);
+        }
+
+        index->rows_[item.depth].entries.push_back({item.nid, item.x, left, right});
+
+        if (vf.isHidden(item.nid))
+        {
+            index->max_node_rows_ = std::max(index->max_node_rows_, layout.getHeight(item.nid));
+            continue;
+        }
+
+        /// as drawn by `DrawingCursor`: children up to the first one without layout
+        const auto kids = tree.childrenCount(item.nid);
+        auto drawn = 0;
+        while (drawn < kids && layout.getLayoutDone(tree.getChild(item.nid, drawn)))
+        {
+            ++drawn;
+        }
+
+        for (auto alt = drawn - 1; alt >= 0; --alt)
+        {
+            const auto kid = tree.getChild(item.nid, alt);
+            const auto x = static_cast<int>(item.x + layout.getOffset(kid));
+            stack.push_back({kid, x, item.x, item.depth + 1});
+        }
+    }
+
+    for (auto &row : index->rows_)
+    {
+        auto &entries = row.entries;
+        entries.shrink_to_fit();
+
+        const auto count = entries.size();
+        row.max_right.resize(count);
+        row.min_left.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            row.max_right[i] = i == 0 ? entries[i].right : std::max(row.max_right[i - 1], entries[i].right);
+        }
+
+        for (size_t i = count; i-- > 0;)
+        {
+            row.min_left[i] = i + 1 == count ? entries[i].left : std::min(row.min_left[i + 1], entries[i].left);
+        }
+    }
+
+    return index;
+}
+
+size_t SpatialIndex::memoryUsage() const
+{
+    size_t bytes = sizeof(SpatialIndex) + rows_.capacity() * sizeof(Row);
+
+    for (const auto &row : rows_)
+    {
+        bytes += row.entries.capacity() * sizeof(Entry);
+        bytes += (row.max_right.capacity() + row.min_left.capacity()) * sizeof(int);
+    }
+
+    return bytes;
+}
+
+} // namespace tree
+} // namespace cpprofiler
@@ -0,0 +1,122 @@
+#ifndef CPPROFILER_TREE_SPATIAL_INDEX_HH
+#define CPPROFILER_TREE_SPATIAL_INDEX_HH
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "node_id.hh"
+#include "layout.hh"
+#include "shape.hh"
+#include "../config.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+class NodeTree;
+class VisualFlags;
+
+/// The nodes drawn by the traditional view, by depth and in left-to-right
+/// order, so that the nodes in any area can be found without traversing the
+/// tree from the root
+///
+/// The horizontal spans of a row (a node's top extent together with the edge
+/// to its parent) are not necessarily ordered: the layout only separates
+/// adjacent siblings, so the subtrees of non-adjacent ones may interleave.
+/// Each row therefore also keeps the running maximum of the spans' right
+/// ends and the running minimum (from the right) of their left ends, both of
+/// which are monotone and can be searched with a binary search.
+class SpatialIndex
+{
+  public:
+    struct Entry
+    {
+        NodeID nid;
+        /// Position relative to the root
+        int x;
+        /// Horizontal span covered by the drawing of the node and the edge to its parent
+        int left;
+        int right;
+    };
+
+  private:
+    struct Row
+    {
+        std::vector<Entry> entries;
+        /// Largest `right` among `entries[0..i]`
+        std::vector<int> max_right;
+        /// Smallest `left` among `entries[i..]`
+        std::vector<int> min_left;
+    };
+
+    NodeID root_;
+
+    std::vector<Row> rows_;
+
+    /// How many rows the tallest collapsed node (triangle or lantern) covers
+    int max_node_rows_ = 1;
+
+    SpatialIndex() = default;
+
+  public:
+    /// Index the nodes under `root` that `DrawingCursor` would draw: not below
+    /// collapsed nodes and with their layout done; returns null if `cancel`
+    /// is set meanwhile
+    static std::shared_ptr<const SpatialIndex> build(const NodeTree &tree, const Layout &layout,
+                                                     const VisualFlags &vf, NodeID root,
+                                                     const std::atomic<bool> *cancel = nullptr);
+
+    NodeID root() const { return root_; }
+
+    /// Call `fun(nid, x, depth)` for every node whose drawing might intersect
+    /// the area (relative to the root) between `left` and `right` and between
+    /// `top` and `bottom`
+    template <typename Fun>
+    void query(int left, int right, int top, int bottom, Fun &&fun) const;
+
+    /// Memory (in bytes) taken by the index
+    size_t memoryUsage() const;
+};
+
+template <typename Fun>
+void SpatialIndex::query(int left, int right, int top, int bottom, Fun &&fun) const
+{
+    if (rows_.empty())
+        return;
+
+    /// parts of collapsed nodes (and labels) stick out of their top extent
+    left -= traditional::MAX_NODE_W;
+    right += traditional::MAX_NODE_W;
+
+    /// a row also covers the edges leading to it and the collapsed nodes hanging from it
+    const auto reach = (max_node_rows_ + 1) * layout::dist_y;
+    const auto first_row = std::max(0, (top - reach) / layout::dist_y);
+    const auto last_row = std::min(static_cast<int>(rows_.size()) - 1, (bottom + layout::dist_y) / layout::dist_y);
+
+    for (auto depth = first_row; depth <= last_row; ++depth)
+    {
+        const auto &row = rows_[depth];
+
+        /// nothing before the first entry reaching `left`, nothing after the
+        /// last one starting before `right`
+        const auto first = std::lower_bound(row.max_right.begin(), row.max_right.end(), left) - row.max_right.begin();
+        const auto last = std::upper_bound(row.min_left.begin(), row.min_left.end(), right) - row.min_left.begin();
+
+        for (auto i = first; i < last; ++i)
+        {
+            const auto &e = row.entries[i];
+            if (e.left <= right && e.right >= left)
+            {
+                fun(e.nid, e.x, depth);
+            }
+        }
+    }
+}
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -6,26 +6,16 @@
 #include <algorithm>
 #include <QDebug>
 
-using cpprofiler::utils::Mutex;
-
 namespace cpprofiler
 {
 namespace tree
 {
 
-Structure::Structure()
-{
-    nodes_.reserve(100);
-}
-
-Mutex &Structure::getMutex() const
-{
-    return mutex_;
-}
+Structure::Structure() = default;
 
 NodeID Structure::createRoot(int kids)
 {
-    if (nodes_.size() > 0)
+    if (parent_.size() > 0)
     {
         throw invalid_tree();
     }
@@ -41,22 +31,67 @@ NodeID Structure::createRoot(int kids)
     return root_nid;
 }
 
+int Structure::allocateChildren(int kids)
+{
+    const auto first = static_cast<int>(children_.size());
+    children_.resize(children_.size() + kids, NodeID::NoNode);
+    return first;
+}
+
+void Structure::growChildren(NodeID nid)
+{
+    const int kids = child_count_[nid];
+    const int first = first_child_[nid];
+
+    const auto cap_it = extra_capacity_.find(nid);
+    const auto capacity = cap_it != extra_capacity_.end() ? cap_it->second : kids;
+
+    if (kids < capacity)
+        return;
+
+    /// the last block can simply be extended
+    if (kids == 0 || first + kids == static_cast<int>(children_.size()))
+    {
+        if (kids == 0)
+            first_child_[nid] = static_cast<int>(children_.size());
+        children_.push_back(NodeID::NoNode);
+        if (cap_it != extra_capacity_.end())
+            extra_capacity_.erase(cap_it);
+        return;
+    }
+
+    /// otherwise move the block to the end, leaving room for as many children again
+    /// (this is rare: only the root of a restart tree and trees loaded from a database
+    /// get their children one at a time)
+    const auto new_capacity = kids * 2;
+    const auto new_first = allocateChildren(new_capacity);
+    for (auto i = 0; i < kids; ++i)
+        children_[new_first + i] = children_[first + i];
+
+    first_child_[nid] = new_first;
+    extra_capacity_[nid] = new_capacity;
+}
+
 NodeID Structure::createNode(NodeID pid, int kids)
 {
-    const auto nid = NodeID{static_cast<int>(nodes_.size())};
-    nodes_.push_back(std::unique_ptr<Node>{new Node(pid, kids)});
+    const auto nid = NodeID{static_cast<int>(parent_.size())};
+    parent_.push_back(pid);
+    first_child_.push_back(kids > 0 ? allocateChildren(kids) : 0);
+    child_count_.push_back(kids);
     return nid;
 }
 
 void Structure::db_createNode(NodeID nid, NodeID pid, int kids)
 {
-    nodes_[nid] = std::unique_ptr<Node>{new Node(pid, kids)};
+    parent_[nid] = pid;
+    first_child_[nid] = kids > 0 ? allocateChildren(kids) : 0;
+    child_count_[nid] = kids;
 }
 
 NodeID Structure::createChild(NodeID pid, int alt, int kids)
 {
     const auto nid = createNode(pid, kids);
-    nodes_[pid]->setChild(nid, alt);
+    children_[first_child_[pid] + alt] = nid;
     return nid;
 }
 
@@ -66,7 +101,8 @@ NodeID Structure::addExtraChild(NodeID pid)
     const auto alt = childrenCount(pid);
 
     /// make room for another child
-    nodes_[pid]->addChild();
+    growChildren(pid);
+    ++child_count_[pid];
 
     auto kid = createChild(pid, alt, 0);
     return kid;
@@ -74,10 +110,11 @@ NodeID Structure::addExtraChild(NodeID pid)
 
 void Structure::addChildren(NodeID nid, int kids)
 {
-    if (nodes_[nid]->childrenCount() > 0)
+    if (child_count_[nid] > 0)
         throw;
 
-    nodes_[nid]->setNumberOfChildren(kids);
+    first_child_[nid] = allocateChildren(kids);
+    child_count_[nid] = kids;
 
     for (auto i = 0; i < kids; ++i)
     {
@@ -88,22 +125,59 @@ void Structure::addChildren(NodeID nid, int kids)
 /// Remove `alt` child of `pid`
 void Structure::removeChild(NodeID pid, int alt)
 {
-    nodes_[pid]->removeChild(alt);
+    const int kids = child_count_[pid];
+
+    if (alt < 0 || alt >= kids)
+        throw no_child();
+
+    /// the block keeps its size; the freed slot becomes spare capacity
+    const int first = first_child_[pid];
+    for (auto i = alt + 1; i < kids; ++i)
+        children_[first + i - 1] = children_[first + i];
+
+    const auto cap_it = extra_capacity_.find(pid);
+    if (cap_it == extra_capacity_.end())
+        extra_capacity_[pid] = kids;
+
+    --child_count_[pid];
 }
 
 NodeID Structure::getChild(NodeID pid, int alt) const
 {
-    return nodes_[pid]->getChild(alt);
+    return children_[first_child_[pid] + alt];
 }
 
 NodeID Structure::getParent(NodeID nid) const
 {
-    return nodes_[nid]->getParent();
+    return parent_[nid];
 }
 
 int Structure::childrenCount(NodeID pid) const
 {
-    return nodes_[pid]->childrenCount();
+    return child_count_[pid];
+}
+
+int Structure::childrenCount(NodeID pid, int limit) const
+{
+    const int first = first_child_[pid];
+    const auto slots = static_cast<int>(children_.size());
+
+    /// A concurrent writer may have updated the count (or moved the block)
+    /// before linking the children, so trailing slots are validated
+    int kids = child_count_[pid];
+    while (kids > 0)
+    {
+        const auto idx = first + kids - 1;
+        if (idx >= 0 && idx < slots)
+        {
+            const NodeID kid = children_[idx];
+            if (kid >= 0 && kid < limit && parent_[kid] == pid)
+                break;
+        }
+        --kids;
+    }
+
+    return kids;
 }
 
 int Structure::getNumberOfSiblings(NodeID nid) const
@@ -137,12 +211,24 @@ int Structure::getAlternative(NodeID nid) const
 
 int Structure::nodeCount() const
 {
-    return nodes_.size();
+    return parent_.size();
+}
+
+size_t Structure::memoryUsage() const
+{
+    return parent_.capacity() * sizeof(NodeID) +
+           first_child_.capacity() * sizeof(int) +
+           child_count_.capacity() * sizeof(int) +
+           children_.capacity() * sizeof(NodeID) +
+           extra_capacity_.size() * (2 * sizeof(int) + 2 * sizeof(void *));
 }
 
 void Structure::db_initialize(int size)
 {
-    nodes_.resize(size);
+    parent_.resize(size, NodeID::NoNode);
+    first_child_.resize(size, 0);
+    child_count_.resize(size, 0);
+    children_.reserve(size);
 }
 
 void Structure::db_createRoot(NodeID nid)
@@ -153,12 +239,13 @@ void Structure::db_createRoot(NodeID nid)
 void Structure::db_createChild(NodeID nid, NodeID pid, int alt)
 {
     db_createNode(nid, pid, 0);
-    nodes_[pid]->setChild(nid, alt);
+    children_[first_child_[pid] + alt] = nid;
 }
 
 void Structure::db_addChild(NodeID nid, NodeID pid, int alt)
 {
-    nodes_[pid]->addChild();
+    growChildren(pid);
+    ++child_count_[pid];
     db_createChild(nid, pid, alt);
 }
 
@@ -4,8 +4,11 @@
 #include "node.hh"
 
 #include "../core.hh"
+#include "../utils/stable_vector.hh"
 
-#include "memory"
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace cpprofiler
 {
@@ -29,11 +32,34 @@ class LayoutComputer;
 class Structure
 {
 
-    /// Protects `nodes_`
-    mutable utils::Mutex mutex_;
+    /// The structure is stored as parallel arrays indexed by NodeID;
+    /// each node's children occupy a contiguous block of `children_`
+    /// (the arrays are memory-mapped if `utils::mapped_storage_dir()` is set).
+    /// The arrays are append-only and never relocate their elements, so readers
+    /// may use them without the mutex while the tree is growing (see `childrenCount`);
+    /// entries the builder rewrites after adding them are accessed atomically
 
-    /// Nodes that describe the structure of the tree
-    std::vector<std::unique_ptr<Node>> nodes_;
+    /// Parent of each node (NodeID::NoNode for the root)
+    utils::StableVector<NodeID> parent_;
+
+    /// Position of each node's first child in `children_`
+    utils::StableVector<utils::RelaxedAtomic<int>> first_child_;
+
+    /// Number of children of each node
+    utils::StableVector<utils::RelaxedAtomic<int>> child_count_;
+
+    /// Arena holding the children of all nodes
+    utils::StableVector<utils::RelaxedAtomic<NodeID>> children_;
+
+    /// Size of a node's block in `children_` if it is larger than its
+    /// number of children (only for nodes whose children were added one by one)
+    std::unordered_map<int, int> extra_capacity_;
+
+    /// Reserve a block for `kids` children at the end of `children_`
+    int allocateChildren(int kids);
+
+    /// Make room in the block of `nid` for one more child, moving the block if necessary
+    void growChildren(NodeID nid);
 
     /// Allocate memory for a new node and return its Id
     NodeID createNode(NodeID pid, int kids);
@@ -46,9 +72,6 @@ class Structure
   public:
     Structure();
 
-    /// Get mutex protecting structural information
-    utils::Mutex &getMutex() const;
-
     /// Get the identifier of the root (should be 0)
     NodeID getRoot() const;
 
@@ -67,9 +90,17 @@ class Structure
     /// Get the total number of children of node `pid`
     int childrenCount(NodeID pid) const;
 
+    /// Get the number of children of node `pid` among the first `limit` nodes;
+    /// safe to call without the mutex: children that are being added
+    /// concurrently (or that are not yet fully linked) are not counted
+    int childrenCount(NodeID pid, int limit) const;
+
     /// Get the total nuber of nodes (including undetermined)
     int nodeCount() const;
 
+    /// Approximate memory used for the structure (in bytes)
+    size_t memoryUsage() const;
+
     /// ************ Modifying (building) a tree ************
 
     /// Create a root node and `kids` children
@@ -0,0 +1,99 @@
+#include "tile_cache.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+TileCache::TileCache(size_t capacity) : capacity_(capacity)
+{
+}
+
+TileCache::Key TileCache::key(float scale, int x, int y)
+{
+    return {static_cast<int>(std::lround(scale * 1000)), x, y};
+}
+
+QRectF TileCache::area(const Key &key)
+{
+    const auto scale = key.scale / 1000.0;
+    const auto size = TILE_SIZE / scale;
+    return QRectF(key.x * size, key.y * size, size, size);
+}
+
+const QImage *TileCache::find(const Key &key)
+{
+    const auto it = tiles_.find(key);
+
+    if (it == tiles_.end())
+        return nullptr;
+
+    it->second.last_used = clock_;
+    return &it->second.image;
+}
+
+void TileCache::insert(const Key &key, QImage image)
+{
+    tiles_[key] = Tile{std::move(image), clock_};
+
+    if (tiles_.size() <= capacity_)
+        return;
+
+    /// evict the least recently used tiles, but none of those still on screen
+    std::vector<std::pair<uint64_t, Key>> by_use;
+    by_use.reserve(tiles_.size());
+
+    for (const auto &tile : tiles_)
+    {
+        if (tile.second.last_used != clock_)
+        {
+            by_use.emplace_back(tile.second.last_used, tile.first);
+        }
+    }
+
+    const auto excess = std::min(tiles_.size() - capacity_, by_use.size());
+
+    std::partial_sort(by_use.begin(), by_use.begin() + excess, by_use.end(),
+                      [](const std::pair<uint64_t, Key> &a, const std::pair<uint64_t, Key> &b) {
+                          return a.first < b.first;
+                      });
+
+    for (size_t i = 0; i < excess; ++i)
+    {
+        tiles_.erase(by_use[i].second);
+    }
+}
+
+void TileCache::invalidate(const QRectF &area)
+{
+    for (auto it = tiles_.begin(); it != tiles_.end();)
+    {
+        if (TileCache::area(it->first).intersects(area))
+        {
+            it = tiles_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+size_t TileCache::memoryUsage() const
+{
+    size_t bytes = 0;
+
+    for (const auto &tile : tiles_)
+    {
+        bytes += static_cast<size_t>(tile.second.image.sizeInBytes());
+    }
+
+    return bytes;
+}
+
+} // namespace tree
+} // namespace cpprofiler
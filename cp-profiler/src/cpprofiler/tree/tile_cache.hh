@@ -0,0 +1,90 @@
+#ifndef CPPROFILER_TREE_TILE_CACHE_HH
+#define CPPROFILER_TREE_TILE_CACHE_HH
+
+#include <QImage>
+#include <QRect>
+
+#include <cstdint>
+#include <map>
+#include <tuple>
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+/// Images of parts of a drawn tree in fixed-size tiles, so that scrolling
+/// only needs to draw what has not been visible before
+///
+/// Tiles are placed relative to the tree's root (tile (0, 0) has the root
+/// at its top left corner) in device pixels at a given scale, so they stay
+/// valid when the view is scrolled or the tree grows to the left.
+class TileCache
+{
+  public:
+    /// Width and height of a tile in device pixels
+    static constexpr int TILE_SIZE = 256;
+
+    struct Key
+    {
+        /// Scale in thousandths
+        int scale;
+        int x;
+        int y;
+
+        bool operator<(const Key &other) const
+        {
+            return std::tie(scale, x, y) < std::tie(other.scale, other.x, other.y);
+        }
+    };
+
+  private:
+    struct Tile
+    {
+        QImage image;
+        /// Value of `clock_` when the tile was last used
+        uint64_t last_used;
+    };
+
+    std::map<Key, Tile> tiles_;
+
+    /// Number of tiles kept beyond those used by the latest paint
+    size_t capacity_;
+
+    /// Incremented on every paint (`startPaint`)
+    uint64_t clock_ = 0;
+
+  public:
+    explicit TileCache(size_t capacity);
+
+    /// Key for the tile at (`x`, `y`) drawn at `scale`
+    static Key key(float scale, int x, int y);
+
+    /// Area covered by the tile with `key` in (unscaled) coordinates
+    /// relative to the root
+    static QRectF area(const Key &key);
+
+    /// Called before a paint: tiles used from now on are not evicted
+    /// until the next paint
+    void startPaint() { ++clock_; }
+
+    /// The image for `key` if cached
+    const QImage *find(const Key &key);
+
+    void insert(const Key &key, QImage image);
+
+    /// Remove the tiles (at any scale) intersecting `area`, given in
+    /// (unscaled) coordinates relative to the root
+    void invalidate(const QRectF &area);
+
+    /// Remove all tiles
+    void clear() { tiles_.clear(); }
+
+    /// Memory (in bytes) taken by the images
+    size_t memoryUsage() const;
+};
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
@@ -27,7 +27,9 @@
 #include "shape.hh"
 #include "../user_data.hh"
 #include "../solver_data.hh"
+#include "../execution.hh"
 #include "layout_computer.hh"
+#include "layout_worker.hh"
 #include "../config.hh"
 
 #include "../nogood_dialog.hh"
@@ -46,7 +48,7 @@ TraditionalView::TraditionalView(const NodeTree &tree, UserData &ud, SolverData
       solver_data_(sd),
       vis_flags_(utils::make_unique<VisualFlags>()),
       layout_(utils::make_unique<Layout>()),
-      layout_computer_(utils::make_unique<LayoutComputer>(tree, *layout_, *vis_flags_))
+      layout_worker_(utils::make_unique<LayoutWorker>(tree, *vis_flags_, *layout_))
 {
     utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
 
@@ -60,13 +62,15 @@ TraditionalView::TraditionalView(const NodeTree &tree, UserData &ud, SolverData
 
     connect(this, &TraditionalView::needsRedrawing, this, &TraditionalView::redraw);
     connect(this, &TraditionalView::needsLayoutUpdate, this, &TraditionalView::updateLayout);
+    connect(layout_worker_.get(), &LayoutWorker::layoutReady, this, &TraditionalView::publishLayout);
 
     connect(&tree, &NodeTree::childrenStructureChanged, [this](NodeID nid) {
         if (nid == NodeID::NoNode)
         {
             return;
         }
-        layout_computer_->dirtyUpLater(nid);
+        /// (safe to call while the worker is running)
+        layout_worker_->computer().dirtyUpLater(nid);
         // layout_->setLayoutDone(nid, false);
     });
 
@@ -214,8 +218,10 @@ void TraditionalView::navRight()
 
 void TraditionalView::setLabelShown(NodeID nid, bool val)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
+
     vis_flags_->setLabelShown(nid, val);
-    layout_computer_->dirtyUpLater(nid);
+    dirtyUp(nid);
 }
 
 void TraditionalView::toggleShowLabel()
@@ -227,7 +233,6 @@ void TraditionalView::toggleShowLabel()
     auto val = !vis_flags_->isLabelShown(nid);
     setLabelShown(nid, val);
     emit needsRedrawing();
-    layout_computer_->dirtyUpLater(nid);
 }
 
 void TraditionalView::showLabelsDown()
@@ -238,6 +243,8 @@ void TraditionalView::showLabelsDown()
 
     auto val = !vis_flags_->isLabelShown(nid);
 
+    LayoutWorker::Pause pause(*layout_worker_);
+
     utils::pre_order_apply(tree_, nid, [val, this](NodeID nid) {
         setLabelShown(nid, val);
     });
@@ -263,6 +270,8 @@ void TraditionalView::showLabelsUp()
 
     auto val = !vis_flags_->isLabelShown(pid);
 
+    LayoutWorker::Pause pause(*layout_worker_);
+
     while (nid != NodeID::NoNode)
     {
         setLabelShown(nid, val);
@@ -280,25 +289,42 @@ static bool is_leaf(const NodeTree &nt, NodeID nid)
 
 void TraditionalView::hideNode(NodeID n, bool delayed)
 {
-    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
-    utils::DebugMutexLocker layout_lock(&layout_->getMutex());
-
-    if (is_leaf(tree_, n))
-        return;
-
-    vis_flags_->setHidden(n, true);
-
-    dirtyUp(n);
+    nodes_to_hide_.push_back(n);
 
     if (delayed)
     {
+        /// hidden in batches by `autoUpdate` rather than
+        /// interrupting the layout computation for every node
         setLayoutOutdated();
+        return;
     }
-    else
+
+    hidePendingNodes();
+
+    emit needsLayoutUpdate();
+    emit needsRedrawing();
+}
+
+void TraditionalView::hidePendingNodes()
+{
+    if (nodes_to_hide_.empty())
+        return;
+
+    LayoutWorker::Pause pause(*layout_worker_);
+    utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex());
+
+    for (const auto n : nodes_to_hide_)
     {
-        emit needsLayoutUpdate();
+        if (is_leaf(tree_, n))
+            continue;
+
+        vis_flags_->setHidden(n, true);
+
+        dirtyUp(n);
     }
-    emit needsRedrawing();
+
+    nodes_to_hide_.clear();
 }
 
 void TraditionalView::toggleHidden()
@@ -311,6 +337,8 @@ void TraditionalView::toggleHidden()
     if (is_leaf(tree_, nid))
         return;
 
+    LayoutWorker::Pause pause(*layout_worker_);
+
     auto val = !vis_flags_->isHidden(nid);
     vis_flags_->setHidden(nid, val);
 
@@ -328,7 +356,9 @@ void TraditionalView::hideFailedAt(NodeID n, bool onlyDirty)
 
     bool modified = false;
 
-    HideFailedCursor hfc(n, tree_, *vis_flags_, *layout_computer_, onlyDirty, modified);
+    LayoutWorker::Pause pause(*layout_worker_);
+
+    HideFailedCursor hfc(n, tree_, *vis_flags_, layout_worker_->computer(), onlyDirty, modified);
     PostorderNodeVisitor<HideFailedCursor>(hfc).run();
 
     if (modified)
@@ -349,14 +379,12 @@ void TraditionalView::hideFailed(bool onlyDirty)
 
 void TraditionalView::autoUpdate()
 {
+    hidePendingNodes();
+
     if (!layout_stale_)
         return;
 
-    const auto changed = updateLayout();
-    if (changed)
-    {
-        emit needsRedrawing();
-    }
+    updateLayout();
 }
 
 void TraditionalView::handleDoubleClick()
@@ -383,6 +411,8 @@ void TraditionalView::handleDoubleClick()
 
 void TraditionalView::toggleCollapsePentagon(NodeID nid)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
+
     /// Use the same 'hidden' flag for now
     auto val = !vis_flags_->isHidden(nid);
     vis_flags_->setHidden(nid, val);
@@ -391,14 +421,24 @@ void TraditionalView::toggleCollapsePentagon(NodeID nid)
     emit needsRedrawing();
 }
 
+/// Stop drawing below `nid` until its new layout is published
+static void reset_layout_done(Layout &layout, NodeID nid)
+{
+    if (layout.ready(nid))
+    {
+        layout.setLayoutDone(nid, false);
+    }
+}
+
 void TraditionalView::setNodeHidden(NodeID n, bool val)
 {
     vis_flags_->setHidden(n, false);
-    layout_->setLayoutDone(n, false);
+    reset_layout_done(*layout_, n);
 }
 
 void TraditionalView::unhideNode(NodeID nid)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
     utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
     utils::DebugMutexLocker layout_lock(&layout_->getMutex());
 
@@ -433,11 +473,13 @@ void TraditionalView::bookmarkCurrentNode()
         user_data_.clearBookmark(nid);
     }
 
+    scroll_area_->invalidateNode(nid);
     emit needsRedrawing();
 }
 
 void TraditionalView::unhideAllAt(NodeID n)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
     utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
     utils::DebugMutexLocker layout_lock(&layout_->getMutex());
 
@@ -454,7 +496,7 @@ void TraditionalView::unhideAllAt(NodeID n)
         if (vis_flags_->isHidden(n))
         {
             vis_flags_->setHidden(n, false);
-            layout_->setLayoutDone(n, false);
+            reset_layout_done(*layout_, n);
             dirtyUp(n);
             modified = true;
         }
@@ -480,10 +522,12 @@ void TraditionalView::unhideAll()
         return;
     }
 
+    LayoutWorker::Pause pause(*layout_worker_);
+
     for (auto n : vis_flags_->hidden_nodes())
     {
         dirtyUp(n);
-        layout_->setLayoutDone(n, false);
+        reset_layout_done(*layout_, n);
     }
 
     vis_flags_->unhideAll();
@@ -508,6 +552,9 @@ void TraditionalView::toggleHighlighted()
     if (nid == NodeID::NoNode)
         return;
 
+    /// may grow the flag vectors the worker is reading
+    LayoutWorker::Pause pause(*layout_worker_);
+
     auto val = !vis_flags_->isHighlighted(nid);
     vis_flags_->setHighlighted(nid, val);
 
@@ -524,6 +571,18 @@ const Layout &TraditionalView::layout() const
     return *layout_;
 }
 
+LayoutWorker &TraditionalView::layoutWorker()
+{
+    return *layout_worker_;
+}
+
+void TraditionalView::addMemoryUsage(MemoryReport &report) const
+{
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex());
+    report.layout += layout_->memoryUsage() + layout_worker_->memoryUsage() + scroll_area_->indexMemoryUsage();
+    report.visual_flags += vis_flags_->memoryUsage();
+}
+
 void TraditionalView::setScale(int val)
 {
     scroll_area_->setScale(val);
@@ -546,10 +605,19 @@ static int global_node_x_offset(const NodeTree &tree, const Layout &layout, Node
 /// Does this need any locking?
 void TraditionalView::centerNode(NodeID nid)
 {
+    /// the node is likely to move once the pending layout is published
+    if (layout_worker_->busy())
+    {
+        center_after_layout_ = nid;
+    }
+
+    const auto root_nid = tree_.getRoot();
+
+    if (!layout_->getLayoutDone(root_nid) || !layout_->ready(nid))
+        return;
 
     const auto x_offset = global_node_x_offset(tree_, *layout_, nid);
 
-    const auto root_nid = tree_.getRoot();
     const auto bb = layout_->getBoundingBox(root_nid);
 
     const auto value_x = x_offset - bb.left;
@@ -577,12 +645,24 @@ void TraditionalView::setAndCenterNode(NodeID nid)
     centerNode(nid);
 }
 
-bool TraditionalView::updateLayout()
+void TraditionalView::updateLayout()
 {
-    const auto changed = layout_computer_->compute();
+    layout_worker_->request();
     layout_stale_ = false;
+}
 
-    return changed;
+void TraditionalView::publishLayout()
+{
+    if (!layout_worker_->publish())
+        return;
+
+    if (center_after_layout_ != NodeID::NoNode)
+    {
+        centerNode(center_after_layout_);
+        center_after_layout_ = NodeID::NoNode;
+    }
+
+    emit needsRedrawing();
 }
 
 void TraditionalView::setLayoutOutdated()
@@ -592,7 +672,7 @@ void TraditionalView::setLayoutOutdated()
 
 void TraditionalView::dirtyUp(NodeID nid)
 {
-    layout_computer_->dirtyUpLater(nid);
+    layout_worker_->computer().dirtyUpLater(nid);
 }
 
 void TraditionalView::dirtyCurrentNodeUp()
@@ -621,7 +701,7 @@ void TraditionalView::printNodeInfo()
     print("has solved kids: {}, ", tree_.hasSolvedChildren(nid));
     print("has open kids: {}", tree_.hasOpenChildren(nid));
 
-    const auto &ng = tree_.getNogood(nid);
+    const auto ng = tree_.getNogood(nid);
 
     if (ng.has_renamed())
     {
@@ -669,10 +749,11 @@ class TreeHighlighter : public QThread
 
 void TraditionalView::revealNode(NodeID n)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
     utils::DebugMutexLocker t_locker(&tree_.treeMutex());
     utils::DebugMutexLocker l_locker(&layout_->getMutex());
 
-    layout_computer_->dirtyUpUnconditional(n);
+    layout_worker_->computer().dirtyUpUnconditional(n);
 
     while (n != NodeID::NoNode)
     {
@@ -686,6 +767,8 @@ void TraditionalView::revealNode(NodeID n)
 
 void TraditionalView::highlightSubtrees(const std::vector<NodeID> &nodes, bool hide_rest, bool show_outline)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
+
     vis_flags_->unhighlightAll();
 
     detail::PerformanceHelper phelper;
@@ -700,7 +783,7 @@ void TraditionalView::highlightSubtrees(const std::vector<NodeID> &nodes, bool h
         unhideAll();
 
         auto root = tree_.getRoot();
-        HideNotHighlightedCursor hnhc(root, tree_, *vis_flags_, *layout_computer_);
+        HideNotHighlightedCursor hnhc(root, tree_, *vis_flags_, layout_worker_->computer());
         PostorderNodeVisitor<HideNotHighlightedCursor>(hnhc).run();
 
         emit needsLayoutUpdate();
@@ -721,6 +804,7 @@ void TraditionalView::highlightSubtrees(const std::vector<NodeID> &nodes, bool h
 /// Lantern Tree Visualisation
 void TraditionalView::hideBySize(int size_limit)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
     utils::DebugMutexLocker tree_lock(&tree_.treeMutex());
 
     unhideAll();
@@ -762,7 +846,7 @@ void TraditionalView::hideBySize(int size_limit)
                 /// lantern size
                 auto lsize = (size * max_lantern) / size_limit;
                 vis_flags_->setLanternSize(n, lsize);
-                layout_->setLayoutDone(n, false);
+                reset_layout_done(*layout_, n);
                 dirtyUp(n);
             }
         }
@@ -776,6 +860,7 @@ void TraditionalView::hideBySize(int size_limit)
 
 void TraditionalView::undoLanterns()
 {
+    LayoutWorker::Pause pause(*layout_worker_);
     vis_flags_->resetLanternSizes();
 }
 
@@ -825,22 +910,75 @@ void TraditionalView::showNogoods() const
     ng_dialog->show();
 }
 
+/// Whether shapes `s1` and `s2` (either of which can be null) are identical
+static bool same_shape(const Shape *s1, const Shape *s2)
+{
+    if (!s1 || !s2)
+        return s1 == s2;
+
+    if (s1->height() != s2->height() ||
+        s1->boundingBox().left != s2->boundingBox().left ||
+        s1->boundingBox().right != s2->boundingBox().right)
+        return false;
+
+    Shape::Cursor c1(*s1);
+    Shape::Cursor c2(*s2);
+    for (auto depth = 0; depth < s1->height(); ++depth, ++c1, ++c2)
+    {
+        if ((*c1).l != (*c2).l || (*c1).r != (*c2).r)
+            return false;
+    }
+
+    return true;
+}
+
 void TraditionalView::debugCheckLayout() const
 {
-    ///
+    /// Recompute the layout from scratch on a single thread and compare it
+    /// with the current one (which might have been computed in parallel)
+    LayoutWorker::Pause pause(*layout_worker_);
+
+    Layout reference;
+    LayoutComputer reference_computer(tree_, reference, *vis_flags_);
+    reference_computer.setParallel(false);
+    reference_computer.setDebugMode(layout_worker_->computer().debugMode());
+    reference_computer.compute();
+
+    utils::DebugMutexLocker layout_lock(&layout_->getMutex());
+
     const auto order = utils::any_order(tree_);
 
+    int compared = 0;
+    int mismatches = 0;
+
     for (const auto n : order)
     {
-        auto bb = layout_->getBoundingBox(n);
-        // print("bb for {} is fine", n);
+        /// only nodes that have an up-to-date layout in both
+        if (!layout_->getLayoutDone(n) || !reference.getLayoutDone(n) || layout_->isDirty(n))
+            continue;
+
+        ++compared;
+
+        if (!same_shape(layout_->getShape(n), reference.getShape(n)) ||
+            layout_->getOffset(n) != reference.getOffset(n))
+        {
+            if (mismatches < 10)
+            {
+                print("layout check: node {} differs from sequential layout", n);
+            }
+            ++mismatches;
+        }
     }
+
+    print("layout check: {} nodes compared, {} mismatches", compared, mismatches);
 }
 
 void TraditionalView::setDebugMode(bool v)
 {
+    LayoutWorker::Pause pause(*layout_worker_);
+
     scroll_area_->setDebugMode(true);
-    layout_computer_->setDebugMode(true);
+    layout_worker_->computer().setDebugMode(true);
     emit needsLayoutUpdate();
     emit needsRedrawing();
 }
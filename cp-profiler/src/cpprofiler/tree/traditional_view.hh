@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 #include "node_id.hh"
 #include "visual_flags.hh"
 
@@ -12,6 +13,7 @@ namespace cpprofiler
 {
 class UserData;
 class SolverData;
+struct MemoryReport;
 } // namespace cpprofiler
 
 namespace cpprofiler
@@ -20,7 +22,7 @@ namespace tree
 {
 
 class Layout;
-class LayoutComputer;
+class LayoutWorker;
 class NodeTree;
 class NodeID;
 class Structure;
@@ -43,11 +45,11 @@ class TraditionalView : public QObject
     /// Visual flags (hidden/highlighted etc) per node
     std::unique_ptr<VisualFlags> vis_flags_;
 
-    /// Layout: shapes of every node
+    /// Layout: shapes of every node (as last published by `layout_worker_`)
     std::unique_ptr<Layout> layout_;
 
-    /// Responsible for keeping the layout up to date
-    std::unique_ptr<LayoutComputer> layout_computer_;
+    /// Responsible for keeping the layout up to date (in the background)
+    std::unique_ptr<LayoutWorker> layout_worker_;
 
     /// The area the tree is actually drawn onto
     std::unique_ptr<TreeScrollArea> scroll_area_;
@@ -58,12 +60,21 @@ class TraditionalView : public QObject
     /// Only update layout if it is stale
     bool layout_stale_ = true;
 
+    /// Node to center again once the pending layout is published
+    NodeID center_after_layout_ = NodeID::NoNode;
+
+    /// Nodes to be hidden on the next `autoUpdate`
+    std::vector<NodeID> nodes_to_hide_;
+
     /// Sets nid as the currently selected node
     void setNode(NodeID nid);
 
     /// Set the node as hidden/shown based on `val`
     void setNodeHidden(NodeID nid, bool val);
 
+    /// Hide the nodes collected by `hideNode`
+    void hidePendingNodes();
+
   public:
     TraditionalView(const NodeTree &tree, UserData &ud, SolverData &sd);
     ~TraditionalView();
@@ -80,6 +91,12 @@ class TraditionalView : public QObject
     /// Exposes layout info (i.e. shapes needed for shape analysis)
     const Layout &layout() const;
 
+    /// The thread computing the layout (to be paused while modifying the tree)
+    LayoutWorker &layoutWorker();
+
+    /// Add the memory taken by the layout and visual flags to `report`
+    void addMemoryUsage(MemoryReport &report) const;
+
     /// Collapse/uncollapse a pentagon node based on its current state
     void toggleCollapsePentagon(NodeID nid);
 
@@ -152,7 +169,7 @@ class TraditionalView : public QObject
     /// Show labels for every node on the path form root to current
     void showLabelsUp();
 
-    /// Hides node `n`; immediately updates layout if delayed is false
+    /// Hides node `n`; hides it and updates layout immediately if delayed is false
     void hideNode(NodeID n, bool delayed = true);
 
     /// Set current node as not hidden
@@ -185,9 +202,12 @@ class TraditionalView : public QObject
     /// Highlight/unhighlight subtree
     void toggleHighlighted();
 
-    /// Unconditionally update layout (ignoring if it is "stale")
-    /// returns false if no change was required
-    bool updateLayout();
+    /// Unconditionally update layout (ignoring if it is "stale");
+    /// the layout is computed in the background and redrawn when ready
+    void updateLayout();
+
+    /// Show the layout computed in the background
+    void publishLayout();
 
     /// Set layout as stale
     void setLayoutOutdated();
@@ -0,0 +1,126 @@
+#include "tree_image.hh"
+
+#include <QPainter>
+
+#include <cmath>
+
+#include "layout.hh"
+#include "layout_computer.hh"
+#include "node_tree.hh"
+#include "shape.hh"
+#include "visual_flags.hh"
+#include "node_drawing.hh"
+#include "cursors/nodevisitor.hh"
+#include "cursors/drawing_cursor.hh"
+#include "../user_data.hh"
+
+#include "../utils/debug.hh"
+#include "../utils/tiled_image_writer.hh"
+#include "../config.hh"
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+/// Space around the tree (unscaled)
+constexpr int image_margin = 20;
+
+/// Subtrees narrower than this many pixels are drawn as a single shape
+/// (as in the traditional view)
+constexpr int lod_min_width = 8;
+
+void save_tree_image(const NodeTree &nt, const char *path, float scale)
+{
+    if (nt.nodeCount() == 0 || scale <= 0)
+    {
+        print("Error: nothing to draw into \"{}\"", path);
+        return;
+    }
+
+    const auto root = nt.getRoot();
+
+    VisualFlags vis_flags;
+    UserData user_data;
+    Layout layout;
+
+    {
+        LayoutComputer computer(nt, layout, vis_flags);
+        computer.compute();
+    }
+
+    if (!layout.ready(root) || !layout.getLayoutDone(root))
+    {
+        print("Error: could not lay out the tree for \"{}\"", path);
+        return;
+    }
+
+    const auto bb = layout.getBoundingBox(root);
+    const auto tree_height = layout.getHeight(root) * layout::dist_y;
+
+    /// the root is at (0, 0); this is the part of the plane in the image
+    const QRect area{bb.left - image_margin, -image_margin, bb.width() + 2 * image_margin,
+                     tree_height + 2 * image_margin};
+
+    const QSize size{static_cast<int>(std::ceil(area.width() * scale)),
+                     static_cast<int>(std::ceil(area.height() * scale))};
+
+    utils::TiledImageWriter writer(path, size);
+
+    if (writer.rows() > 1 || writer.columns() > 1)
+    {
+        print("saving tree image ({}x{} pixels) as {}x{} tiles", size.width(), size.height(), writer.rows(),
+              writer.columns());
+    }
+
+    const int lod_width = traditional::MAX_NODE_W * scale >= lod_min_width
+                              ? 0
+                              : static_cast<int>(std::ceil(lod_min_width / scale));
+
+    for (auto row = 0; row < writer.rows(); ++row)
+    {
+        for (auto col = 0; col < writer.columns(); ++col)
+        {
+            const auto tile_rect = writer.tileRect(row, col);
+
+            QImage tile(tile_rect.size(), QImage::Format_RGB32);
+            tile.fill(Qt::white);
+
+            {
+                QPainter painter(&tile);
+                painter.setRenderHint(QPainter::Antialiasing);
+
+                {
+                    QPen pen = painter.pen();
+                    pen.setWidth(2);
+                    painter.setPen(pen);
+                }
+
+                painter.translate(-tile_rect.x(), -tile_rect.y());
+                painter.scale(scale, scale);
+                painter.translate(-area.x(), -area.y());
+
+                /// the tile in unscaled coordinates, relative to the root
+                const QRect clip{
+                    QPoint{static_cast<int>(std::floor(tile_rect.left() / scale)) + area.x(),
+                           static_cast<int>(std::floor(tile_rect.top() / scale)) + area.y()},
+                    QPoint{static_cast<int>(std::ceil((tile_rect.right() + 1) / scale)) + area.x(),
+                           static_cast<int>(std::ceil((tile_rect.bottom() + 1) / scale)) + area.y()}};
+
+                draw::NodeBatch batch;
+
+                DrawingCursor dc(root, nt, layout, user_data, vis_flags, painter, QPoint{0, 0}, clip, false, false,
+                                 lod_width, &batch);
+                PreorderNodeVisitor<DrawingCursor>(dc).run();
+
+                batch.flush(painter);
+            }
+
+            if (!writer.write(row, col, tile))
+                return;
+        }
+    }
+}
+
+} // namespace tree
+} // namespace cpprofiler
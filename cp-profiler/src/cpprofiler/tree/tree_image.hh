@@ -0,0 +1,22 @@
+#ifndef CPPROFILER_TREE_TREE_IMAGE_HH
+#define CPPROFILER_TREE_TREE_IMAGE_HH
+
+namespace cpprofiler
+{
+namespace tree
+{
+
+class NodeTree;
+
+/// Draw `nt` as in the traditional view (nothing hidden or selected) at
+/// `scale` into an image file at `path` without creating any widgets
+///
+/// The tree is laid out from scratch; the image is drawn and saved one tile
+/// at a time (see `utils::TiledImageWriter`), so its size is only limited
+/// by disk space. Needs a GUI application (e.g. on the offscreen platform).
+void save_tree_image(const NodeTree &nt, const char *path, float scale);
+
+} // namespace tree
+} // namespace cpprofiler
+
+#endif
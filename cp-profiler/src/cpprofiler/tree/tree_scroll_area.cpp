@@ -4,6 +4,7 @@
 #include <QScrollBar>
 #include <QMouseEvent>
 
+#include <algorithm>
 #include <cmath>
 #include <stack>
 #include <queue>
@@ -12,10 +13,14 @@
 #include "shape.hh"
 #include "node_tree.hh"
 #include "visual_flags.hh"
+#include "spatial_index.hh"
 #include "cursors/nodevisitor.hh"
 #include "cursors/drawing_cursor.hh"
+#include "node_drawing.hh"
+#include "../user_data.hh"
 
 #include "../utils/perf_helper.hh"
+#include "../utils/work_stealing_pool.hh"
 #include "../utils/utils.hh"
 #include "../config.hh"
 
@@ -26,6 +31,12 @@ namespace tree
 
 constexpr int y_margin = 20;
 
+/// Subtrees narrower than this many (device) pixels are drawn as a single shape
+constexpr int lod_min_width = 8;
+
+/// Tiles kept besides the visible ones (256 tiles take 64MB)
+constexpr size_t max_cached_tiles = 256;
+
 static void drawGrid(QPainter &painter, QSize size)
 {
 
@@ -133,10 +144,372 @@ void TreeScrollArea::paintEvent(QPaintEvent *event)
 
     // drawGrid(painter, {std::max(tree_width, displayed_width), std::max(tree_height, displayed_height)});
 
-    utils::MutexLocker tree_locker(&m_tree.treeMutex());
+    /// drawing only needs the nodes that exist at this point,
+    /// so it does not stop the builder from adding more
+    NodeTree::ReadSnapshot snapshot(m_tree);
+
+    /// a finished tree only changes through user actions, so its drawing
+    /// is kept (in tiles) and scrolling mostly amounts to copying images
+    if (m_tree.isDone())
+    {
+        const QPoint root_pos{static_cast<int>(std::lround((start_pos.x() - x_off) * m_options.scale)),
+                              static_cast<int>(std::lround((start_pos.y() - y_off) * m_options.scale))};
+        drawTiles(painter, root_pos);
+    }
+    else
+    {
+        drawTree(painter, start_pos, clip);
+    }
+}
+
+int TreeScrollArea::lodWidth() const
+{
+    /// zoomed out far enough for nodes to be a few pixels wide, the number of
+    /// visible nodes is only bounded by the size of the tree; instead, subtrees
+    /// that would be too narrow to tell their nodes apart are drawn as one shape
+    if (traditional::MAX_NODE_W * m_options.scale >= lod_min_width)
+        return 0;
+
+    return static_cast<int>(std::ceil(lod_min_width / m_options.scale));
+}
+
+void TreeScrollArea::drawTree(QPainter &painter, QPoint start_pos, const QRect &clip)
+{
+    const auto lod_width = lodWidth();
+
+    /// nodes of the same type are drawn together, at the end
+    draw::NodeBatch batch;
+    painter.setPen(QColor{dark_mode_ ? Qt::white : Qt::black});
+
+    /// the index makes the time it takes to render a tile depend on the nodes
+    /// in it only (a growing tree is drawn by pruning subtrees instead)
+    if (lod_width == 0 && index_ && index_->root() == m_start_node && index_layout_version_ == m_layout.version())
+    {
+        drawIndexed(painter, *index_, start_pos, clip, batch);
+    }
+    else
+    {
+        DrawingCursor dc(m_start_node, m_tree, m_layout, user_data_, m_vis_flags, painter, start_pos, clip,
+                         debug_mode_, dark_mode_, lod_width, &batch);
+        PreorderNodeVisitor<DrawingCursor>(dc).run();
+    }
+
+    batch.flush(painter);
+}
+
+/// Rounds towards negative infinity (unlike `/`)
+static int floor_div(int a, int b)
+{
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+/// Threads rendering tiles (the painting thread counts as a worker)
+static utils::WorkStealingPool &tile_pool()
+{
+    static utils::WorkStealingPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+void TreeScrollArea::drawTiles(QPainter &painter, QPoint root_pos)
+{
+    constexpr int size = TileCache::TILE_SIZE;
+
+    updateTiles();
+    tiles_.startPaint();
+
+    const auto viewport_size = viewport()->size();
+
+    const auto first_x = floor_div(-root_pos.x(), size);
+    const auto last_x = floor_div(viewport_size.width() - 1 - root_pos.x(), size);
+    const auto first_y = floor_div(-root_pos.y(), size);
+    const auto last_y = floor_div(viewport_size.height() - 1 - root_pos.y(), size);
+
+    std::vector<TileCache::Key> missing;
+
+    for (auto y = first_y; y <= last_y; ++y)
+    {
+        for (auto x = first_x; x <= last_x; ++x)
+        {
+            const auto key = TileCache::key(m_options.scale, x, y);
+            if (!tiles_.find(key))
+            {
+                missing.push_back(key);
+            }
+        }
+    }
+
+    if (!missing.empty())
+    {
+        updateIndex();
+
+        /// worker threads only read the tree, layout and flags, which do
+        /// not change while the GUI thread is waiting for them here
+        std::vector<QImage> images(missing.size());
+        const auto font = viewport()->font();
+        const auto pixel_ratio = viewport()->devicePixelRatioF();
+
+        {
+            utils::WorkStealingPool::TaskGroup group(tile_pool());
+
+            for (size_t i = 0; i < missing.size(); ++i)
+            {
+                group.run([this, &missing, &images, &font, pixel_ratio, i]() {
+                    images[i] = renderTile(missing[i], font, pixel_ratio);
+                });
+            }
+        }
+
+        for (size_t i = 0; i < missing.size(); ++i)
+        {
+            tiles_.insert(missing[i], std::move(images[i]));
+        }
+    }
+
+    painter.save();
+    painter.resetTransform();
+
+    for (auto y = first_y; y <= last_y; ++y)
+    {
+        for (auto x = first_x; x <= last_x; ++x)
+        {
+            if (const auto image = tiles_.find(TileCache::key(m_options.scale, x, y)))
+            {
+                painter.drawImage(QPoint{root_pos.x() + x * size, root_pos.y() + y * size}, *image);
+            }
+        }
+    }
+
+    painter.restore();
+}
+
+QImage TreeScrollArea::renderTile(const TileCache::Key &key, const QFont &font, qreal pixel_ratio)
+{
+    constexpr int size = TileCache::TILE_SIZE;
+
+    NodeTree::ReadSnapshot snapshot(m_tree);
+
+    QImage image(static_cast<int>(std::ceil(size * pixel_ratio)), static_cast<int>(std::ceil(size * pixel_ratio)),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(pixel_ratio);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setFont(font);
+
+    {
+        QPen pen = painter.pen();
+        pen.setWidth(2);
+        painter.setPen(pen);
+    }
+
+    /// the start node is at the top left corner of tile (0, 0)
+    painter.translate(-key.x * size, -key.y * size);
+    painter.scale(m_options.scale, m_options.scale);
+
+    const auto area = TileCache::area(key);
+    const QRect clip{QPoint{static_cast<int>(std::floor(area.left())), static_cast<int>(std::floor(area.top()))},
+                     QPoint{static_cast<int>(std::ceil(area.right())), static_cast<int>(std::ceil(area.bottom()))}};
+
+    drawTree(painter, QPoint{0, 0}, clip);
+
+    return image;
+}
+
+void TreeScrollArea::updateTiles()
+{
+    const auto selected = user_data_.getSelectedNode();
+
+    std::vector<NodeID> changed;
+
+    if (m_layout.version() != tiles_layout_version_ ||
+        !m_vis_flags.changesSince(tiles_flags_version_, changed))
+    {
+        /// parents are centred over their kids, so changes to the layout
+        /// of a node tend to move most of the tree
+        tiles_.clear();
+    }
+    else
+    {
+        /// e.g. highlighted subtrees
+        for (const auto nid : changed)
+        {
+            tiles_.invalidate(nodeArea(nid, true));
+        }
 
-    DrawingCursor dc(m_start_node, m_tree, m_layout, user_data_, m_vis_flags, painter, start_pos, clip, debug_mode_, dark_mode_);
-    PreorderNodeVisitor<DrawingCursor>(dc).run();
+        if (selected != tiles_selected_)
+        {
+            invalidateSelection(tiles_selected_);
+            invalidateSelection(selected);
+        }
+    }
+
+    tiles_layout_version_ = m_layout.version();
+    tiles_flags_version_ = m_vis_flags.version();
+    tiles_selected_ = selected;
+}
+
+void TreeScrollArea::updateIndex()
+{
+    if (index_ && (index_layout_version_ != m_layout.version() || index_->root() != m_start_node))
+    {
+        index_.reset();
+    }
+
+    /// zoomed out, subtrees are drawn as single shapes by the cursor anyway
+    if (index_ || lodWidth() != 0)
+        return;
+
+    /// built once per layout of a finished tree rather than after every
+    /// layout pass, since it takes time and memory linear in the tree's size
+    index_ = SpatialIndex::build(m_tree, m_layout, m_vis_flags, m_start_node);
+    index_layout_version_ = m_layout.version();
+}
+
+size_t TreeScrollArea::indexMemoryUsage() const
+{
+    return index_ ? index_->memoryUsage() : 0;
+}
+
+void TreeScrollArea::invalidateSelection(NodeID nid)
+{
+    if (nid == NodeID::NoNode)
+        return;
+
+    const auto lod_width = lodWidth();
+
+    if (lod_width == 0)
+    {
+        tiles_.invalidate(nodeArea(nid, false));
+        return;
+    }
+
+    /// subtrees on the path to the selected node are never drawn as a single
+    /// shape, so the selection affects the highest of them that would be
+    auto top = nid;
+    for (auto n = nid; n != NodeID::NoNode; n = m_tree.getParent(n))
+    {
+        if (!m_layout.getLayoutDone(n))
+            break;
+
+        const auto &bb = m_layout.getBoundingBox(n);
+        if (bb.right - bb.left >= lod_width)
+            break;
+
+        top = n;
+
+        if (n == m_start_node)
+            break;
+    }
+
+    tiles_.invalidate(nodeArea(top, true));
+}
+
+QRectF TreeScrollArea::nodeArea(NodeID nid, bool subtree) const
+{
+    using namespace traditional;
+
+    if (!m_layout.getLayoutDone(nid))
+        return QRectF();
+
+    auto x = 0.0;
+    auto depth = 0;
+
+    for (auto n = nid; n != m_start_node; n = m_tree.getParent(n))
+    {
+        if (n == NodeID::NoNode)
+            return QRectF();
+
+        x += m_layout.getOffset(n);
+        ++depth;
+    }
+
+    const auto y = depth * layout::dist_y;
+
+    /// the node is drawn along with the edge to its parent
+    const auto parent_x = nid == m_start_node ? x : x - m_layout.getOffset(nid);
+
+    int left, right, rows;
+
+    if (subtree || m_vis_flags.isHidden(nid))
+    {
+        const auto &bb = m_layout.getBoundingBox(nid);
+        left = bb.left;
+        right = bb.right;
+        rows = m_layout.getHeight(nid) + 1;
+    }
+    else
+    {
+        const auto &extent = (*m_layout.getShape(nid))[0];
+        left = extent.l;
+        right = extent.r;
+        rows = 2;
+    }
+
+    return QRectF(QPointF(std::min(x + left, parent_x) - MAX_NODE_W, y - layout::dist_y),
+                  QPointF(std::max(x + right, parent_x) + MAX_NODE_W, y + rows * layout::dist_y));
+}
+
+void TreeScrollArea::drawIndexed(QPainter &painter, const SpatialIndex &index, QPoint start_pos, const QRect &clip,
+                                 draw::NodeBatch &batch)
+{
+    const auto left = clip.x() - start_pos.x();
+    const auto top = clip.y() - start_pos.y();
+
+    std::vector<NodeID> highlighted;
+
+    index.query(left, left + clip.width(), top, top + clip.height(), [&](NodeID nid, int x, int depth) {
+        if (m_vis_flags.isHighlighted(nid))
+        {
+            highlighted.push_back(nid);
+        }
+
+        draw_node(painter, m_tree, m_layout, user_data_, m_vis_flags, nid, m_start_node,
+                  start_pos.x() + x, start_pos.y() + depth * layout::dist_y, debug_mode_, dark_mode_, &batch);
+    });
+
+    /// Highlighted subtrees are outlined when their root is drawn,
+    /// which might be outside of the area (above it, typically)
+    std::sort(highlighted.begin(), highlighted.end());
+
+    for (const auto nid : m_vis_flags.highlighted_shapes())
+    {
+        if (std::binary_search(highlighted.begin(), highlighted.end(), nid) || !m_layout.getLayoutDone(nid))
+            continue;
+
+        /// only outline nodes that are drawn, i.e. not under a collapsed node
+        auto x = 0.0;
+        auto depth = 0;
+        auto drawn = true;
+
+        for (auto n = nid; n != m_start_node; n = m_tree.getParent(n))
+        {
+            const auto pid = m_tree.getParent(n);
+
+            if (pid == NodeID::NoNode || m_vis_flags.isHidden(pid))
+            {
+                drawn = false;
+                break;
+            }
+
+            x += m_layout.getOffset(n);
+            ++depth;
+        }
+
+        if (!drawn)
+            continue;
+
+        const auto &bb = m_layout.getBoundingBox(nid);
+        const auto node_x = start_pos.x() + static_cast<int>(x);
+        const auto node_y = start_pos.y() + depth * layout::dist_y;
+
+        const QRect area{node_x + bb.left, node_y, bb.right - bb.left, m_layout.getHeight(nid) * layout::dist_y};
+
+        if (area.intersects(clip))
+        {
+            draw_shape(painter, node_x, node_y, nid, m_layout);
+        }
+    }
 }
 
 QPoint TreeScrollArea::getNodeCoordinate(NodeID nid)
@@ -175,13 +548,14 @@ static std::pair<int, int> getRealBB(NodeID nid, const NodeTree &tree, const Lay
 void TreeScrollArea::setScale(int val)
 {
     m_options.scale = val / 50.0f;
+    tiles_.clear();
     viewport()->update();
 }
 
 /// Make sure the layout for nodes is done
 NodeID TreeScrollArea::findNodeClicked(int x, int y)
 {
-    utils::MutexLocker tree_lock(&m_tree.treeMutex());
+    NodeTree::ReadSnapshot snapshot(m_tree);
     utils::MutexLocker layout_lock(&m_layout.getMutex());
 
     using namespace traditional;
@@ -274,7 +648,8 @@ void TreeScrollArea::mouseDoubleClickEvent(QMouseEvent *me)
 }
 
 TreeScrollArea::TreeScrollArea(NodeID start, const NodeTree &tree, const UserData &user_data, const Layout &layout, const VisualFlags &nf)
-    : m_start_node(start), m_tree(tree), user_data_(user_data), m_layout(layout), m_vis_flags(nf)
+    : m_start_node(start), m_tree(tree), user_data_(user_data), m_layout(layout), m_vis_flags(nf),
+      tiles_(max_cached_tiles)
 {
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
@@ -296,11 +671,24 @@ void TreeScrollArea::centerPoint(int x, int y)
 void TreeScrollArea::changeStartNode(NodeID nid)
 {
     m_start_node = nid;
+    tiles_.clear();
+}
+
+void TreeScrollArea::setDebugMode(bool val)
+{
+    debug_mode_ = val;
+    tiles_.clear();
 }
 
 void TreeScrollArea::setDarkMode(bool d)
 {
     dark_mode_ = d;
+    tiles_.clear();
+}
+
+void TreeScrollArea::invalidateNode(NodeID nid)
+{
+    tiles_.invalidate(nodeArea(nid, false));
 }
 
 } // namespace tree
@@ -2,7 +2,12 @@
 
 #include <QAbstractScrollArea>
 
+#include <memory>
+
+class QPainter;
+
 #include "../core.hh"
+#include "tile_cache.hh"
 
 namespace cpprofiler
 {
@@ -17,6 +22,12 @@ namespace tree
 class NodeTree;
 class Layout;
 class VisualFlags;
+class SpatialIndex;
+
+namespace draw
+{
+class NodeBatch;
+}
 
 struct DisplayState
 {
@@ -43,9 +54,55 @@ class TreeScrollArea : public QAbstractScrollArea
     bool debug_mode_ = false;
     bool dark_mode_ = false;
 
+    /// Drawing of the finished tree, reused while scrolling (at the current scale only)
+    TileCache tiles_;
+
+    /// What the tiles in `tiles_` were drawn from
+    size_t tiles_layout_version_ = 0;
+    size_t tiles_flags_version_ = 0;
+    NodeID tiles_selected_ = NodeID::NoNode;
+
+    /// Index of the finished tree's nodes, used for rendering tiles
+    std::shared_ptr<const SpatialIndex> index_;
+
+    /// Layout version `index_` was built from
+    size_t index_layout_version_ = 0;
+
     QPoint getNodeCoordinate(NodeID nid);
     NodeID findNodeClicked(int x, int y);
 
+    /// Subtrees narrower than this are drawn as a single shape (0: never)
+    int lodWidth() const;
+
+    /// Draw the tree with the start node at `start_pos` (only the nodes in `clip`)
+    void drawTree(QPainter &painter, QPoint start_pos, const QRect &clip);
+
+    /// Draw the nodes in `clip` only, as found by `index` (into `batch` where possible)
+    void drawIndexed(QPainter &painter, const SpatialIndex &index, QPoint start_pos, const QRect &clip,
+                     draw::NodeBatch &batch);
+
+    /// Draw the viewport from cached tiles, rendering the missing ones
+    /// first; `root_pos` is the position of the start node in device pixels
+    void drawTiles(QPainter &painter, QPoint root_pos);
+
+    /// Render the tile with `key` (called from worker threads)
+    QImage renderTile(const TileCache::Key &key, const QFont &font, qreal pixel_ratio);
+
+    /// Remove the tiles outdated by changes to the layout, the visual flags
+    /// or the selected node
+    void updateTiles();
+
+    /// Build the index if tiles are about to be rendered from a layout
+    /// it does not reflect yet (GUI thread only)
+    void updateIndex();
+
+    /// Remove the tiles that depend on whether `nid` is selected
+    void invalidateSelection(NodeID nid);
+
+    /// Area (relative to the start node) covered by the drawing of `nid`
+    /// alone or with its subtree; empty if `nid` is not under the start node
+    QRectF nodeArea(NodeID nid, bool subtree) const;
+
     void paintEvent(QPaintEvent *e) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseDoubleClickEvent(QMouseEvent *event) override;
@@ -64,13 +121,19 @@ class TreeScrollArea : public QAbstractScrollArea
     /// center the x coordinate
     void centerPoint(int x, int y);
 
-    void setDebugMode(bool val) { debug_mode_ = val; }
+    /// Memory (in bytes) taken by the index used for drawing
+    size_t indexMemoryUsage() const;
+
+    void setDebugMode(bool val);
 
     void setScale(int val);
 
     void changeStartNode(NodeID nid);
     
     void setDarkMode(bool d);
+
+    /// Make sure `nid` is drawn anew (e.g. after its bookmark changed)
+    void invalidateNode(NodeID nid);
 };
 
 } // namespace tree
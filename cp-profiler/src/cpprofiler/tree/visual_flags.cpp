@@ -5,6 +5,9 @@ namespace cpprofiler
 namespace tree
 {
 
+/// Changes remembered individually (for `changesSince`)
+static constexpr size_t max_changes = 4096;
+
 void VisualFlags::ensure_id_exists(NodeID nid)
 {
     const auto id = static_cast<int>(nid);
@@ -16,9 +19,35 @@ void VisualFlags::ensure_id_exists(NodeID nid)
     }
 }
 
+void VisualFlags::recordChange(NodeID nid)
+{
+    if (changes_.size() == max_changes)
+    {
+        recordChangeAll();
+    }
+
+    changes_.push_back(nid);
+}
+
+void VisualFlags::recordChangeAll()
+{
+    changes_base_ += changes_.size() + 1;
+    changes_.clear();
+}
+
+bool VisualFlags::changesSince(size_t version, std::vector<NodeID> &nodes) const
+{
+    if (version < changes_base_)
+        return false;
+
+    nodes.insert(nodes.end(), changes_.begin() + (version - changes_base_), changes_.end());
+    return true;
+}
+
 void VisualFlags::setLabelShown(NodeID nid, bool val)
 {
     ensure_id_exists(nid);
+    recordChange(nid);
     label_shown_[nid] = val;
 }
 
@@ -33,6 +62,7 @@ bool VisualFlags::isLabelShown(NodeID nid) const
 void VisualFlags::setHidden(NodeID nid, bool val)
 {
     ensure_id_exists(nid);
+    recordChange(nid);
     node_hidden_[nid] = val;
 
     if (val)
@@ -54,6 +84,7 @@ bool VisualFlags::isHidden(NodeID nid) const
 
 void VisualFlags::unhideAll()
 {
+    recordChangeAll();
 
     for (auto &&n : node_hidden_)
     {
@@ -71,6 +102,7 @@ int VisualFlags::hiddenCount()
 void VisualFlags::setHighlighted(NodeID nid, bool val)
 {
     ensure_id_exists(nid);
+    recordChange(nid);
 
     if (val)
     {
@@ -98,6 +130,7 @@ void VisualFlags::unhighlightAll()
     for (auto nid : highlighted_shapes_)
     {
         shape_highlighted_[nid] = false;
+        recordChange(nid);
     }
 
     highlighted_shapes_.clear();
@@ -105,11 +138,13 @@ void VisualFlags::unhighlightAll()
 
 void VisualFlags::resetLanternSizes()
 {
+    recordChangeAll();
     lantern_sizes_.clear();
 }
 
 void VisualFlags::setLanternSize(NodeID nid, int val)
 {
+    recordChange(nid);
     lantern_sizes_.insert({nid, val});
 }
 
@@ -126,5 +161,16 @@ int VisualFlags::lanternSize(NodeID nid) const
     }
 }
 
+size_t VisualFlags::memoryUsage() const
+{
+    /// set/map nodes hold three pointers and a colour besides the value
+    constexpr size_t tree_node = 4 * sizeof(void *);
+
+    return (label_shown_.capacity() + node_hidden_.capacity() + shape_highlighted_.capacity()) / 8 +
+           (highlighted_shapes_.size() + hidden_nodes_.size()) * (tree_node + sizeof(NodeID)) +
+           changes_.capacity() * sizeof(NodeID) +
+           lantern_sizes_.size() * (tree_node + sizeof(NodeID) + sizeof(int));
+}
+
 } // namespace tree
 } // namespace cpprofiler
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "../core.hh"
 #include <set>
 #include <map>
+#include <vector>
 
 namespace cpprofiler
 {
@@ -27,8 +28,20 @@ class VisualFlags
 
     std::map<NodeID, int> lantern_sizes_;
 
+    /// The most recent changes (nodes whose flags were set), for views that
+    /// cache what they draw
+    std::vector<NodeID> changes_;
+
+    /// Number of changes made before the first one in `changes_`
+    size_t changes_base_ = 0;
+
     void ensure_id_exists(NodeID id);
 
+    void recordChange(NodeID nid);
+
+    /// Forget individual changes: everything should be considered changed
+    void recordChangeAll();
+
   public:
     void setLabelShown(NodeID nid, bool val);
     bool isLabelShown(NodeID nid) const;
@@ -47,6 +60,8 @@ class VisualFlags
     void setHighlighted(NodeID nid, bool val);
     bool isHighlighted(NodeID nid) const;
 
+    const std::set<NodeID> &highlighted_shapes() const { return highlighted_shapes_; }
+
     /// Remove all map entries about lantern sizes
     void resetLanternSizes();
     /// Insert a map entry for `nid` to hold `val` as its lantern size
@@ -55,6 +70,16 @@ class VisualFlags
     int lanternSize(NodeID nid) const;
 
     void unhighlightAll();
+
+    /// Number of changes made to the flags so far
+    size_t version() const { return changes_base_ + changes_.size(); }
+
+    /// Append the nodes whose flags changed since `version` to `nodes`;
+    /// returns false if these are no longer known
+    bool changesSince(size_t version, std::vector<NodeID> &nodes) const;
+
+    /// Memory (in bytes) taken by the flags
+    size_t memoryUsage() const;
 };
 
 } // namespace tree
@@ -4,12 +4,15 @@
 
 #include "utils/perf_helper.hh"
 #include "utils/debug.hh"
+#include "utils/work_stealing_pool.hh"
 #include "execution.hh"
 
 #include "tree/node_tree.hh"
 #include "name_map.hh"
 
+#include <algorithm>
 #include <thread>
+#include <unordered_map>
 
 namespace cpprofiler
 {
@@ -65,6 +68,10 @@ void TreeBuilder::startBuilding()
 
 void TreeBuilder::finishBuilding()
 {
+    /// other connections of a parallel solver may still be sending nodes
+    if (receivers_.fetch_sub(1) > 1)
+        return;
+
     perfHelper.end();
     print("Builder: done building");
     emit buildingDone();
@@ -73,8 +80,147 @@ void TreeBuilder::finishBuilding()
 void TreeBuilder::handleNode(const MessageWrapper& node)
 {
     // print("node: {}", *node);
-    auto& msg = node.msg();
+    auto &tree = m_execution.tree();
+
+    if (m_execution.degradation() == MemoryDegradation::STOPPED)
+        return;
+
+    auto staged = stageNode(node.msg());
+
+    utils::MutexLocker tree_lock(&tree.treeMutex(), "builder");
+
+    processNode(node.msg(), std::move(staged));
+
+    if (++nodes_since_check_ >= MEMORY_CHECK_INTERVAL)
+    {
+        nodes_since_check_ = 0;
+        m_execution.checkMemoryBudget();
+    }
+}
+
+void TreeBuilder::handleBatch(const MessageBatch& batch)
+{
+    auto &tree = m_execution.tree();
+
+    const auto &msgs = batch.msgs();
+
+    if (m_execution.degradation() == MemoryDegradation::STOPPED)
+        return;
+
+    auto staged = stageBatch(msgs);
+
+    utils::MutexLocker tree_lock(&tree.treeMutex(), "builder");
+
+    /// Nodes are added in the order they arrived, which guarantees
+    /// that parents are added before their children
+    for (size_t i = 0; i < msgs.size(); ++i)
+    {
+        processNode(msgs[i], std::move(staged[i]));
+    }
+
+    nodes_since_check_ += msgs.size();
+
+    if (nodes_since_check_ >= MEMORY_CHECK_INTERVAL)
+    {
+        nodes_since_check_ = 0;
+        m_execution.checkMemoryBudget();
+    }
+}
+
+TreeBuilder::StagedNode TreeBuilder::stageNode(const Message &msg) const
+{
+    StagedNode staged;
+
+    const auto nm = m_execution.nameMap();
+
+    if (msg.has_nogood() && nm)
+    {
+        /// Construct a renamed nogood using the name map
+        staged.renamed_nogood = nm->replaceNames(msg.nogood());
+    }
+
+    if (msg.has_info() && !msg.info().empty() && m_execution.degradation() < MemoryDegradation::NO_INFO)
+    {
+        staged.info = SolverData::parseInfo(msg.info());
+    }
+
+    return staged;
+}
+
+/// Threads staging the nodes of different solver threads in parallel
+/// (the builder thread counts as a worker); created once, as a batch
+/// takes about as long to stage as starting a thread does
+static utils::WorkStealingPool &staging_pool()
+{
+    static utils::WorkStealingPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+std::vector<TreeBuilder::StagedNode> TreeBuilder::stageBatch(const std::vector<Message> &msgs) const
+{
+    std::vector<StagedNode> staged(msgs.size());
+
+    const bool rename = m_execution.nameMap() != nullptr;
+
+    /// Indices of the messages that need staging, grouped by solver thread
+    std::unordered_map<int, std::vector<size_t>> shards_by_tid;
+
+    for (size_t i = 0; i < msgs.size(); ++i)
+    {
+        const auto &msg = msgs[i];
+
+        const bool has_work = (rename && msg.has_nogood()) ||
+                              (msg.has_info() && !msg.info().empty());
+
+        if (has_work)
+        {
+            shards_by_tid[msg.nodeUID().tid].push_back(i);
+        }
+    }
+
+    std::vector<std::vector<size_t>> shards;
+    shards.reserve(shards_by_tid.size());
+    for (auto &shard : shards_by_tid)
+    {
+        shards.push_back(std::move(shard.second));
+    }
+
+    /// Each shard only writes to its own elements of `staged`
+    const auto stage_shard = [&](const std::vector<size_t> &shard) {
+        for (const auto i : shard)
+        {
+            staged[i] = stageNode(msgs[i]);
+        }
+    };
+
+    /// Not worth handing work over to other threads for a sequential search
+    if (shards.size() <= 1)
+    {
+        for (const auto &shard : shards)
+        {
+            stage_shard(shard);
+        }
+        return staged;
+    }
+
+    {
+        /// this thread takes its share too while waiting
+        utils::WorkStealingPool::TaskGroup group(staging_pool());
 
+        for (const auto &shard : shards)
+        {
+            const auto *shard_ptr = &shard;
+            group.run([&stage_shard, shard_ptr]() { stage_shard(*shard_ptr); });
+        }
+
+        group.wait();
+    }
+
+    return staged;
+}
+
+void TreeBuilder::processNode(const Message &msg, StagedNode &&staged)
+{
     const auto n_uid = msg.nodeUID();
     const auto p_uid = msg.parentUID();
 
@@ -91,43 +237,41 @@ void TreeBuilder::handleNode(const MessageWrapper& node)
     const auto kids = msg.kids();
     const auto alt = msg.alt();
     const auto status = static_cast<tree::NodeStatus>(msg.status());
-    const auto &label = msg.has_label() ? msg.label() : tree::emptyLabel;
+    const auto degradation = m_execution.degradation();
+    const bool keep_label = msg.has_label() && degradation < MemoryDegradation::NO_LABELS;
+    const auto &label = keep_label ? msg.label() : tree::emptyLabel;
 
     NodeID nid;
 
+    if (pid == NodeID::NoNode)
     {
-        utils::MutexLocker tree_lock(&tree.treeMutex(), "builder");
 
-        if (pid == NodeID::NoNode)
+        if (m_execution.doesRestarts())
         {
-
-            if (m_execution.doesRestarts())
-            {
-                tree.addExtraChild(NodeID{0});
-                nid = tree.promoteNode(NodeID{0}, restart_count++, kids, status, label);
-            }
-            else
-            {
-                nid = tree.createRoot(kids);
-            }
+            tree.addExtraChild(NodeID{0});
+            nid = tree.promoteNode(NodeID{0}, restart_count++, kids, status, label);
         }
         else
         {
-            nid = tree.promoteNode(pid, alt, kids, status, label);
+            nid = tree.createRoot(kids);
         }
     }
+    else
+    {
+        nid = tree.promoteNode(pid, alt, kids, status, label);
+    }
+
+    /// the tree is already done (see `NodeTree::refuseFrozen`)
+    if (nid == NodeID::NoNode)
+        return;
 
     m_execution.solver_data().setNodeId({n_uid.nid, n_uid.rid, n_uid.tid}, nid);
 
     if (msg.has_nogood())
     {
-        const auto nm = m_execution.nameMap();
-
-        if (nm)
+        if (m_execution.nameMap())
         {
-            /// Construct a renamed nogood using the name map
-            const auto renamed = m_execution.nameMap()->replaceNames(msg.nogood());
-            m_execution.solver_data().setNogood(nid, msg.nogood(), renamed);
+            m_execution.solver_data().setNogood(nid, msg.nogood(), staged.renamed_nogood);
         }
         else
         {
@@ -135,9 +279,9 @@ void TreeBuilder::handleNode(const MessageWrapper& node)
         }
     }
 
-    if (msg.has_info() && !msg.info().empty())
+    if (msg.has_info() && !msg.info().empty() && degradation < MemoryDegradation::NO_INFO)
     {
-        m_execution.solver_data().processInfo(nid, msg.info());
+        m_execution.solver_data().setParsedInfo(nid, msg.info(), std::move(staged.info));
     }
 }
 
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "message_wrapper.hh"
+#include "solver_data.hh"
 #include <QObject>
+#include <atomic>
+#include <vector>
 
 namespace cpprofiler
 {
@@ -19,15 +22,49 @@ class TreeBuilder : public QObject
     /// (e.g. Chuffed doesn't do that)
     int restart_count = 0;
 
+    /// Connections feeding this builder that haven't finished yet
+    std::atomic<int> receivers_{0};
+
+    /// How often (in nodes) the execution's memory budget is checked
+    static constexpr size_t MEMORY_CHECK_INTERVAL = 16 * 1024;
+
+    /// Nodes added since the memory budget was last checked
+    size_t nodes_since_check_ = 0;
+
+    /// Per-node work that doesn't touch the tree (renaming nogoods, parsing info),
+    /// done before the tree mutex is acquired
+    struct StagedNode
+    {
+        std::string renamed_nogood;
+        SolverData::ParsedInfo info;
+    };
+
+    /// Prepare `msg` for being added to the tree; safe to call from any thread
+    StagedNode stageNode(const cpprofiler::Message &msg) const;
+
+    /// Stage all nodes in `msgs`, one shard per solver thread (NodeUID.tid),
+    /// with shards processed in parallel
+    std::vector<StagedNode> stageBatch(const std::vector<cpprofiler::Message> &msgs) const;
+
+    /// Add node described by `msg` to the tree; the caller must hold the tree mutex
+    void processNode(const cpprofiler::Message &msg, StagedNode &&staged);
+
   public:
     TreeBuilder(Execution &ex);
 
     void startBuilding();
 
+    /// Expect one more connection to call `finishBuilding` (safe to call from any thread)
+    void addReceiver() { receivers_.fetch_add(1); }
+
+    /// One of the connections is done; building is done once all of them are
     void finishBuilding();
 
     void handleNode(const cpprofiler::MessageWrapper& node);
 
+    /// Add all nodes in `batch` acquiring the tree mutex only once
+    void handleBatch(const cpprofiler::MessageBatch& batch);
+
   signals:
 
     void buildingDone();
@@ -0,0 +1,173 @@
+#include "pod_vector.hh"
+
+#include "debug.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+static std::string &storage_dir()
+{
+    static std::string dir;
+    return dir;
+}
+
+void set_mapped_storage_dir(const std::string &dir)
+{
+    storage_dir() = dir;
+}
+
+const std::string &mapped_storage_dir()
+{
+    return storage_dir();
+}
+
+#ifndef WIN32
+
+/// Mapped files grow in steps of at least this many bytes
+static constexpr size_t MAPPED_CHUNK = 1 << 20;
+
+/// Create an anonymous file in `dir` (removed from the directory straight away,
+/// so that it goes away with the process); returns -1 on failure
+static int create_backing_file(const std::string &dir)
+{
+    std::string path = dir + "/cpprofiler-XXXXXX";
+
+    const int fd = mkstemp(&path[0]);
+
+    if (fd == -1)
+    {
+        print("warning: could not create a file in {}, keeping tree data in memory", dir);
+        return -1;
+    }
+
+    unlink(path.c_str());
+    return fd;
+}
+
+#endif
+
+RawStorage::RawStorage()
+{
+#ifndef WIN32
+    if (!mapped_storage_dir().empty())
+    {
+        fd_ = create_backing_file(mapped_storage_dir());
+    }
+#endif
+}
+
+RawStorage::~RawStorage()
+{
+    release();
+}
+
+void RawStorage::release()
+{
+#ifndef WIN32
+    if (fd_ != -1)
+    {
+        if (data_)
+            munmap(data_, bytes_);
+        close(fd_);
+        fd_ = -1;
+        data_ = nullptr;
+        bytes_ = 0;
+        return;
+    }
+#endif
+
+    free(data_);
+    data_ = nullptr;
+    bytes_ = 0;
+}
+
+RawStorage::RawStorage(RawStorage &&other)
+    : data_(other.data_), bytes_(other.bytes_), fd_(other.fd_)
+{
+    other.data_ = nullptr;
+    other.bytes_ = 0;
+    other.fd_ = -1;
+}
+
+RawStorage &RawStorage::operator=(RawStorage &&other)
+{
+    if (this != &other)
+    {
+        release();
+        data_ = other.data_;
+        bytes_ = other.bytes_;
+        fd_ = other.fd_;
+        other.data_ = nullptr;
+        other.bytes_ = 0;
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+void RawStorage::grow(size_t bytes)
+{
+    if (bytes <= bytes_)
+        return;
+
+#ifndef WIN32
+    if (fd_ != -1)
+    {
+        bytes = (bytes + MAPPED_CHUNK - 1) / MAPPED_CHUNK * MAPPED_CHUNK;
+
+        if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0)
+        {
+            throw std::bad_alloc();
+        }
+
+        void *mem = MAP_FAILED;
+
+        /// on failure, the old mapping is left as it is (and still in use)
+#ifdef MREMAP_MAYMOVE
+        if (data_)
+            mem = mremap(data_, bytes_, bytes, MREMAP_MAYMOVE);
+        else
+#endif
+        {
+            /// the new mapping shows the same file, so the old one can only
+            /// go once the new one exists
+            mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+
+            if (mem != MAP_FAILED && data_)
+                munmap(data_, bytes_);
+        }
+
+        if (mem == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+
+        data_ = static_cast<char *>(mem);
+        bytes_ = bytes;
+        return;
+    }
+#endif
+
+    auto mem = static_cast<char *>(realloc(data_, bytes));
+
+    if (!mem)
+    {
+        throw std::bad_alloc();
+    }
+
+    data_ = mem;
+    bytes_ = bytes;
+}
+
+} // namespace utils
+} // namespace cpprofiler
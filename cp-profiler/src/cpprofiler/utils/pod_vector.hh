@@ -0,0 +1,149 @@
+#ifndef CPPROFILER_UTILS_POD_VECTOR_HH
+#define CPPROFILER_UTILS_POD_VECTOR_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// Directory for memory-mapped storage of tree data; an empty string
+/// (the default) keeps everything on the heap. Only affects vectors
+/// created after the call.
+void set_mapped_storage_dir(const std::string &dir);
+
+const std::string &mapped_storage_dir();
+
+/// A growable block of raw memory, either on the heap or in a file
+/// (deleted as soon as it is created) mapped into memory; the latter
+/// lets the OS write cold pages back to disk instead of running out of RAM
+class RawStorage
+{
+    char *data_ = nullptr;
+
+    size_t bytes_ = 0;
+
+    /// File backing the memory (-1 if on the heap)
+    int fd_ = -1;
+
+    void release();
+
+  public:
+    /// Mapped if `mapped_storage_dir()` is set (and a file can be created there)
+    RawStorage();
+    ~RawStorage();
+
+    RawStorage(const RawStorage &) = delete;
+    RawStorage &operator=(const RawStorage &) = delete;
+
+    RawStorage(RawStorage &&other);
+    RawStorage &operator=(RawStorage &&other);
+
+    /// Make the block at least `bytes` long, preserving its content
+    void grow(size_t bytes);
+
+    char *data() const { return data_; }
+
+    size_t bytes() const { return bytes_; }
+
+    bool isMapped() const { return fd_ != -1; }
+};
+
+/// A vector of trivially copyable elements stored in `RawStorage`,
+/// i.e. in memory-mapped files if `mapped_storage_dir()` is set;
+/// provides the subset of std::vector used for tree data
+template <typename T>
+class PodVector
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "PodVector moves its elements as raw bytes");
+
+    RawStorage storage_;
+
+    size_t size_ = 0;
+
+    T *ptr() const { return reinterpret_cast<T *>(storage_.data()); }
+
+  public:
+    PodVector() = default;
+
+    PodVector(PodVector &&other) : storage_(std::move(other.storage_)), size_(other.size_)
+    {
+        other.size_ = 0;
+    }
+
+    PodVector &operator=(PodVector &&other)
+    {
+        if (this != &other)
+        {
+            storage_ = std::move(other.storage_);
+            size_ = other.size_;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    size_t capacity() const { return storage_.bytes() / sizeof(T); }
+
+    bool isMapped() const { return storage_.isMapped(); }
+
+    void reserve(size_t n)
+    {
+        if (n > capacity())
+            storage_.grow(n * sizeof(T));
+    }
+
+    void resize(size_t n, const T &value = T())
+    {
+        if (n > capacity())
+            reserve(std::max(n, capacity() * 2));
+        if (n > size_)
+            std::fill(ptr() + size_, ptr() + n, value);
+        size_ = n;
+    }
+
+    void push_back(const T &value)
+    {
+        if (size_ == capacity())
+            reserve(std::max<size_t>(16, capacity() * 2));
+        ptr()[size_++] = value;
+    }
+
+    /// Add `n` elements starting at `values` to the end
+    void append(const T *values, size_t n)
+    {
+        if (size_ + n > capacity())
+            reserve(std::max(size_ + n, capacity() * 2));
+        std::copy(values, values + n, ptr() + size_);
+        size_ += n;
+    }
+
+    void clear() { size_ = 0; }
+
+    T &operator[](size_t i) { return ptr()[i]; }
+    const T &operator[](size_t i) const { return ptr()[i]; }
+
+    T &back() { return ptr()[size_ - 1]; }
+    const T &back() const { return ptr()[size_ - 1]; }
+
+    T *data() { return ptr(); }
+    const T *data() const { return ptr(); }
+
+    T *begin() { return ptr(); }
+    T *end() { return ptr() + size_; }
+    const T *begin() const { return ptr(); }
+    const T *end() const { return ptr() + size_; }
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
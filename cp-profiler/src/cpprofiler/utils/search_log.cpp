@@ -0,0 +1,79 @@
+#include "search_log.hh"
+
+#include "tree_utils.hh"
+#include "debug.hh"
+#include "../tree/node_tree.hh"
+
+#include <sstream>
+#include <QFile>
+#include <QTextStream>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+void save_search(const tree::NodeTree &nt, const char *path)
+{
+
+    const auto order = pre_order(nt);
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        print("Error: could not open \"{}\" to save search", path);
+        return;
+    }
+
+    QTextStream file_stream(&file);
+
+    for (auto nid : order)
+    {
+
+        /// Making sure undefined/skipped nodes are not logged
+        {
+            const auto status = nt.getStatus(nid);
+            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
+                continue;
+        }
+
+        // Note: not every child is logged (SKIPPED and UNDET are not)
+        int kids_logged = 0;
+
+        /// Note: this temporary stream is used so that children can be
+        /// traversed first, counted, but logged after their parent
+        std::stringstream children_stream;
+
+        const auto kids = nt.childrenCount(nid);
+
+        for (auto alt = 0; alt < kids; alt++)
+        {
+
+            const auto kid = nt.getChild(nid, alt);
+
+            /// Making sure undefined/skipped children are not logged
+            const auto status = nt.getStatus(kid);
+            if (status == tree::NodeStatus::SKIPPED || status == tree::NodeStatus::UNDETERMINED)
+                continue;
+
+            ++kids_logged;
+            /// TODO: use original names in labels
+            const auto label = nt.getLabel(kid);
+
+            children_stream << " " << kid << " " << label;
+        }
+
+        file_stream << nid << " " << kids_logged;
+
+        /// Unexplored node on the left branch (search timed out)
+        if ((kids == 0) && (nt.getStatus(nid) == tree::NodeStatus::BRANCH))
+        {
+            file_stream << " stop";
+        }
+
+        file_stream << children_stream.str().c_str() << '\n';
+    }
+}
+
+} // namespace utils
+} // namespace cpprofiler
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace cpprofiler
+{
+namespace tree
+{
+class NodeTree;
+}
+} // namespace cpprofiler
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// Write the search (every node with its logged children and their labels,
+/// in pre-order) to `path`, one node per line
+void save_search(const tree::NodeTree &nt, const char *path);
+
+} // namespace utils
+} // namespace cpprofiler
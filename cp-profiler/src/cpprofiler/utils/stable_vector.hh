@@ -0,0 +1,200 @@
+#ifndef CPPROFILER_UTILS_STABLE_VECTOR_HH
+#define CPPROFILER_UTILS_STABLE_VECTOR_HH
+
+#include "pod_vector.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// Index of the highest set bit of `x` (`x` > 0)
+inline unsigned highest_bit(uint64_t x)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanReverse64(&idx, x);
+    return static_cast<unsigned>(idx);
+#else
+    return 63 - static_cast<unsigned>(__builtin_clzll(x));
+#endif
+}
+
+/// An element that one thread writes while others may read it: every access
+/// is a relaxed atomic operation, so readers see either the old or the new value
+///
+/// Unlike `std::atomic`, it can be copied (e.g. into a `StableVector`); a copy
+/// is a relaxed load of the source followed by a relaxed store.
+template <typename T>
+class RelaxedAtomic
+{
+    std::atomic<T> value_;
+
+  public:
+    RelaxedAtomic(T value = T()) : value_(value) {}
+
+    RelaxedAtomic(const RelaxedAtomic &other) : value_(other.load()) {}
+
+    RelaxedAtomic &operator=(const RelaxedAtomic &other)
+    {
+        store(other.load());
+        return *this;
+    }
+
+    RelaxedAtomic &operator=(T value)
+    {
+        store(value);
+        return *this;
+    }
+
+    T load() const { return value_.load(std::memory_order_relaxed); }
+
+    void store(T value) { value_.store(value, std::memory_order_relaxed); }
+
+    operator T() const { return load(); }
+
+    /// Read-modify-write helpers for the (single) writer; not atomic as a whole
+    RelaxedAtomic &operator++()
+    {
+        store(load() + 1);
+        return *this;
+    }
+
+    RelaxedAtomic &operator--()
+    {
+        store(load() - 1);
+        return *this;
+    }
+};
+
+/// A vector of trivially destructible elements that never move once added
+///
+/// Elements live in chunks of doubling size (memory-mapped like `PodVector`
+/// if `mapped_storage_dir()` is set), so growing never relocates anything.
+/// One thread may append and write elements while other threads read
+/// elements below a size they obtained from `size()`: a reader may see
+/// an element written concurrently either before or after the write,
+/// but never freed memory.
+template <typename T>
+class StableVector
+{
+    /// The first chunk holds 2^FIRST_BITS elements, each next one twice as many
+    static constexpr unsigned FIRST_BITS = 6;
+    static constexpr unsigned MAX_CHUNKS = 40;
+
+    /// Start of each chunk, published to readers
+    std::atomic<T *> chunks_[MAX_CHUNKS];
+
+    /// Memory of each chunk (only touched by the writer)
+    std::vector<RawStorage> storage_;
+
+    std::atomic<size_t> size_;
+
+    /// Total number of elements in all chunks
+    size_t capacity_ = 0;
+
+    static unsigned chunkOf(size_t i)
+    {
+        return highest_bit(i + (size_t(1) << FIRST_BITS)) - FIRST_BITS;
+    }
+
+    static size_t offsetIn(size_t i, unsigned chunk)
+    {
+        return i + (size_t(1) << FIRST_BITS) - (size_t(1) << (chunk + FIRST_BITS));
+    }
+
+    void addChunk()
+    {
+        const auto chunk = static_cast<unsigned>(storage_.size());
+
+        if (chunk == MAX_CHUNKS)
+            throw std::length_error("StableVector is full");
+
+        const auto elements = size_t(1) << (chunk + FIRST_BITS);
+
+        RawStorage storage;
+        storage.grow(elements * sizeof(T));
+
+        chunks_[chunk].store(reinterpret_cast<T *>(storage.data()), std::memory_order_release);
+        storage_.push_back(std::move(storage));
+        capacity_ += elements;
+    }
+
+  public:
+    StableVector() : size_(0)
+    {
+        for (auto &chunk : chunks_)
+            chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    StableVector(const StableVector &) = delete;
+    StableVector &operator=(const StableVector &) = delete;
+
+    /// Number of elements; elements below it are safe to read from any thread
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+
+    size_t capacity() const { return capacity_; }
+
+    void reserve(size_t n)
+    {
+        while (capacity_ < n)
+            addChunk();
+    }
+
+    void push_back(const T &value)
+    {
+        const auto n = size_.load(std::memory_order_relaxed);
+        reserve(n + 1);
+        new (&(*this)[n]) T(value);
+        size_.store(n + 1, std::memory_order_release);
+    }
+
+    void resize(size_t n, const T &value = T())
+    {
+        reserve(n);
+        for (auto i = size_.load(std::memory_order_relaxed); i < n; ++i)
+            new (&(*this)[i]) T(value);
+        size_.store(n, std::memory_order_release);
+    }
+
+    T &operator[](size_t i)
+    {
+        const auto chunk = chunkOf(i);
+        return chunks_[chunk].load(std::memory_order_acquire)[offsetIn(i, chunk)];
+    }
+
+    const T &operator[](size_t i) const
+    {
+        const auto chunk = chunkOf(i);
+        return chunks_[chunk].load(std::memory_order_acquire)[offsetIn(i, chunk)];
+    }
+
+    /// Like `operator[]`, but throws std::out_of_range unless `i < size()`
+    const T &at(size_t i) const
+    {
+        if (i >= size())
+            throw std::out_of_range("StableVector::at");
+        return (*this)[i];
+    }
+};
+
+template <typename T>
+constexpr unsigned StableVector<T>::FIRST_BITS;
+
+template <typename T>
+constexpr unsigned StableVector<T>::MAX_CHUNKS;
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
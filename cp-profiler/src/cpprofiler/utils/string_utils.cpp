@@ -41,5 +41,22 @@ string join(const vector<string>& strs, char sep) {
     return ss.str();
 }
 
+string numbered_path(const string &path, int n)
+{
+    if (n == 0)
+        return path;
+
+    const auto dot = path.rfind('.');
+    const auto slash = path.find_last_of("/\\");
+    const bool has_ext = dot != string::npos && (slash == string::npos || dot > slash);
+
+    const auto suffix = "-" + std::to_string(n);
+
+    if (!has_ext)
+        return path + suffix;
+
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
 } // namespace utils
 } // namespace cpprofiler
\ No newline at end of file
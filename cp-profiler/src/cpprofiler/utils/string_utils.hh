@@ -8,5 +8,8 @@ namespace utils
 
 std::vector<std::string> split(const std::string &str, char delim, bool include_empty = false);
 std::string join(const std::vector<std::string>& strs, char sep);
+
+/// `path` with "-<n>" inserted before the extension (`path` itself for n = 0)
+std::string numbered_path(const std::string &path, int n);
 }
 } // namespace cpprofiler
\ No newline at end of file
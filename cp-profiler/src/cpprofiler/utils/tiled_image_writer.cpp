@@ -0,0 +1,68 @@
+#include "tiled_image_writer.hh"
+
+#include "debug.hh"
+
+#include <QImage>
+
+#include <algorithm>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+TiledImageWriter::TiledImageWriter(std::string path, QSize size, int tile_size)
+    : path_(std::move(path)), size_(size), tile_size_(tile_size)
+{
+}
+
+int TiledImageWriter::rows() const
+{
+    return (size_.height() + tile_size_ - 1) / tile_size_;
+}
+
+int TiledImageWriter::columns() const
+{
+    return (size_.width() + tile_size_ - 1) / tile_size_;
+}
+
+QRect TiledImageWriter::tileRect(int row, int col) const
+{
+    const int x = col * tile_size_;
+    const int y = row * tile_size_;
+
+    return QRect(x, y, std::min(tile_size_, size_.width() - x), std::min(tile_size_, size_.height() - y));
+}
+
+std::string TiledImageWriter::tilePath(int row, int col) const
+{
+    if (rows() == 1 && columns() == 1)
+        return path_;
+
+    const auto dot = path_.rfind('.');
+    const auto slash = path_.find_last_of("/\\");
+    const bool has_ext = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+
+    const auto suffix = "-r" + std::to_string(row) + "-c" + std::to_string(col);
+
+    if (!has_ext)
+        return path_ + suffix;
+
+    return path_.substr(0, dot) + suffix + path_.substr(dot);
+}
+
+bool TiledImageWriter::write(int row, int col, const QImage &image) const
+{
+    const auto path = tilePath(row, col);
+
+    if (!image.save(path.c_str()))
+    {
+        print("Error: could not save image tile to \"{}\"", path);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace utils
+} // namespace cpprofiler
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QRect>
+#include <QSize>
+
+#include <string>
+
+class QImage;
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// Saves an image too large to be kept in memory as a grid of tiles, each
+/// an image file of its own, so that only one tile needs to exist at a time
+///
+/// An image that fits in a single tile is saved to `path` itself; otherwise
+/// the tile in row `r` and column `c` goes to `path` with "-r<r>-c<c>"
+/// inserted before the extension (e.g. tree-r0-c3.png).
+class TiledImageWriter
+{
+    std::string path_;
+
+    QSize size_;
+
+    int tile_size_;
+
+  public:
+    /// Width and height of a tile (in pixels) unless specified otherwise;
+    /// an RGB32 tile of this size takes 64MB
+    static constexpr int DEFAULT_TILE_SIZE = 4096;
+
+    TiledImageWriter(std::string path, QSize size, int tile_size = DEFAULT_TILE_SIZE);
+
+    int rows() const;
+
+    int columns() const;
+
+    /// Part of the whole image covered by the tile at (`row`, `col`)
+    QRect tileRect(int row, int col) const;
+
+    /// File the tile at (`row`, `col`) is saved to
+    std::string tilePath(int row, int col) const;
+
+    /// Save `image` (sized as `tileRect(row, col)`) as the tile at (`row`, `col`)
+    bool write(int row, int col, const QImage &image) const;
+};
+
+} // namespace utils
+} // namespace cpprofiler
@@ -2,6 +2,7 @@
 #include <stack>
 #include <exception>
 #include "../tree/node_tree.hh"
+#include "../tree/frozen_structure.hh"
 
 using namespace cpprofiler::tree;
 
@@ -17,6 +18,9 @@ int count_descendants(const NodeTree &nt, NodeID nid)
     if (nid == NodeID::NoNode)
         return 0;
 
+    if (const auto frozen = nt.frozen())
+        return frozen->subtreeSize(nid);
+
     int count = 0;
 
     auto fun = [&count](NodeID n) {
@@ -47,6 +51,12 @@ std::vector<NodeID> nodes_below(const tree::NodeTree &nt, NodeID nid)
         throw std::exception();
     }
 
+    if (const auto frozen = nt.frozen())
+    {
+        const auto range = frozen->subtree(nid);
+        return std::vector<NodeID>(range.begin(), range.end());
+    }
+
     std::vector<NodeID> nodes;
 
     std::stack<NodeID> stk;
@@ -77,6 +87,15 @@ void apply_below(const NodeTree &nt, NodeID nid, const NodeAction &action)
         throw std::exception();
     }
 
+    if (const auto frozen = nt.frozen())
+    {
+        for (auto n : frozen->subtree(nid))
+        {
+            action(n);
+        }
+        return;
+    }
+
     auto nodes = nodes_below(nt, nid);
 
     for (auto n : nodes)
@@ -87,6 +106,15 @@ void apply_below(const NodeTree &nt, NodeID nid, const NodeAction &action)
 
 void pre_order_apply(const tree::NodeTree &nt, NodeID start, const NodeAction &action)
 {
+    if (const auto frozen = nt.frozen())
+    {
+        for (auto n : frozen->subtree(start))
+        {
+            action(n);
+        }
+        return;
+    }
+
     std::stack<NodeID> stk;
 
     stk.push(start);
@@ -121,6 +149,12 @@ bool is_right_most_child(const tree::NodeTree &nt, NodeID nid)
 
 std::vector<NodeID> pre_order(const NodeTree &tree)
 {
+    if (const auto frozen = tree.frozen())
+    {
+        const auto range = frozen->preorder();
+        return std::vector<NodeID>(range.begin(), range.end());
+    }
+
     std::stack<NodeID> stk;
     std::vector<NodeID> result;
 
@@ -195,6 +229,15 @@ std::vector<int> calc_subtree_sizes(const tree::NodeTree &nt)
 
     std::vector<int> sizes(nc);
 
+    if (const auto frozen = nt.frozen())
+    {
+        for (auto n = 0; n < nc; ++n)
+        {
+            sizes[n] = frozen->subtreeSize(NodeID{n});
+        }
+        return sizes;
+    }
+
     std::function<void(NodeID)> countDescendants;
 
     /// Count descendants plus one (the node itself)
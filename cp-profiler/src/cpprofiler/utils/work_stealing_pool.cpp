@@ -0,0 +1,177 @@
+#include "work_stealing_pool.hh"
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// The pool and queue index of the current thread if it is a worker
+static thread_local const WorkStealingPool *current_pool = nullptr;
+static thread_local size_t current_queue = 0;
+
+WorkStealingPool::WorkStealingPool(unsigned threads) : queued_(0), stop_(false)
+{
+    for (unsigned i = 0; i <= threads; ++i)
+    {
+        queues_.emplace_back(new Queue);
+    }
+
+    threads_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        threads_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        stop_ = true;
+    }
+    idle_cv_.notify_all();
+
+    for (auto &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+size_t WorkStealingPool::ownQueue() const
+{
+    return current_pool == this ? current_queue : queues_.size() - 1;
+}
+
+void WorkStealingPool::push(Task task)
+{
+    auto &queue = *queues_[ownQueue()];
+
+    /// counted before it can be taken, so that `queued_` never goes negative
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        ++queued_;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    idle_cv_.notify_one();
+}
+
+bool WorkStealingPool::tryPop(Task &task)
+{
+    if (queued_.load() == 0)
+        return false;
+
+    const auto own = ownQueue();
+
+    /// newest task of our own queue
+    {
+        auto &queue = *queues_[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --queued_;
+            return true;
+        }
+    }
+
+    /// oldest task of somebody else's
+    for (size_t i = 1; i < queues_.size(); ++i)
+    {
+        auto &queue = *queues_[(own + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            --queued_;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+
+    Task task;
+
+    while (true)
+    {
+        if (tryPop(task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_cv_.wait(lock, [this]() { return stop_ || queued_.load() > 0; });
+
+        if (stop_)
+            return;
+    }
+}
+
+void WorkStealingPool::TaskGroup::run(Task task)
+{
+    ++pending_;
+
+    pool_.push([this, task]() {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_)
+                error_ = std::current_exception();
+        }
+
+        --pending_;
+    });
+}
+
+void WorkStealingPool::TaskGroup::wait()
+{
+    waitAll();
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        std::swap(error, error_);
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void WorkStealingPool::TaskGroup::waitAll()
+{
+    Task task;
+
+    while (pending_.load() > 0)
+    {
+        if (pool_.tryPop(task))
+        {
+            task();
+            task = nullptr;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace utils
+} // namespace cpprofiler
@@ -0,0 +1,109 @@
+#ifndef CPPROFILER_UTILS_WORK_STEALING_POOL_HH
+#define CPPROFILER_UTILS_WORK_STEALING_POOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cpprofiler
+{
+namespace utils
+{
+
+/// A fixed set of worker threads executing fork-join tasks
+///
+/// Every worker has its own deque: it runs its latest tasks first (LIFO,
+/// good for locality in recursive algorithms) while idle workers steal the
+/// oldest ones, i.e. the biggest pieces of work, from the other end. A thread
+/// waiting for a `TaskGroup` runs queued tasks instead of blocking, so tasks
+/// may themselves spawn and wait for subtasks.
+class WorkStealingPool
+{
+  public:
+    using Task = std::function<void()>;
+
+  private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /// One queue per worker plus one shared by all other threads (the last one)
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    std::vector<std::thread> threads_;
+
+    /// Number of tasks sitting in the queues
+    std::atomic<int> queued_;
+
+    std::atomic<bool> stop_;
+
+    /// Idle workers sleep on this until there are tasks
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+
+    /// Index of the calling thread's queue
+    size_t ownQueue() const;
+
+    void push(Task task);
+
+    /// Take a task from the caller's queue or steal one from the others
+    bool tryPop(Task &task);
+
+    void workerLoop(size_t index);
+
+  public:
+    /// Tasks submitted together; `wait` returns once all of them are done
+    ///
+    /// A task that throws still counts as done; the first exception thrown
+    /// by any of the tasks is rethrown by `wait`.
+    class TaskGroup
+    {
+        WorkStealingPool &pool_;
+        std::atomic<int> pending_;
+
+        /// First exception thrown by a task (not yet rethrown)
+        std::exception_ptr error_;
+        std::mutex error_mutex_;
+
+        /// Wait for all tasks without rethrowing their exceptions
+        void waitAll();
+
+      public:
+        explicit TaskGroup(WorkStealingPool &pool) : pool_(pool), pending_(0) {}
+
+        TaskGroup(const TaskGroup &) = delete;
+        TaskGroup &operator=(const TaskGroup &) = delete;
+
+        /// Waits for the tasks, but drops their exceptions (see `wait`)
+        ~TaskGroup() { waitAll(); }
+
+        void run(Task task);
+
+        /// Wait for all tasks of the group, executing queued tasks meanwhile
+        void wait();
+    };
+
+    /// Start `threads` workers (none if `threads` is 0: tasks then run
+    /// in whichever thread waits for them)
+    explicit WorkStealingPool(unsigned threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /// Number of worker threads
+    unsigned size() const { return static_cast<unsigned>(threads_.size()); }
+};
+
+} // namespace utils
+} // namespace cpprofiler
+
+#endif
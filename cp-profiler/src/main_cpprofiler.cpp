@@ -1,14 +1,33 @@
 #include <iostream>
+#include <cstring>
+#include <memory>
 
 #include <QApplication>
 
 #include "cpprofiler/command_line_parser.hh"
 #include "cpprofiler/conductor.hh"
+#include "cpprofiler/headless_runner.hh"
 #include "cpprofiler/options.hh"
 
 #include "cpprofiler/tests/tree_test.hh"
 #include "cpprofiler/tests/execution_test.hh"
+#include "cpprofiler/tests/benchmarks.hh"
 #include "cpprofiler/utils/debug.hh"
+#include "cpprofiler/utils/pod_vector.hh"
+#include "cpprofiler/tree/layout_computer.hh"
+
+/// The application type has to be chosen before the command line is parsed
+static bool option_given(int argc, char *argv[], const char *option)
+{
+    const auto len = std::strlen(option);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], option, len) == 0 && (argv[i][len] == '\0' || argv[i][len] == '='))
+            return true;
+    }
+    return false;
+}
 
 int main(int argc, char *argv[])
 {
@@ -19,11 +38,31 @@ int main(int argc, char *argv[])
     QGL::setPreferredPaintEngine(QPaintEngine::OpenGL);
 #endif
 
-    QApplication app(argc, argv);
+    const bool headless = option_given(argc, argv, "--headless");
+
+    /// no widgets (or display) are needed when running headless
+    std::unique_ptr<QCoreApplication> app;
+    if (headless && option_given(argc, argv, "--save_tree_image"))
+    {
+        /// drawing the tree takes a GUI application, but not a display
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        app.reset(new QGuiApplication(argc, argv));
+    }
+    else if (headless)
+    {
+        app.reset(new QCoreApplication(argc, argv));
+    }
+    else
+    {
+        app.reset(new QApplication(argc, argv));
+    }
     QCoreApplication::setApplicationName("CP-Profiler");
 
     CommandLineParser cl_parser;
-    cl_parser.process(app);
+    cl_parser.process(*app);
 
     Options options;
 
@@ -63,13 +102,75 @@ int main(int argc, char *argv[])
         options.pixel_tree_compression = cs.toInt();
     }
 
+    if (cl_parser.isSet(cl_options::save_tree_image))
+    {
+        options.save_tree_image_path = cl_parser.value(cl_options::save_tree_image).toStdString();
+    }
+
+    if (cl_parser.isSet(cl_options::tree_image_scale))
+    {
+        options.tree_image_scale = cl_parser.value(cl_options::tree_image_scale).toFloat();
+    }
+
+    if (cl_parser.isSet(cl_options::record))
+    {
+        options.record_path = cl_parser.value(cl_options::record).toStdString();
+    }
+
+    if (cl_parser.isSet(cl_options::replay))
+    {
+        options.replay_path = cl_parser.value(cl_options::replay).toStdString();
+    }
+
+    if (cl_parser.isSet(cl_options::replay_speed))
+    {
+        options.replay_speed = cl_parser.value(cl_options::replay_speed).toDouble();
+    }
+
+    if (cl_parser.isSet(cl_options::max_executions))
+    {
+        options.max_executions = cl_parser.value(cl_options::max_executions).toInt();
+    }
+
+    if (cl_parser.isSet(cl_options::idle_timeout))
+    {
+        options.idle_timeout = cl_parser.value(cl_options::idle_timeout).toInt();
+    }
+
+    if (cl_parser.isSet(cl_options::memory_budget))
+    {
+        options.memory_budget = cl_parser.value(cl_options::memory_budget).toInt();
+    }
+
+    if (cl_parser.isSet(cl_options::node_store))
+    {
+        options.node_store_dir = cl_parser.value(cl_options::node_store).toStdString();
+        print("storing tree data in: {}", options.node_store_dir);
+        utils::set_mapped_storage_dir(options.node_store_dir);
+    }
+
+    if (cl_parser.isSet(cl_options::layout_threads))
+    {
+        options.layout_threads = cl_parser.value(cl_options::layout_threads).toInt();
+        tree::set_layout_threads(options.layout_threads);
+    }
+
+    if (headless)
+    {
+        options.headless = true;
+        HeadlessRunner runner(std::move(options));
+        return app->exec();
+    }
+
     Conductor conductor(std::move(options));
 
     conductor.show();
 
     tests::execution::run(conductor);
 
-    return app.exec();
+    tests::benchmarks::run();
+
+    return app->exec();
 }
 
 /// Threads